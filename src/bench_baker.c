@@ -0,0 +1,154 @@
+/**
+ * @file bench_baker.c
+ * @brief Mikrobenchmark losowania partii piekarza: rand() vs Rng watku.
+ *
+ * Odtwarza decyzje production_thread() bez usleep i podajnika: przerwa,
+ * liczba rodzajow, produkt wedlug wag katalogu, wielkosc partii. Watki
+ * losuja:
+ *   rand() - dawny kod: wspolny stan procesu, blokada w glibc przy kazdym
+ *            wywolaniu, modulo,
+ *   Rng    - wlasny stan xoshiro256** watku (rng.h), rng_bake_delay_ms /
+ *            rng_bake_batch, bez synchronizacji.
+ *
+ * Kazdy watek wykonuje PARTII/watki partii; wynik to partie na sekunde
+ * czasu rzeczywistego (CLOCK_MONOTONIC) i czas CPU procesu na partie.
+ *
+ * Katalog jak w symulacji: domyslnie docs/katalog.txt (12 pozycji).
+ *
+ * Uzycie: ./bench_baker [-n PARTII] [-w WATKI,...] [-f KATALOG]
+ */
+
+#include "common.h"
+#include "catalog.h"
+#include "rng.h"
+#include <pthread.h>
+
+#define BENCH_MAX_RUNS 8
+#define BENCH_TIME_SCALE 100  /* ms na minute, jak -s 100 */
+
+typedef struct {
+    int use_rng;        /* 0 = rand(), 1 = Rng watku */
+    int tid;
+    long batches;
+    long sink;          /* Suma sztuk - zeby kompilator nie wycial petli */
+} Worker;
+
+static ProductDef g_products[MAX_PRODUCTS];
+static int g_num_products;
+static int g_weight;
+
+static uint64_t now_ns(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* worker - Petla decyzji piekarza dla jednego watku */
+static void *worker(void *arg)
+{
+    Worker *w = arg;
+    int range = g_num_products;
+    long sum = 0;
+
+    if (w->use_rng) {
+        Rng rng;
+        rng_seed(&rng, 1, RNG_STREAM_BAKER, (uint64_t)w->tid);
+        for (long b = 0; b < w->batches; b++) {
+            sum += rng_bake_delay_ms(&rng, BENCH_TIME_SCALE);
+            int num_types = rng_range(&rng, 1, range);
+            for (int t = 0; t < num_types; t++) {
+                int prod = catalog_pick(g_products, range, rng_below(&rng, g_weight));
+                sum += rng_bake_batch(&rng, g_products[prod].bake_batch);
+            }
+        }
+    } else {
+        for (long b = 0; b < w->batches; b++) {
+            sum += (20 + rand() % 40) * BENCH_TIME_SCALE / 100;
+            int num_types = 1 + rand() % range;
+            for (int t = 0; t < num_types; t++) {
+                int prod = catalog_pick(g_products, range, rand() % g_weight);
+                int batch = g_products[prod].bake_batch;
+                sum += batch > 0 ? batch : 8 + rand() % 13;
+            }
+        }
+    }
+    w->sink = sum;
+    return NULL;
+}
+
+/* run - Jeden pomiar: nthreads watkow, lacznie total partii */
+static void run(int use_rng, int nthreads, long total)
+{
+    pthread_t th[MAX_BAKER_THREADS];
+    Worker w[MAX_BAKER_THREADS];
+    long per = total / nthreads;
+
+    srand(1);
+    uint64_t c0 = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t t0 = now_ns(CLOCK_MONOTONIC);
+    for (int i = 0; i < nthreads; i++) {
+        w[i] = (Worker){ .use_rng = use_rng, .tid = i, .batches = per };
+        if (pthread_create(&th[i], NULL, worker, &w[i]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(th[i], NULL);
+    uint64_t t1 = now_ns(CLOCK_MONOTONIC);
+    uint64_t c1 = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+
+    long done = per * nthreads;
+    printf("%-10s %6d %12.0f %14.1f\n", use_rng ? "Rng" : "rand()", nthreads,
+           done * 1e9 / (double)(t1 - t0), (double)(c1 - c0) / done);
+}
+
+int main(int argc, char *argv[])
+{
+    long total = 2000000;
+    int threads[BENCH_MAX_RUNS] = { 2, 8, 32 };
+    int nruns = 3;
+    const char *path = "docs/katalog.txt";
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:f:h")) != -1) {
+        switch (opt) {
+            case 'n': total = atol(optarg); break;
+            case 'f': path = optarg; break;
+            case 'w': {
+                nruns = 0;
+                for (char *tok = strtok(optarg, ","); tok && nruns < BENCH_MAX_RUNS;
+                     tok = strtok(NULL, ","))
+                    threads[nruns++] = atoi(tok);
+                break;
+            }
+            default:
+                fprintf(stderr, "Uzycie: %s [-n PARTII] [-w WATKI,...] [-f KATALOG]\n",
+                        argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (total < 1 || nruns == 0) {
+        fprintf(stderr, "Niepoprawne -n / -w\n");
+        return 1;
+    }
+    for (int i = 0; i < nruns; i++) {
+        if (threads[i] < 1 || threads[i] > MAX_BAKER_THREADS) {
+            fprintf(stderr, "Watki poza zakresem 1..%d\n", MAX_BAKER_THREADS);
+            return 1;
+        }
+    }
+
+    g_num_products = catalog_load(path, g_products, MAX_PRODUCTS, stderr);
+    if (g_num_products < 0)
+        return 1;
+    g_weight = catalog_weight(g_products, 0, g_num_products);
+    printf("Katalog %s: %d pozycji, %ld partii na pomiar\n\n", path, g_num_products, total);
+
+    printf("%-10s %6s %12s %14s\n", "losowanie", "watki", "partii/s", "CPU ns/partie");
+    for (int i = 0; i < nruns; i++) {
+        run(0, threads[i], total);
+        run(1, threads[i], total);
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file bench_checkout.c
+ * @brief Mikrobenchmark kolejki kas: koszyk gesty vs linie (produkt, ilosc).
+ *
+ * Odtwarza komunikaty checkout na prywatnej kolejce (IPC_PRIVATE, bez
+ * symulacji):
+ *   gesty   - dawny uklad: int items[20] (ilosc kazdego produktu), kasjer
+ *             przeglada wszystkie P pozycji w poszukiwaniu niezerowych,
+ *   stale   - linie koszyka, zawsze wysylane wszystkie MAX_BASKET_LINES,
+ *   zmienne - linie koszyka, wysylane tylko uzyte (CHECKOUT_MSG_SIZE(n)).
+ *
+ * Pojemnosc: ile komunikatow przyjmie kolejka o domyslnym msg_qbytes
+ * (msgsnd IPC_NOWAIT az do EAGAIN). CPU: czas procesu
+ * (CLOCK_PROCESS_CPUTIME_ID) na koszyk - msgsnd + msgrcv + sumowanie
+ * kwoty, i osobno samo sumowanie.
+ *
+ * Uzycie: ./bench_checkout [-n KOSZYKOW]
+ */
+
+#include "common.h"
+
+#define BENCH_DENSE_P 20  /* Dawny MAX_PRODUCTS - rozmiar tablicy items[] */
+
+/* Dawny komunikat checkout (gesty) */
+struct dense_checkout_msg {
+    long mtype;
+    pid_t customer_pid;
+    int items[BENCH_DENSE_P];
+    uint64_t sent_ns;
+};
+
+typedef struct {
+    const char *name;
+    int dense;          /* 1 = items[], 0 = linie */
+    int P;              /* gesty: przegladane pozycje */
+    int lines;          /* linie: uzyte linie koszyka */
+    int full;           /* linie: wysylane wszystkie MAX_BASKET_LINES */
+} Layout;
+
+static double g_price[BENCH_DENSE_P];
+
+static uint64_t cpu_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int new_queue(size_t *qbytes)
+{
+    int mq = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+    struct msqid_ds info;
+    if (mq == -1 || msgctl(mq, IPC_STAT, &info) == -1) {
+        perror("msgget");
+        exit(EXIT_FAILURE);
+    }
+    *qbytes = info.msg_qbytes;
+    return mq;
+}
+
+/* Koszyk wg ukladu: produkty 0..n-1 po 2 szt. */
+static size_t fill(const Layout *l, struct dense_checkout_msg *d, struct checkout_msg *c)
+{
+    if (l->dense) {
+        memset(d, 0, sizeof(*d));
+        d->mtype = 1;
+        for (int i = 0; i < BENCH_DENSE_P; i += 7) d->items[i] = 2;
+        return sizeof(*d) - sizeof(long);
+    }
+    memset(c, 0, sizeof(*c));
+    c->mtype     = 1;
+    c->num_lines = l->lines;
+    for (int k = 0; k < l->lines; k++) {
+        c->lines[k].product_id = (uint16_t)(k * 2);
+        c->lines[k].qty        = 2;
+    }
+    return CHECKOUT_MSG_SIZE(l->full ? MAX_BASKET_LINES : l->lines) - sizeof(long);
+}
+
+/* Sumowanie kwoty tak jak process_checkout() w danym ukladzie */
+static double total(const Layout *l, const struct dense_checkout_msg *d,
+                    const struct checkout_msg *c)
+{
+    double sum = 0.0;
+    if (l->dense) {
+        for (int i = 0; i < l->P; i++)
+            if (d->items[i] > 0) sum += d->items[i] * g_price[i];
+        return sum;
+    }
+    for (int k = 0; k < c->num_lines; k++)
+        sum += c->lines[k].qty * g_price[c->lines[k].product_id];
+    return sum;
+}
+
+static void run_layout(const Layout *l, int baskets)
+{
+    struct dense_checkout_msg d, dr;
+    struct checkout_msg c, cr;
+    size_t msgsz = fill(l, &d, &c);
+    const void *msg = l->dense ? (const void *)&d : (const void *)&c;
+    void *rbuf = l->dense ? (void *)&dr : (void *)&cr;
+    size_t rsz = l->dense ? sizeof(dr) - sizeof(long) : sizeof(cr) - sizeof(long);
+
+    /* Pojemnosc kolejki */
+    size_t qbytes;
+    int mq = new_queue(&qbytes);
+    int fit = 0;
+    while (msgsnd(mq, msg, msgsz, IPC_NOWAIT) == 0) fit++;
+    msgctl(mq, IPC_RMID, NULL);
+
+    /* CPU na koszyk: msgsnd + msgrcv + suma */
+    mq = new_queue(&qbytes);
+    volatile double sink = 0.0;
+    uint64_t t0 = cpu_now_ns();
+    for (int k = 0; k < baskets; k++) {
+        if (msgsnd(mq, msg, msgsz, IPC_NOWAIT) == -1
+            || msgrcv(mq, rbuf, rsz, 1, IPC_NOWAIT) == -1) {
+            perror("msgsnd/msgrcv");
+            exit(EXIT_FAILURE);
+        }
+        sink += total(l, &dr, &cr);
+    }
+    uint64_t t1 = cpu_now_ns();
+    msgctl(mq, IPC_RMID, NULL);
+
+    /* Samo sumowanie (bez IPC) */
+    uint64_t t2 = cpu_now_ns();
+    for (int k = 0; k < baskets; k++)
+        sink += total(l, &d, &c);
+    uint64_t t3 = cpu_now_ns();
+    (void)sink;
+
+    printf("%-20s %6zu %9zu %8d %10.0f %10.1f\n", l->name, msgsz, qbytes, fit,
+           (double)(t1 - t0) / baskets, (double)(t3 - t2) / baskets);
+}
+
+int main(int argc, char *argv[])
+{
+    int baskets = 200000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n': baskets = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Uzycie: %s [-n KOSZYKOW]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (baskets < 1) {
+        fprintf(stderr, "Niepoprawne -n\n");
+        return 1;
+    }
+
+    for (int i = 0; i < BENCH_DENSE_P; i++)
+        g_price[i] = DEFAULT_PRODUCTS[i % DEFAULT_NUM_PRODUCTS].price;
+
+    static const Layout layouts[] = {
+        { "gesty P=12",        1, 12, 0, 0 },
+        { "gesty P=20",        1, 20, 0, 0 },
+        { "linie stale (1)",   0,  0, 1, 1 },
+        { "linie zmienne (1)", 0,  0, 1, 0 },
+        { "linie zmienne (3)", 0,  0, 3, 0 },
+        { "linie zmienne (8)", 0,  0, 8, 0 },
+    };
+
+    printf("%-20s %6s %9s %8s %10s %10s\n",
+           "komunikat", "bajty", "qbytes", "miesci", "ns/koszyk", "suma ns");
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++)
+        run_layout(&layouts[i], baskets);
+    return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file bench_conveyor.c
+ * @brief Mikrobenchmark pobrania z podajnika: wspolna kolejka vs kolejka na produkt.
+ *
+ * Odtwarza uklady podajnikow backendu sysv (ipc_channel.c) na prywatnych
+ * kolejkach (IPC_PRIVATE, bez symulacji):
+ *   wspolna    - jedna kolejka, msgrcv(mtype = produkt + 1) przeszukuje
+ *                liste komunikatow az do pierwszego pasujacego,
+ *   na produkt - kolejka na produkt (-Q), msgrcv bierze pierwszy komunikat.
+ *
+ * Dla P = 1, 12, 20 i mieszanki towaru na podajnikach (rowna / skos: 90%
+ * sztuk to produkt 0 "Bulka") kolejki sa wypelniane do glebokosci D, a
+ * "klient" wybiera produkt jednostajnie i mierzy samo msgrcv(IPC_NOWAIT).
+ * Pobrana sztuka wraca na koniec kolejki (piekarz), wiec D jest stale.
+ * Czasy w mikrosekundach: p50/p99 wszystkich pobran i p50 produktu
+ * najrzadszego (P-1).
+ *
+ * Uzycie: ./bench_conveyor [-n POBRAN] [-d GLEBOKOSC]
+ */
+
+#include "common.h"
+#include "histogram.h"
+
+#define BENCH_MAX_DEPTH 2000  /* Miesci sie w domyslnym msgmnb (16 KiB / 8 B) */
+
+typedef struct {
+    const char *name;
+    double      head_share;   /* Udzial produktu 0 w towarze (0 = rowno) */
+} Mix;
+
+/* Produkt wg mieszanki: head_share dla 0, reszta rowno na 1..P-1 */
+static int draw_product(const Mix *mix, int P, unsigned int *seed)
+{
+    if (P == 1) return 0;
+    double u = (double)rand_r(seed) / ((double)RAND_MAX + 1.0);
+    if (mix->head_share > 0.0) {
+        if (u < mix->head_share) return 0;
+        return 1 + rand_r(seed) % (P - 1);
+    }
+    return (int)(u * P);
+}
+
+static int new_queue(void)
+{
+    int mq = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+    if (mq == -1) {
+        perror("msgget");
+        exit(EXIT_FAILURE);
+    }
+    return mq;
+}
+
+/*
+ * run_layout - Jeden przebieg: wypelnienie, n pobran, histogramy (ns).
+ */
+static void run_layout(int split, int P, const Mix *mix, int depth, int picks,
+                       LatencyHist *all, LatencyHist *rare)
+{
+    int mq[MAX_CONV_QUEUES];
+    int nq = split ? P : 1;
+    for (int q = 0; q < nq; q++)
+        mq[q] = new_queue();
+
+    unsigned int seed = 12345;
+    struct conveyor_msg msg;
+    for (int k = 0; k < depth; k++) {
+        int p = draw_product(mix, P, &seed);
+        msg.mtype   = p + 1;
+        msg.item_id = k;
+        if (msgsnd(mq[split ? p : 0], &msg, sizeof(msg) - sizeof(long), IPC_NOWAIT) == -1) {
+            perror("msgsnd (wypelnianie)");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    memset(all, 0, sizeof(*all));
+    memset(rare, 0, sizeof(*rare));
+    for (int k = 0; k < picks; k++) {
+        int p  = rand_r(&seed) % P;
+        int id = mq[split ? p : 0];
+        uint64_t t0 = hist_now_ns();
+        ssize_t r = msgrcv(id, &msg, sizeof(msg) - sizeof(long), p + 1, IPC_NOWAIT);
+        uint64_t t1 = hist_now_ns();
+        if (r == -1) continue; /* Produktu brak na podajniku */
+
+        hist_record(all, t1 - t0);
+        if (p == P - 1) hist_record(rare, t1 - t0);
+        msgsnd(id, &msg, sizeof(msg) - sizeof(long), IPC_NOWAIT);
+    }
+
+    for (int q = 0; q < nq; q++)
+        msgctl(mq[q], IPC_RMID, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    int picks = 200000;
+    int depth = 0; /* 0 = min(Ki * P, BENCH_MAX_DEPTH) */
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:h")) != -1) {
+        switch (opt) {
+            case 'n': picks = atoi(optarg); break;
+            case 'd': depth = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Uzycie: %s [-n POBRAN] [-d GLEBOKOSC (max %d)]\n",
+                        argv[0], BENCH_MAX_DEPTH);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (picks < 1 || depth < 0 || depth > BENCH_MAX_DEPTH) {
+        fprintf(stderr, "Niepoprawne -n/-d\n");
+        return 1;
+    }
+
+    static const int   sizes[] = { 1, 12, 20 };
+    static const Mix   mixes[] = { { "rowna", 0.0 }, { "skos 90%", 0.9 } };
+    static const char *layouts[] = { "wspolna", "na produkt" };
+    int capacity = DEFAULT_PRODUCTS[0].conveyor_capacity;
+
+    printf("%3s  %-9s %-11s %6s %10s %10s %12s\n",
+           "P", "towar", "kolejka", "D", "p50 us", "p99 us", "rzadki p50");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int P = sizes[s];
+        int D = depth ? depth : capacity * P;
+        if (D > BENCH_MAX_DEPTH) D = BENCH_MAX_DEPTH;
+
+        for (size_t m = 0; m < sizeof(mixes) / sizeof(mixes[0]); m++) {
+            if (P == 1 && m > 0) continue; /* Jeden produkt - brak skosu */
+            for (int split = 0; split <= 1; split++) {
+                static LatencyHist all, rare;
+                run_layout(split, P, &mixes[m], D, picks, &all, &rare);
+                printf("%3d  %-9s %-11s %6d %10.2f %10.2f %12.2f\n",
+                       P, mixes[m].name, layouts[split], D,
+                       hist_percentile(&all, 0.50) / 1000.0,
+                       hist_percentile(&all, 0.99) / 1000.0,
+                       hist_percentile(&rare, 0.50) / 1000.0);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * catalog.c - Katalog produktow ciastkarni (plik -f lub lista domyslna)
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Parser pliku katalogu i budowa konfiguracji o ukladzie segmentu
+ * pamieci dzielonej (naglowek SharedData + katalog + liczniki produktow).
+ */
+
+#include "catalog.h"
+#include <ctype.h>
+
+#define CATALOG_FIELDS 5
+
+/*
+ * trim - Usuwa biale znaki z poczatku i konca napisu (w miejscu).
+ */
+static char *trim(char *s)
+{
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+/*
+ * parse_long - Pole liczbowe calkowite z zakresu [lo, hi].
+ */
+static int parse_long(const char *s, long lo, long hi, long *out)
+{
+    char *end;
+    errno = 0;
+    long v = strtol(s, &end, 10);
+    if (errno != 0 || end == s || *end != '\0' || v < lo || v > hi)
+        return -1;
+    *out = v;
+    return 0;
+}
+
+/*
+ * parse_line - Pozycja katalogu z linii (pola rozdzielone ';').
+ * Zwraca NULL albo opis bledu.
+ */
+static const char *parse_line(char *line, ProductDef *p)
+{
+    char *field[CATALOG_FIELDS] = { NULL };
+    int nf = 0;
+    char *s = line;
+    for (;;) {
+        char *sep = strchr(s, ';');
+        if (nf == CATALOG_FIELDS)
+            return "wiecej niz 5 pol";
+        if (sep) *sep = '\0';
+        field[nf++] = trim(s);
+        if (!sep) break;
+        s = sep + 1;
+    }
+    if (nf < 3)
+        return "oczekiwano nazwa;cena;pojemnosc[;waga[;partia]]";
+
+    memset(p, 0, sizeof(*p));
+    size_t len = strlen(field[0]);
+    if (len == 0 || len >= MAX_NAME_LEN)
+        return "nazwa pusta lub dluzsza niz 31 znakow";
+    /* Nazwa trafia bez escapowania do etykiet Prometheus (metrics_server) */
+    for (const char *c = field[0]; *c; c++)
+        if (*c == '"' || *c == '\\' || iscntrl((unsigned char)*c))
+            return "nazwa zawiera '\"', '\\' lub znak sterujacy";
+    memcpy(p->name, field[0], len + 1);
+
+    char *end;
+    errno = 0;
+    p->price = strtod(field[1], &end);
+    if (errno != 0 || end == field[1] || *end != '\0'
+        || !(p->price > 0.0) || p->price > CATALOG_MAX_PRICE)
+        return "cena poza zakresem (0, 10000]";
+    p->price_gr = PLN_TO_GR(p->price);
+    if (p->price_gr < 1)
+        return "cena ponizej 1 grosza";
+    p->price = p->price_gr / 100.0;
+
+    long v;
+    if (parse_long(field[2], 1, CATALOG_MAX_CAPACITY, &v) != 0)
+        return "pojemnosc poza zakresem 1..10000";
+    p->conveyor_capacity = (int)v;
+
+    p->weight = 1;
+    if (nf > 3 && field[3][0] != '\0') {
+        if (parse_long(field[3], 0, CATALOG_MAX_WEIGHT, &v) != 0)
+            return "waga poza zakresem 0..1000000";
+        p->weight = (int)v;
+    }
+    if (nf > 4 && field[4][0] != '\0') {
+        if (parse_long(field[4], 0, CATALOG_MAX_BATCH, &v) != 0)
+            return "partia poza zakresem 0..1000";
+        p->bake_batch = (int)v;
+    }
+    return NULL;
+}
+
+int catalog_load(const char *path, ProductDef *out, int max, FILE *err)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(err, "%s[KATALOG]%s %s: %s\n", C_RED, C_RESET, path, strerror(errno));
+        return -1;
+    }
+
+    char line[256];
+    int lineno = 0, n = 0;
+    long weight_total = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        if (strchr(line, '\n') == NULL && !feof(f)) {
+            fprintf(err, "%s[KATALOG]%s %s:%d: linia dluzsza niz %zu znakow\n",
+                    C_RED, C_RESET, path, lineno, sizeof(line) - 2);
+            fclose(f);
+            return -1;
+        }
+        char *s = trim(line);
+        if (*s == '\0' || *s == '#') continue;
+
+        if (n == max) {
+            fprintf(err, "%s[KATALOG]%s %s:%d: wiecej niz %d produktow\n",
+                    C_RED, C_RESET, path, lineno, max);
+            fclose(f);
+            return -1;
+        }
+        const char *msg = parse_line(s, &out[n]);
+        if (msg != NULL) {
+            fprintf(err, "%s[KATALOG]%s %s:%d: %s\n", C_RED, C_RESET, path, lineno, msg);
+            fclose(f);
+            return -1;
+        }
+        weight_total += out[n].weight;
+        n++;
+    }
+    fclose(f);
+
+    if (n == 0) {
+        fprintf(err, "%s[KATALOG]%s %s: brak produktow\n", C_RED, C_RESET, path);
+        return -1;
+    }
+    if (weight_total == 0) {
+        fprintf(err, "%s[KATALOG]%s %s: wszystkie wagi = 0 - klienci nie "
+                "maja czego wybrac\n", C_RED, C_RESET, path);
+        return -1;
+    }
+    return n;
+}
+
+void catalog_default(ProductDef *out, int n)
+{
+    for (int i = 0; i < n; i++) {
+        const ProductDef *base = &DEFAULT_PRODUCTS[i % DEFAULT_NUM_PRODUCTS];
+        out[i] = *base;
+        if (i >= DEFAULT_NUM_PRODUCTS) {
+            snprintf(out[i].name, MAX_NAME_LEN, "%.24s Extra", base->name);
+            out[i].price = base->price * 1.2;
+        }
+        out[i].price_gr = PLN_TO_GR(out[i].price);
+        out[i].price    = out[i].price_gr / 100.0;
+    }
+}
+
+SharedData *catalog_build_config(const SharedData *hdr, const ProductDef *catalog, int n)
+{
+    SharedData *cfg = calloc(1, shm_layout_size(n));
+    if (cfg == NULL)
+        return NULL;
+
+    *cfg = *hdr;
+    cfg->num_products = n;
+    shm_layout_init(cfg);
+
+    ProductDef *products = shm_products(cfg);
+    cfg->weight_total = 0;
+    for (int i = 0; i < n; i++) {
+        products[i] = catalog[i];
+        cfg->weight_total += catalog[i].weight;
+    }
+    memset(shm_stats(cfg), 0, n * sizeof(ProductStats));
+    return cfg;
+}
@@ -0,0 +1,72 @@
+/**
+ * catalog.h - Katalog produktow ciastkarni (plik -f lub lista domyslna)
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Plik katalogu: jedna pozycja na linie, pola rozdzielone ';':
+ *
+ *     nazwa;cena;pojemnosc;waga;partia
+ *
+ * cena w PLN (zaokraglana do grosza), pojemnosc = Ki podajnika, waga = udzial produktu w wyborach
+ * klientow (domyslnie 1, 0 = produkt tylko wypiekany), partia = sztuk
+ * w partii piekarza (domyslnie 0 = losowo 8-20). Puste linie i linie
+ * od '#' sa pomijane. Kierownik buduje z katalogu konfiguracje o ukladzie
+ * segmentu (shm_layout_size) - od liczby pozycji zalezy rozmiar pamieci
+ * dzielonej i zbioru semaforow.
+ */
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "common.h"
+#include <stdio.h>
+
+/* Zakresy pol pozycji katalogu */
+#define CATALOG_MAX_PRICE    10000.0
+#define CATALOG_MAX_CAPACITY 10000
+#define CATALOG_MAX_WEIGHT   1000000  /* Suma wag miesci sie w int */
+#define CATALOG_MAX_BATCH    1000
+
+/**
+ * Wczytuje katalog z pliku path do out[max].
+ * @return Liczba pozycji (1..max) lub -1 - opis bledu (plik:linia) w err
+ */
+int catalog_load(const char *path, ProductDef *out, int max, FILE *err);
+
+/**
+ * Katalog domyslny n pozycji: DEFAULT_PRODUCTS, dalej warianty "Extra"
+ * (cena x1.2).
+ */
+void catalog_default(ProductDef *out, int n);
+
+/**
+ * Konfiguracja o ukladzie segmentu: kopia hdr, num_products = n,
+ * offsety ogona, katalog i weight_total, liczniki wyzerowane.
+ * @return Bufor shm_layout_size(n) (free) lub NULL przy braku pamieci
+ */
+SharedData *catalog_build_config(const SharedData *hdr, const ProductDef *catalog, int n);
+
+/**
+ * Wybor produktu wedlug wag popularnosci. u z [0, weight_total).
+ * @return Indeks produktu
+ */
+static inline int catalog_pick(const ProductDef *products, int n, int u)
+{
+    for (int i = 0; i < n; i++) {
+        u -= products[i].weight;
+        if (u < 0) return i;
+    }
+    return n - 1;
+}
+
+/**
+ * Suma wag produktow z zakresu [start, end).
+ */
+static inline int catalog_weight(const ProductDef *products, int start, int end)
+{
+    int w = 0;
+    for (int i = start; i < end; i++)
+        w += products[i].weight;
+    return w;
+}
+
+#endif /* CATALOG_H */
@@ -11,10 +11,19 @@
  *   simulation_running=1
  *   active_customers=5
  *   total_customers_entered=12
- *   sem_shop_entry=1
+ *   sem_shop_entry=1      (backend posix: nazwany semafor POSIX_SEM_ENTRY)
+ *   ipc_backend=sysv
+ *   hist_visit=n=12 p50=... p90=... p99=... p99.9=... max=...  (ms)
  *
- * Uzycie: ./check_shm <key_file>
+ * Uzycie: ./check_shm [--watch MS] [key_file]
  * Zwraca 0 jesli SHM istnieje, 1 jesli nie moze sie podlaczyc.
+ *
+ * Tryb --watch MS: jedno dolaczenie, probka co MS milisekund (min. 1)
+ * jako wiersz CSV na stdout - czas CLOCK_MONOTONIC od startu, stan sklepu,
+ * wszystkie semafory jednym semctl(GETALL), glebokosci kolejek komunikatow
+ * z msgctl(IPC_STAT). Tempo wyznacza clock_nanosleep(TIMER_ABSTIME), wiec
+ * czas probkowania nie przesuwa kolejnych probek. Konczy sie, gdy segment
+ * zostanie usuniety (SHM_DEST) albo po SIGINT/SIGTERM.
  */
 
 #include <stdio.h>
@@ -23,11 +32,196 @@
 #include <sys/shm.h>
 #include <sys/sem.h>
 #include <string.h>
+#include <semaphore.h>
 #include "common.h"
+#include "ipc_channel.h"
+#include "histogram.h"
+#include "seqlock.h"
+
+/* ================================================================
+ *  TRYB CIAGLY (--watch)
+ * ================================================================ */
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void stop_handler(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Wolne miejsca w sklepie: backend posix trzyma je w nazwanym semaforze */
+static int entry_value(const SharedData *shm, int sysv_val)
+{
+    if (shm->ipc_backend != IPC_BACKEND_POSIX)
+        return sysv_val;
+    sem_t *s = sem_open(POSIX_SEM_ENTRY, 0);
+    int val = -1;
+    if (s != SEM_FAILED) {
+        sem_getvalue(s, &val);
+        sem_close(s);
+    }
+    return val;
+}
+
+/* Liczba komunikatow i bajtow w kolejce (-1 gdy kolejka nie istnieje) */
+static void queue_depth(int mq_id, long *qnum, long *cbytes)
+{
+    struct msqid_ds ds;
+    if (mq_id == -1 || msgctl(mq_id, IPC_STAT, &ds) == -1) {
+        *qnum = -1;
+        *cbytes = -1;
+        return;
+    }
+    *qnum   = (long)ds.msg_qnum;
+    *cbytes = (long)ds.__msg_cbytes;
+}
+
+/*
+ * watch_loop - Strumien wierszy CSV do usuniecia segmentu.
+ */
+static int watch_loop(const char *key_file, int shm_id, const SharedData *shm,
+                      int sem_id, long interval_ms)
+{
+    /* Kolumny mq_* sumuja grupe kolejek: podajniki (-Q), kasy i paragony (-r) */
+    int mq[3][MAX_CONV_QUEUES];
+    int nq[3] = { 1, 1, 1 };
+    int shards = shm->queue_shards;
+    if (shards < 0 || shards > MAX_RECEIPT_SHARDS) shards = 0;
+    if (shm->conveyor_queues && shm->num_products > 0
+        && shm->num_products <= MAX_CONV_QUEUES)
+        nq[0] = shm->num_products;
+    if (shards > 0) {
+        nq[1] = NUM_REGISTERS;
+        nq[2] = shards;
+    }
+    for (int q = 0; q < 3; q++) {
+        for (int i = 0; i < nq[q]; i++) {
+            int proj = (q == 1) ? PROJ_MQ_CHKOUT_REG(i)
+                     : (q == 2) ? PROJ_MQ_RCPT_SHARD(i)
+                     : shm->conveyor_queues ? PROJ_MQ_CONV_PROD(i) : PROJ_MQ_CONV;
+            key_t k = ftok(key_file, proj);
+            mq[q][i] = (k != -1) ? msgget(k, 0) : -1;
+        }
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    int np = shm->num_products;
+    if (np < 0 || np > MAX_PRODUCTS) np = 0;
+    unsigned short vals[TOTAL_SEMS(MAX_PRODUCTS)];
+    SharedData *snap = shm_snapshot_new(shm); /* Migawka stanu (seqlock) */
+    if (snap == NULL) { fprintf(stderr, "malloc (migawka)\n"); return 1; }
+
+    printf("t_ms,sim_time,shop_open,customers_in_shop,active_customers,"
+           "customers_served,customers_not_served,register_queue_0,"
+           "register_queue_1,register_open_1,sem_shop_entry,produced_total");
+    for (int i = 0; i < np; i++)
+        printf(",conveyor_fill_%d", i);
+    printf(",mq_conv_msgs,mq_conv_bytes,mq_checkout_msgs,mq_checkout_bytes,"
+           "mq_receipt_msgs,mq_receipt_bytes\n");
+
+    uint64_t t0 = mono_ns(), last_flush = t0;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!g_stop) {
+        struct shmid_ds ds;
+        if (shmctl(shm_id, IPC_STAT, &ds) == -1 || (ds.shm_perm.mode & SHM_DEST))
+            break;
+
+        union semun { int val; struct semid_ds *buf; unsigned short *array; } arg;
+        arg.array = vals;
+        if (sem_id == -1 || semctl(sem_id, 0, GETALL, arg) == -1)
+            memset(vals, 0, sizeof(vals));
+
+        int hour, min;
+        shm_read_state(shm, snap);
+        shm_read_clock(shm, &hour, &min);
+
+        int produced = 0;
+        for (int i = 0; i < np; i++)
+            produced += shm_stats(snap)[i].baker_produced;
+
+        uint64_t now = mono_ns();
+        printf("%.3f,%02d:%02d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d",
+               (double)(now - t0) / 1e6, hour, min,
+               shm->shop_open, snap->customers_in_shop, snap->active_customers,
+               snap->customers_served, snap->customers_not_served,
+               snap->register_queue_len[0], snap->register_queue_len[1],
+               snap->register_open[1], entry_value(shm, vals[SEM_SHOP_ENTRY]),
+               produced);
+        for (int i = 0; i < np; i++)
+            printf(",%d", shm_products(shm)[i].conveyor_capacity
+                          - vals[SEM_CONVEYOR_BASE + i]);
+        for (int q = 0; q < 3; q++) {
+            long qnum, cbytes;
+            queue_depth(mq[q][0], &qnum, &cbytes);
+            if (nq[q] > 1) {
+                qnum = cbytes = 0;
+                for (int i = 0; i < nq[q]; i++) {
+                    long n, b;
+                    queue_depth(mq[q][i], &n, &b);
+                    if (n > 0) { qnum += n; cbytes += b; }
+                }
+            }
+            printf(",%ld,%ld", qnum, cbytes);
+        }
+        printf("\n");
+
+        /* Flush co ~100 ms - przy 1 ms nie placimy write() za kazdy wiersz */
+        if (now - last_flush >= 100000000ULL) {
+            fflush(stdout);
+            last_flush = now;
+        }
+
+        next.tv_nsec += interval_ms * 1000000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR
+               && !g_stop)
+            ;
+    }
+    fflush(stdout);
+    free(snap);
+    return 0;
+}
+
+/* ================================================================
+ *  MAIN
+ * ================================================================ */
 
 int main(int argc, char *argv[])
 {
-    const char *key_file = (argc > 1) ? argv[1] : KEY_FILE;
+    const char *key_file = KEY_FILE;
+    long watch_ms = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            char *end;
+            watch_ms = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || watch_ms < 1) {
+                fprintf(stderr, "--watch: interwal w ms (>= 1)\n");
+                return 1;
+            }
+        } else {
+            key_file = argv[i];
+        }
+    }
 
     /* Polacz z SHM */
     key_t shm_key = ftok(key_file, PROJ_SHM);
@@ -50,45 +244,78 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (watch_ms > 0) {
+        int rc = watch_loop(key_file, shm_id, shm, sem_id, watch_ms);
+        shmdt(shm);
+        return rc;
+    }
+
+    /* Spojna migawka stanu i zegara (seqlock) - bez SEM_SHM_MUTEX */
+    SharedData *snap = shm_snapshot_new(shm);
+    if (snap == NULL) { fprintf(stderr, "malloc (migawka)\n"); return 1; }
+    const SharedData *st = snap;
+    int hour, min;
+    shm_read_state(shm, snap);
+    shm_read_clock(shm, &hour, &min);
+
     /* Wypisz stan */
-    printf("customers_in_shop=%d\n", shm->customers_in_shop);
+    printf("customers_in_shop=%d\n", st->customers_in_shop);
     printf("max_customers=%d\n", shm->max_customers);
+    printf("time_scale_ms=%d\n", shm->time_scale_ms);
+    printf("baker_threads=%d\n", shm->baker_threads);
     printf("shop_open=%d\n", shm->shop_open);
     printf("evacuation_mode=%d\n", shm->evacuation_mode);
     printf("simulation_running=%d\n", shm->simulation_running);
-    printf("active_customers=%d\n", shm->active_customers);
-    printf("total_customers_entered=%d\n", shm->total_customers_entered);
-    printf("sim_hour=%d\n", shm->sim_hour);
-    printf("sim_min=%d\n", shm->sim_min);
-    printf("sem_shop_entry=%d\n", sem_shop_val);
-    printf("register_open_0=%d\n", shm->register_open[0]);
-    printf("register_open_1=%d\n", shm->register_open[1]);
-    printf("register_queue_0=%d\n", shm->register_queue_len[0]);
-    printf("register_queue_1=%d\n", shm->register_queue_len[1]);
+    printf("active_customers=%d\n", st->active_customers);
+    printf("total_customers_entered=%d\n", st->total_customers_entered);
+    printf("sim_hour=%d\n", hour);
+    printf("sim_min=%d\n", min);
+    printf("sim_tick=%u\n", __atomic_load_n(&shm->tick, __ATOMIC_RELAXED));
+    printf("tick_waiters=%u\n", __atomic_load_n(&shm->tick_waiters, __ATOMIC_RELAXED));
+    printf("sem_shop_entry=%d\n", entry_value(shm, sem_shop_val));
+    printf("ipc_backend=%s\n", ipc_backend_name(shm->ipc_backend));
+    printf("conveyor_queues=%d\n", shm->conveyor_queues);
+    printf("queue_shards=%d\n", shm->queue_shards);
+    printf("shm_size=%llu\n", (unsigned long long)shm->shm_size);
+    printf("shm_opts=%d\n", shm->shm_active);
+    printf("shm_touch_faults=%llu\n", (unsigned long long)shm->shm_touch_faults);
+    printf("register_open_0=%d\n", st->register_open[0]);
+    printf("register_open_1=%d\n", st->register_open[1]);
+    printf("register_queue_0=%d\n", st->register_queue_len[0]);
+    printf("register_queue_1=%d\n", st->register_queue_len[1]);
     printf("num_products=%d\n", shm->num_products);
-    printf("customers_served=%d\n", shm->customers_served);
-    printf("customers_not_served=%d\n", shm->customers_not_served);
+    printf("catalog_weight_total=%d\n", shm->weight_total);
+    printf("customers_served=%d\n", st->customers_served);
+    printf("customers_not_served=%d\n", st->customers_not_served);
     printf("baker_pid=%d\n", (int)shm->baker_pid);
     printf("bakery_open=%d\n", shm->bakery_open);
 
     /* Suma produkcji piekarza */
     int baker_total = 0;
     for (int i = 0; i < shm->num_products; i++) {
-        printf("baker_produced_%d=%d\n", i, shm->baker_produced[i]);
-        baker_total += shm->baker_produced[i];
+        printf("baker_produced_%d=%d\n", i, shm_stats(st)[i].baker_produced);
+        baker_total += shm_stats(st)[i].baker_produced;
     }
     printf("baker_produced_total=%d\n", baker_total);
 
     /* Suma sprzedazy obu kas */
-    double revenue_total = shm->register_revenue[0] + shm->register_revenue[1];
-    printf("register_revenue_total=%.2f\n", revenue_total);
+    int64_t revenue_gr = st->register_revenue_gr[0] + st->register_revenue_gr[1];
+    printf("register_revenue_total=%.2f\n", revenue_gr / 100.0);
 
     /* Kosz ewakuacyjny */
     int basket_total = 0;
     for (int i = 0; i < shm->num_products; i++)
-        basket_total += shm->basket_items[i];
+        basket_total += shm_stats(st)[i].basket_items;
     printf("basket_total=%d\n", basket_total);
 
+    /* Histogramy opoznien (odczyt bez mutexu - liczniki atomowe) */
+    for (int h = 0; h < HIST_COUNT; h++) {
+        char line[160];
+        hist_format(line, sizeof(line), &shm->hist[h]);
+        printf("hist_%s=%s\n", hist_name(h), line);
+    }
+
+    free(snap);
     shmdt(shm);
     return 0;
 }
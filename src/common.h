@@ -26,22 +26,46 @@
 #include <pthread.h>
 #include <stdarg.h>
 #include <math.h>
+#include <stdint.h>
+#include <stddef.h>
 
 /*
  *  STALE KONFIGURACYJNE
  */
 
-#define MAX_PRODUCTS        20   /* Maksymalna liczba produktow */
+#define MAX_PRODUCTS        1024 /* Maksymalna liczba produktow (katalog -f) */
+#define MAX_CONV_QUEUES     20   /* -Q: kolejki podajnikow (klucze ftok 0x60..0x73) */
+#define MAX_BASKET_LINES    8    /* Maks. roznych produktow w koszyku (linie komunikatu) */
 #define MAX_CUSTOMERS_TOTAL 4678 /* Maks. laczna liczba klientow w symulacji */
 #define MAX_ACTIVE_CUST     4678 /* Maks. procesow klientow jednoczesnie */
 #define MAX_NAME_LEN        32   /* Maks. dlugosc nazwy produktu */
+#define MAX_BAKER_THREADS   32   /* Maks. watkow produkcyjnych piekarza */
+#define NUM_REGISTERS       2    /* Liczba kas */
+#define MAX_RECEIPT_SHARDS  16   /* Maks. kolejek paragonow (-r) */
 
 /* Sciezki plikow */
 #define KEY_FILE            "ciastkarnia.key"
 #define FIFO_CMD_PATH       "/tmp/ciastkarnia_cmd.fifo"
+#define FIFO_ACK_PATH       "/tmp/ciastkarnia_ack.fifo"
 #define LOG_DIR             "logs"
 #define REPORT_FILE         "logs/raport.txt"
 #define FULL_LOG_FILE       "logs/full_logs.txt"
+#define JOURNAL_FILE        "logs/journal.bin"
+
+/* Opcje segmentu pamieci dzielonej (-m, SharedData.shm_opts) */
+#define SHM_OPT_HUGE        0x1  /* SHM_HUGETLB (awaryjnie zwykle strony) */
+#define SHM_OPT_PREFAULT    0x2  /* Strony wypelnione przy dolaczeniu potomka */
+#define SHM_OPT_LOCK        0x4  /* SHM_LOCK - segment poza swapem */
+
+/* Start potomkow: shm_id w srodowisku zamiast ftok() (IpcBootstrap) */
+#define ENV_SHM_ID          "CIASTKARNIA_SHM_ID"
+#define ENV_IPC_ATTACH      "CIASTKARNIA_IPC_ATTACH" /* "ftok" = stara sciezka */
+#define METRICS_SOCK_PATH   "/tmp/ciastkarnia_metrics.sock"
+
+/* Nazwy obiektow POSIX (backend kanalow -I posix, ipc_channel.h) */
+#define POSIX_MQ_CONV_FMT   "/ciastkarnia_podajnik_%d"
+#define POSIX_MQ_CHKOUT_FMT "/ciastkarnia_kasa_%d"
+#define POSIX_SEM_ENTRY     "/ciastkarnia_wejscie"
 
 /* ftok() identyfikatory projektow */
 #define PROJ_SHM       'S'   /* Pamiec dzielona */
@@ -49,6 +73,10 @@
 #define PROJ_MQ_CONV   'C'   /* Kolejka komunikatow - podajniki */
 #define PROJ_MQ_CHKOUT 'K'   /* Kolejka komunikatow - kasy (checkout) */
 #define PROJ_MQ_RCPT   'R'   /* Kolejka komunikatow - paragony */
+#define PROJ_MQ_CONV_PROD(i) (0x60 + (i)) /* Podajnik i (-Q): 0x60..0x73 */
+/* Kolejki kas i paragonow (-r): indeks 0 to kolejka wspolna */
+#define PROJ_MQ_CHKOUT_REG(r) ((r) == 0 ? PROJ_MQ_CHKOUT : 0x80 + (r))
+#define PROJ_MQ_RCPT_SHARD(s) ((s) == 0 ? PROJ_MQ_RCPT : 0x90 + (s))
 
 /* Indeksy semaforow w zbiorze */
 #define SEM_SHM_MUTEX     0   /* Mutex na pamiec dzielona */
@@ -58,7 +86,12 @@
 #define SEM_GUARD_CONV(P)   (2 + (P))     /* Guard na kolejke podajnikow */
 #define SEM_GUARD_CHKOUT(P) (2 + (P) + 1) /* Guard na kolejke kas */
 #define SEM_GUARD_RCPT(P)   (2 + (P) + 2) /* Guard na kolejke paragonow */
-#define TOTAL_SEMS(P)       (2 + (P) + 3) /* Laczna liczba semaforow */
+/* Indeksy 2+P+3 .. 2+2P+2: guard kolejki podajnika i (uklad -Q) */
+#define SEM_GUARD_CONV_PROD(P, i) (2 + (P) + 3 + (i))
+/* Indeksy 2+2P+3 ..: guard kolejki kasy r >= 1 (uklad -r; kasa 0
+ * uzywa SEM_GUARD_CHKOUT) */
+#define SEM_GUARD_CHKOUT_REG(P, r) (2 + 2 * (P) + 2 + (r))
+#define TOTAL_SEMS(P)       (2 + 2 * (P) + 2 + NUM_REGISTERS) /* Laczna liczba */
 
 /*
  *  KOLORY TERMINALA
@@ -86,6 +119,20 @@ typedef enum {
     PROC_CUSTOMER = 3
 } ProcessType;
 
+#define NUM_PROC_TYPES 4
+
+/*
+ *  POZIOMY LOGOWANIA
+ */
+
+typedef enum {
+    LOG_LVL_ERROR = 0,
+    LOG_LVL_WARN  = 1,
+    LOG_LVL_INFO  = 2,
+    LOG_LVL_DEBUG = 3,
+    LOG_LVL_TRACE = 4
+} LogLevel;
+
 /* 
  *  STRUKTURY DANYCH
  */
@@ -97,39 +144,128 @@ typedef struct {
     char name[MAX_NAME_LEN];   /* Nazwa produktu */
     double price;               /* Cena (PLN) */
     int conveyor_capacity;      /* Ki - pojemnosc podajnika */
+    int weight;                 /* Waga popularnosci (udzial w wyborach klientow) */
+    int bake_batch;             /* Sztuk w partii piekarza (0 = losowo 8-20) */
+    int price_gr;               /* Cena w groszach - rachunki kas i przychod */
 } ProductDef;
 
+/**
+ * Liczniki jednego produktu w ogonie segmentu (shm_stats). Naleza do
+ * bloku stanu: zapis pod SEM_SHM_MUTEX, odczyt przez shm_read_state.
+ */
+typedef struct {
+    int register_sales[NUM_REGISTERS]; /* Sprzedane szt. na kasie */
+    int baker_produced;                /* Wyprodukowane szt. */
+    int basket_items;                  /* Sztuki w koszu ewakuacyjnym */
+} ProductStats;
+
+/**
+ * Linia koszyka w komunikatach checkout i paragonu - tylko produkty
+ * obecne w koszyku, niezaleznie od wielkosci katalogu.
+ */
+typedef struct {
+    uint16_t product_id;
+    uint16_t qty;
+} BasketLine;
+
+/**
+ * Blok startowy: identyfikatory IPC wpisane przez kierownika po
+ * utworzeniu kanalow. Potomek dostaje shm_id w ENV_SHM_ID, a semafory
+ * i kolejki czyta stad - bez ftok() i semget/msgget.
+ */
+typedef struct {
+    int ready;                          /* 1 = identyfikatory kompletne */
+    int shm_id;
+    int sem_id;
+    int mq_conv;                        /* sysv: wspolna kolejka podajnikow */
+    int mq_conv_prod[MAX_CONV_QUEUES];  /* sysv -Q */
+    int mq_chkout[NUM_REGISTERS];       /* sysv: kasy (bez -r tylko [0]) */
+    int mq_rcpt[MAX_RECEIPT_SHARDS];    /* Paragony (oba backendy) */
+} IpcBootstrap;
+
+/**
+ * Histogramy opoznien faz wizyty klienta (histogram.c).
+ */
+typedef enum {
+    HIST_ENTRY_WAIT = 0,   /* Czekanie na wejscie do sklepu */
+    HIST_CONVEYOR_WAIT,    /* Czekanie na sztuke z podajnika */
+    HIST_CHECKOUT_QUEUE,   /* Kolejka do kasy (wyslanie -> odbior przez kasjera) */
+    HIST_SCAN,             /* Skanowanie koszyka */
+    HIST_RECEIPT,          /* Dostarczenie paragonu */
+    HIST_VISIT,            /* Cala wizyta (start procesu -> wyjscie) */
+    HIST_STARTUP,          /* Start klienta (main po exec -> gotowy, IPC dolaczone) */
+    HIST_SHM_ATTACH,       /* shmat (+ prefault) w potomku */
+    HIST_SHM_TOUCH,        /* Pierwszy dotyk stron SharedData w potomku */
+    HIST_COUNT
+} HistId;
+
+/*
+ * Kubelki logarytmiczne (styl HDR): 16 podkubelkow na kazda potege dwojki,
+ * blad wzgledny <= 1/16. Wartosci w mikrosekundach, zakres do 2^40 us.
+ */
+#define HIST_SUB_BITS   4
+#define HIST_SUB_COUNT  (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS   40
+#define HIST_BUCKETS    ((HIST_MAX_BITS - HIST_SUB_BITS + 2) * HIST_SUB_COUNT)
+
+/**
+ * Histogram opoznien. W SHM aktualizowany tylko operacjami atomowymi.
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint64_t buckets[HIST_BUCKETS];
+} LatencyHist;
+
 /**
  * Glowna struktura pamieci dzielonej.
  * Przechowuje caly stan symulacji.
  */
 typedef struct {
-    /* --- Konfiguracja (ustawiana raz przez kierownika) --- */
+    /* --- Konfiguracja (kierownik; skala, N i watki piekarza zmieniane FIFO) --- */
     int num_products;           /* P - liczba produktow (>10) */
     int max_customers;          /* N - maks. klientow w sklepie */
     int time_scale_ms;          /* ms na minute symulacji */
     int open_hour, open_min;    /* Tp - godzina otwarcia ciastkarni */
     int close_hour, close_min;  /* Tk - godzina zamkniecia */
-
-    /* --- Definicje produktow --- */
-    ProductDef products[MAX_PRODUCTS];
-
-    /* --- Stan sklepu (chronione przez SEM_SHM_MUTEX) --- */
+    int log_level[NUM_PROC_TYPES]; /* Prog logowania per typ procesu (LogLevel) */
+    int baker_threads;          /* Watki produkcyjne piekarza (polecenie FIFO) */
+    int ipc_backend;            /* Backend kanalow IPC (IpcBackendKind, -I) */
+    int conveyor_queues;        /* sysv: 1 = kolejka na produkt (-Q), 0 = wspolna */
+    int queue_shards;           /* -r: 0 = wspolne kolejki kas i paragonow,
+                                 * R >= 1 = kolejka na kase + R kolejek paragonow */
+    IpcBootstrap boot;          /* Identyfikatory IPC dla potomkow */
+    int shm_opts;               /* -m: zadane SHM_OPT_* */
+    int shm_active;             /* SHM_OPT_* wlaczone naprawde (po fallbacku) */
+    uint64_t shm_size;          /* Rozmiar segmentu (z duzymi stronami - zaokraglony) */
+    uint64_t seed;              /* -S: ziarno obciazenia, strumienie Rng (rng.h) */
+
+    /* --- Katalog produktow: ogon segmentu za SharedData (shm_products,
+     *     shm_stats), rozmiar z num_products - shm_layout_size() --- */
+    uint32_t catalog_off;       /* Offset ProductDef[num_products] */
+    uint32_t stats_off;         /* Offset ProductStats[num_products] */
+    int weight_total;           /* Suma wag popularnosci katalogu */
+
+    /* --- Stan i statystyki (SEM_SHM_MUTEX + seqlock state_seq) ---
+     * Pola od customers_in_shop do customers_not_served tworza spojny
+     * blok kopiowany przez czytelnikow (shm_read_state, seqlock.h). */
+    uint32_t state_seq;              /* Licznik sekwencji (nieparzysty = zapis) */
     int customers_in_shop;           /* Ilu klientow jest w sklepie */
     int total_customers_entered;     /* Laczna liczba klientow */
     int register_open[2];            /* 1 = kasa jest obsadzona */
     int register_accepting[2];       /* 1 = kasa przyjmuje nowych klientow */
     int register_queue_len[2];       /* Dlugosc kolejki do kasy */
 
-    /* --- Statystyki sprzedazy na kase --- */
-    int register_sales[2][MAX_PRODUCTS];   /* Ilosc sprzedanych szt. */
-    double register_revenue[2];             /* Przychod na kasie */
+    /* --- Statystyki sprzedazy na kase (sztuki per produkt: shm_stats) --- */
+    int64_t register_revenue_gr[2];         /* Przychod na kasie (grosze) */
 
-    /* --- Statystyki produkcji piekarza --- */
-    int baker_produced[MAX_PRODUCTS];
+    /* --- Zarzadzanie procesami klientow --- */
+    int active_customers;      /* Aktywne procesy klientow */
 
-    /* --- Kosz ewakuacyjny przy kasach --- */
-    int basket_items[MAX_PRODUCTS];
+    /* --- Statystyki obslugi klientow --- */
+    int customers_served;      /* Klienci obsluzeni (otrzymali paragon) */
+    int customers_not_served;  /* Klienci nieobsluzeni (timeout/ewakuacja/pusty koszyk) */
 
     /* --- PID-y procesow --- */
     pid_t manager_pid;
@@ -143,18 +279,63 @@ typedef struct {
     int evacuation_mode;       /* 1 = sygnal ewakuacji */
     int simulation_running;    /* 1 = symulacja aktywna */
 
-    /* --- Zegar symulacji --- */
+    /* --- Zegar symulacji (jedyny pisarz: kierownik, seqlock clock_seq) --- */
+    uint32_t clock_seq;
     int sim_hour;
     int sim_min;
 
-    /* --- Zarzadzanie procesami klientow --- */
-    int active_customers;      /* Aktywne procesy klientow */
+    /* --- Licznik tykniec (futex): kierownik zwieksza i budzi czekajacych --- */
+    uint32_t tick;             /* Minuty symulacji od startu petli (monotoniczny) */
+    uint32_t tick_waiters;     /* Procesy uspione w wait_until_tick() */
 
-    /* --- Statystyki obslugi klientow --- */
-    int customers_served;      /* Klienci obsluzeni (otrzymali paragon) */
-    int customers_not_served;  /* Klienci nieobsluzeni (timeout/ewakuacja/pusty koszyk) */
+    /* --- Dziennik zdarzen (journal.c, operacje atomowe) --- */
+    uint64_t journal_capacity; /* Sloty w pliku dziennika (0 = wylaczony) */
+    uint64_t journal_next;     /* Nastepny wolny slot (__atomic_fetch_add) */
+    uint64_t journal_dropped;  /* Zdarzenia odrzucone - plik pelny */
+
+    /* --- Pierwszy dotyk SHM w potomkach (attach_child_ipc, atomowo;
+     *     czasy w HIST_SHM_ATTACH / HIST_SHM_TOUCH) --- */
+    uint64_t shm_touch_faults;  /* Suma minor faults przy pierwszym dotyku */
+
+    /* --- Histogramy opoznien (histogram.c, scalane atomowo) --- */
+    LatencyHist hist[HIST_COUNT];
 } SharedData;
 
+/* Wyrownanie czesci segmentu do linii cache */
+#define SHM_ALIGN(x) (((size_t)(x) + 63) & ~(size_t)63)
+
+/**
+ * Rozmiar segmentu dla P produktow: SharedData, katalog ProductDef[P]
+ * i liczniki ProductStats[P].
+ */
+static inline size_t shm_layout_size(int P)
+{
+    return SHM_ALIGN(sizeof(SharedData)) + SHM_ALIGN(P * sizeof(ProductDef))
+         + SHM_ALIGN(P * sizeof(ProductStats));
+}
+
+/**
+ * Ustawia offsety ogona segmentu dla shm->num_products.
+ */
+static inline void shm_layout_init(SharedData *shm)
+{
+    shm->catalog_off = (uint32_t)SHM_ALIGN(sizeof(SharedData));
+    shm->stats_off   = shm->catalog_off
+                     + (uint32_t)SHM_ALIGN(shm->num_products * sizeof(ProductDef));
+}
+
+/** Katalog produktow [num_products] (w SHM lub w kopii o tym samym ukladzie). */
+static inline ProductDef *shm_products(const SharedData *shm)
+{
+    return (ProductDef *)((uintptr_t)shm + shm->catalog_off);
+}
+
+/** Liczniki produktow [num_products]. */
+static inline ProductStats *shm_stats(const SharedData *shm)
+{
+    return (ProductStats *)((uintptr_t)shm + shm->stats_off);
+}
+
 /* 
  *  STRUKTURY KOMUNIKATOW (kolejki komunikatow IPC)
  */
@@ -171,13 +352,16 @@ struct conveyor_msg {
 
 /**
  * Komunikat checkout (klient -> kasjer).
- * Klient wysyla swoj koszyk do wybranej kasy.
+ * Klient wysyla swoj koszyk do wybranej kasy - num_lines linii
+ * (produkt, ilosc); rozmiar nie zalezy od liczby produktow w katalogu.
  * mtype = register_id + 1 (1 lub 2)
  */
 struct checkout_msg {
     long mtype;
     pid_t customer_pid;
-    int items[MAX_PRODUCTS];
+    int num_lines;
+    uint64_t sent_ns;           /* CLOCK_MONOTONIC wyslania (HIST_CHECKOUT_QUEUE) */
+    BasketLine lines[MAX_BASKET_LINES];
 };
 
 /**
@@ -186,18 +370,61 @@ struct checkout_msg {
  */
 struct receipt_msg {
     long mtype;
-    double total;
-    int items[MAX_PRODUCTS];
+    int64_t total_gr;           /* Kwota paragonu w groszach */
+    int num_lines;
+    uint64_t sent_ns;           /* CLOCK_MONOTONIC wyslania (HIST_RECEIPT) */
+    BasketLine lines[MAX_BASKET_LINES];
 };
 
+/*
+ * Dlugosc komunikatu z n liniami koszyka (z mtype). Kanaly wysylaja tylko
+ * uzyte linie, odbior zawsze do pelnej struktury. Dla msgsnd/msgrcv
+ * (System V) odjac sizeof(long).
+ */
+#define CHECKOUT_MSG_SIZE(n) \
+    (offsetof(struct checkout_msg, lines) + (size_t)(n) * sizeof(BasketLine))
+#define RECEIPT_MSG_SIZE(n) \
+    (offsetof(struct receipt_msg, lines) + (size_t)(n) * sizeof(BasketLine))
+
+/* Jednostka straznika kolejki kas: bajty komunikatu / 4 (sizeof(BasketLine)) */
+#define CHECKOUT_GUARD_UNIT sizeof(BasketLine)
+
+/*
+ *  REKORDY PIPE PIEKARZA (piekarz -> kierownik)
+ */
+
+#define BAKE_REC_BATCH  1   /* Partia jednego produktu */
+#define BAKE_REC_DONE   2   /* Piekarz konczy prace (ostatni rekord) */
+
+/**
+ * Rekord produkcji o stalym rozmiarze - jeden write() na partie.
+ * Zapis <= PIPE_BUF jest atomowy, wiec rekordy watkow piekarza
+ * nie przeplataja sie w pipe.
+ */
+typedef struct {
+    uint8_t  kind;          /* BAKE_REC_BATCH / BAKE_REC_DONE */
+    uint8_t  thread_id;     /* Watek produkcyjny */
+    uint16_t product_id;    /* Indeks produktu */
+    uint16_t quantity;      /* Sztuk zaplanowanych w partii */
+    uint16_t placed;        /* Polozonych na podajniku */
+    uint16_t dropped;       /* Pominietych - podajnik pelny */
+    uint16_t reserved;
+    uint32_t place_us;      /* Czas ukladania partii na podajniku (us) */
+} BakerRecord;
+
+_Static_assert(sizeof(BakerRecord) == 16, "BakerRecord: staly rozmiar 16 B");
+
 /*
  *  DOMYSLNA LISTA PRODUKTOW
  */
 
 #define DEFAULT_NUM_PRODUCTS 1
 
+/* Kwota w groszach z PLN (ceny katalogu, zaokraglenie do grosza) */
+#define PLN_TO_GR(pln) ((int)((pln) * 100.0 + 0.5))
+
 static const ProductDef DEFAULT_PRODUCTS[DEFAULT_NUM_PRODUCTS] = {
-    {"Bulka",            2.00, 100}
+    {"Bulka",            2.00, 100, 1, 0, 200}
 };
 
 /* ================================================================
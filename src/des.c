@@ -0,0 +1,943 @@
+/**
+ * des.c - Silnik symulacji dyskretnej zdarzeniowej
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Czas liczony w minutach symulacji od open_hour:00 (t = 0 - start
+ * piekarza). Tik kierownika k (zegar = k minut) wypada w t = k - 1,
+ * tak jak pierwsza iteracja glownej petli przed msleep_safe().
+ * Zdarzenia o tym samym czasie obslugiwane sa w kolejnosci wstawienia
+ * (licznik seq), wiec przebieg jest deterministyczny dla danego ziarna.
+ *
+ * Uproszczenia wzgledem trybu rzeczywistego: koszt IPC pomijany (czas
+ * trwania operacji = tylko opoznienia modelu), koszt fork+exec klienta
+ * staly (-F), brak ewakuacji/inwentaryzacji i limitu -t.
+ */
+
+#include "des.h"
+#include "histogram.h"
+#include "catalog.h"
+#include "rng.h"
+
+/* ================================================================
+ *  ZDARZENIA I KOPIEC
+ * ================================================================ */
+
+typedef enum {
+    DV_TICK = 0,     /* Tik kierownika (1 min) */
+    DV_TICK_TAIL,    /* Reszta tiku po spawnowaniu klientow (-F) */
+    DV_BAKE,         /* Watek piekarza uklada partie; id = watek */
+    DV_ENTRY,        /* Klient probuje wejsc (sem_trywait SEM_SHOP_ENTRY) */
+    DV_PICK,         /* Klient probuje pobrac sztuke z podajnika */
+    DV_GIVE_UP,      /* Termin rezygnacji na liscie; id = lista */
+    DV_CHECKOUT,     /* Klient idzie do kasy */
+    DV_CASH_POLL,    /* Kasjer sprawdza kolejke; id = kasa */
+    DV_CASH_DONE,    /* Kasjer konczy skanowanie; id = kasa */
+    DV_RECEIPT       /* Klient odbiera paragon */
+} DesEventType;
+
+/* Zdarzenie - 16 bajtow (4 na linie cache) */
+typedef struct {
+    double   t;      /* Czas symulacji (min) */
+    uint32_t key;    /* (kolejnosc wstawienia << 4) | DesEventType */
+    int32_t  id;     /* Klient / kasa / watek / lista / minuta tiku */
+} DesEvent;
+
+#define EV_TYPE(ev) ((ev)->key & 0xF)
+
+/* Klient ma naraz co najwyzej jedno zdarzenie; do tego kasy, watki,
+ * tik i terminy rezygnacji list */
+#define DES_HEAP_CAP (MAX_CUSTOMERS_TOTAL + MAX_PRODUCTS + 16)
+
+#define DES_BAKER_THREADS 2
+#define DES_EPS           1e-9
+
+/* ================================================================
+ *  STAN SYMULACJI
+ * ================================================================ */
+
+typedef struct {
+    int      prod;       /* Produkt z listy zakupow */
+    int      want;       /* Ile sztuk chce */
+    int      got;        /* Ile pobral */
+    uint16_t gen;        /* Numer biezacego czekania (uniewaznia termin) */
+    uint8_t  parked;     /* Lezy na liscie czekajacych (DesPark) */
+    uint8_t  woken;      /* Obudzony z listy - ponowi probe */
+    double   t_start;    /* Start procesu (HIST_VISIT) */
+    double   t_wait;     /* Pierwsza proba biezacego czekania */
+    double   t_deadline; /* Ostatnia proba (limit 5000 / 500 prob) */
+    double   t_chk;      /* Wyslanie checkout_msg */
+    double   t_scan_end; /* Wyslanie paragonu */
+} DesCustomer;
+
+typedef enum { PARK_NONE = 0, PARK_ENTRY, PARK_CONVEYOR } DesPark;
+
+/*
+ * Lista czekajacych (pelny sklep albo pusty podajnik). Klient ponawia
+ * probe przy kolejnym tyknieciu zegara kierownika (wait_until_tick);
+ * zamiast zdarzenia na kazda nieudana probe lezy na liscie. Wszyscy
+ * czekajacy ponawiaja na tej samej siatce minut, wiec lista jest kolejka
+ * FIFO: gdy w chwili t zwolni sie miejsce albo przybedzie towaru,
+ * najdluzej czekajacy ponawia probe przy najblizszym tyknieciu.
+ */
+#define WAIT_CAP (2 * MAX_CUSTOMERS_TOTAL)
+
+typedef struct {
+    int buf[WAIT_CAP];  /* Elementy: buf[head .. head+count-1] */
+    int head, count;
+    int inflight;       /* Obudzeni, ktorzy jeszcze nie ponowili proby */
+
+    /* Terminy rezygnacji: limit prob jest staly, wiec terminy rosna
+     * w kolejnosci rozpoczecia czekania - kolejka FIFO (pierscien)
+     * i jedno zdarzenie DV_GIVE_UP dla jej czola zamiast zdarzenia
+     * na klienta. Wpisy z nieaktualnym gen sa pomijane. */
+    int      tmo_id[WAIT_CAP];
+    uint16_t tmo_gen[WAIT_CAP];
+    int      tmo_head, tmo_count;
+    int      tmo_armed;
+} DesWaitList;
+
+/* i-ty klient listy (przesuwany poczatek - usuwanie z czola bez memmove) */
+#define WL_AT(wl, i) ((wl)->buf[(wl)->head + (i)])
+
+typedef struct {
+    int    ring[MAX_CUSTOMERS_TOTAL]; /* Kolejka komunikatow kasy (FIFO) */
+    int    head, count;
+    int    serving;      /* Obslugiwany klient (-1 = brak) */
+    int    poll_pending; /* Zaplanowane DV_CASH_POLL */
+    double idle_since;   /* Ostatnie puste odpytanie (siatka co 0.5 min) */
+} DesRegister;
+
+static struct {
+    const SharedData *cfg;
+    DesResult   *res;
+    Rng          rng;
+    double       spawn_gap;    /* Koszt fork+exec klienta (min symulacji) */
+
+    DesEvent     heap[DES_HEAP_CAP];
+    int          heap_len;
+    uint32_t     seq;
+
+    DesCustomer  cust[MAX_CUSTOMERS_TOTAL];
+    DesRegister  reg[2];
+    DesWaitList  entry_wait;
+    DesWaitList *conv_wait;    /* [P] - ~100 KB na produkt, alokowane w des_run */
+    int          conv_cap;
+
+    int running, shop_open;
+    int shop_slots;            /* Wartosc SEM_SHOP_ENTRY */
+    int in_shop, active;
+    int conveyor[MAX_PRODUCTS];
+    int accepting[2], open[2], qlen[2];
+    int last_active;
+    double idle_since;      /* Ostatni postep (auto-zamkniecie po 600 min) */
+    int bake_start[DES_BAKER_THREADS], bake_end[DES_BAKER_THREADS];
+    int bake_weight[DES_BAKER_THREADS]; /* Suma wag zakresu watku */
+} g_des;
+
+/*
+ * ev_before - Porzadek kopca: czas, potem kolejnosc wstawienia.
+ */
+static inline int ev_before(const DesEvent *a, const DesEvent *b)
+{
+    return a->t < b->t || (a->t == b->t && a->key < b->key);
+}
+
+/*
+ * des_push - Wstawia zdarzenie do kopca (sift-up).
+ */
+static void des_push(double t, int type, int id)
+{
+    if (g_des.heap_len >= DES_HEAP_CAP) {
+        fprintf(stderr, "[DES] Przepelnienie kopca zdarzen\n");
+        exit(EXIT_FAILURE);
+    }
+
+    DesEvent ev = { t, (g_des.seq++ << 4) | (uint32_t)type, id };
+    int i = g_des.heap_len++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (ev_before(&g_des.heap[parent], &ev))
+            break;
+        g_des.heap[i] = g_des.heap[parent];
+        i = parent;
+    }
+    g_des.heap[i] = ev;
+}
+
+/*
+ * des_pop - Zdejmuje najwczesniejsze zdarzenie (sift-down).
+ */
+static DesEvent des_pop(void)
+{
+    DesEvent top  = g_des.heap[0];
+    DesEvent last = g_des.heap[--g_des.heap_len];
+    int n = g_des.heap_len;
+    int i = 0;
+
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= n) break;
+        if (c + 1 < n && ev_before(&g_des.heap[c + 1], &g_des.heap[c]))
+            c++;
+        if (ev_before(&last, &g_des.heap[c]))
+            break;
+        g_des.heap[i] = g_des.heap[c];
+        i = c;
+    }
+    if (n > 0)
+        g_des.heap[i] = last;
+    return top;
+}
+
+/* ================================================================
+ *  POMOCNICZE
+ * ================================================================ */
+
+static inline int des_below(int n)
+{
+    return rng_below(&g_des.rng, (uint32_t)n);
+}
+
+/*
+ * des_hist - Probka czasu (min symulacji) w us wedlug skali czasu.
+ */
+static void des_hist(int id, double minutes)
+{
+    if (minutes < 0) minutes = 0;
+    hist_record(&g_des.res->hist[id],
+                (uint64_t)(minutes * g_des.cfg->time_scale_ms * 1000.0 + 0.5));
+}
+
+/*
+ * des_next_tick - Najblizsze tykniecie (pelna minuta) nie wczesniejsze
+ * niz t. Kierownik nadrabia zalegle tykniecia (-K catchup), wiec minuta
+ * k zegara przypada na k-1 min od startu petli.
+ */
+static double des_next_tick(double t)
+{
+    double f = (double)(long)t;
+    return (t - f > DES_EPS) ? f + 1.0 : f;
+}
+
+/*
+ * des_grid_next - Pierwszy punkt siatki from + k*step (k >= 0) nie
+ * wczesniejszy niz t (odpytywanie w petli z usleep).
+ */
+static double des_grid_next(double from, double step, double t)
+{
+    if (t <= from) return from;
+    long k = (long)((t - from) / step);
+    if (from + k * step < t - DES_EPS) k++;
+    return from + k * step;
+}
+
+/* ================================================================
+ *  LISTY CZEKAJACYCH
+ * ================================================================ */
+
+/* Numer listy w DV_GIVE_UP: 0 = wejscie, 1 + produkt = podajnik */
+static DesWaitList *wait_list(int lid)
+{
+    return lid == 0 ? &g_des.entry_wait : &g_des.conv_wait[lid - 1];
+}
+
+/*
+ * tmo_arm - Planuje DV_GIVE_UP dla czola kolejki terminow.
+ */
+static void tmo_arm(DesWaitList *wl, int lid)
+{
+    if (wl->tmo_armed || wl->tmo_count == 0) return;
+    wl->tmo_armed = 1;
+    des_push(g_des.cust[wl->tmo_id[wl->tmo_head]].t_deadline, DV_GIVE_UP, lid);
+}
+
+/*
+ * tmo_add - Dopisuje termin nowego czekania; pelny pierscien jest
+ * najpierw kompaktowany (usuniecie nieaktualnych wpisow).
+ */
+static void tmo_add(DesWaitList *wl, int lid, int c)
+{
+    if (wl->tmo_count == WAIT_CAP) {
+        int n = 0;
+        for (int k = 0; k < wl->tmo_count; k++) {
+            int i = (wl->tmo_head + k) % WAIT_CAP;
+            if (g_des.cust[wl->tmo_id[i]].gen == wl->tmo_gen[i]) {
+                wl->tmo_id[n]  = wl->tmo_id[i];
+                wl->tmo_gen[n] = wl->tmo_gen[i];
+                n++;
+            }
+        }
+        wl->tmo_head  = 0;
+        wl->tmo_count = n;
+    }
+
+    int i = (wl->tmo_head + wl->tmo_count) % WAIT_CAP;
+    wl->tmo_id[i]  = c;
+    wl->tmo_gen[i] = g_des.cust[c].gen;
+    wl->tmo_count++;
+    tmo_arm(wl, lid);
+}
+
+/*
+ * wait_park - Klient po nieudanej probie w chwili t trafia na koniec
+ * listy. Pierwsza nieudana proba rozpoczyna czekanie: kolejne proby
+ * przy tyknieciach, rezygnacja po limit-1 tyknieciach (ostatnia proba).
+ */
+static void wait_park(DesPark kind, int c, double t, int limit)
+{
+    DesCustomer *cu = &g_des.cust[c];
+    int lid = (kind == PARK_ENTRY) ? 0 : 1 + cu->prod;
+    DesWaitList *wl = wait_list(lid);
+
+    if (!cu->woken) {
+        /* Nowe czekanie (obudzony zachowuje siatke i termin) */
+        cu->gen++;
+        cu->t_wait     = t;
+        cu->t_deadline = (double)(long)t + (limit - 1);
+        tmo_add(wl, lid, c);
+    }
+    cu->woken  = 0;
+    cu->parked = (uint8_t)kind;
+
+    /* Brak miejsca na koncu bufora - przesun liste na poczatek */
+    if (wl->head + wl->count >= WAIT_CAP) {
+        memmove(&wl->buf[0], &wl->buf[wl->head], wl->count * sizeof(int));
+        wl->head = 0;
+    }
+    WL_AT(wl, wl->count) = c;
+    wl->count++;
+}
+
+/*
+ * wait_remove - Usuwa klienta z pozycji idx listy.
+ */
+static void wait_remove(DesWaitList *wl, int idx)
+{
+    g_des.cust[WL_AT(wl, idx)].parked = PARK_NONE;
+    if (idx < wl->count / 2) {
+        memmove(&wl->buf[wl->head + 1], &wl->buf[wl->head], idx * sizeof(int));
+        wl->head++;
+    } else {
+        memmove(&WL_AT(wl, idx), &WL_AT(wl, idx + 1),
+                (wl->count - idx - 1) * sizeof(int));
+    }
+    wl->count--;
+}
+
+/*
+ * wait_wake - Budzi do n najdluzej czekajacych klientow; probe
+ * ponawiaja przy najblizszym tyknieciu >= t (po pierwszej nieudanej).
+ * Pomijani sa ci, ktorych ostatnia proba wypada wczesniej.
+ */
+static void wait_wake(DesWaitList *wl, double t, int n, int type)
+{
+    double t_tick = des_next_tick(t);
+
+    while (n > 0 && wl->count > 0) {
+        int found = -1;
+        double t_retry = 0.0;
+        for (int k = 0; k < wl->count; k++) {
+            DesCustomer *cu = &g_des.cust[WL_AT(wl, k)];
+            t_retry = (double)(long)cu->t_wait + 1.0;
+            if (t_retry < t_tick) t_retry = t_tick;
+            if (t_retry <= cu->t_deadline + DES_EPS) {
+                found = k;
+                break;
+            }
+        }
+        if (found < 0) return;
+
+        int c = WL_AT(wl, found);
+        wait_remove(wl, found);
+        g_des.cust[c].woken = 1;
+        wl->inflight++;
+        des_push(t_retry, type, c);
+        n--;
+    }
+}
+
+/* ================================================================
+ *  KLIENT - POMOCNICZE
+ * ================================================================ */
+
+/*
+ * customer_exit - Koniec wizyty (finish_visit): HIST_VISIT, active--.
+ */
+static void customer_exit(int c, double t)
+{
+    des_hist(HIST_VISIT, t - g_des.cust[c].t_start);
+    g_des.active--;
+}
+
+/*
+ * customer_leave - Wyjscie ze sklepu (leave_shop): zwolnienie miejsca
+ * budzi czekajacego na wejscie.
+ */
+static void customer_leave(int c, double t)
+{
+    if (g_des.in_shop > 0) g_des.in_shop--;
+    g_des.shop_slots++;
+    customer_exit(c, t);
+
+    DesWaitList *wl = &g_des.entry_wait;
+    if (g_des.shop_slots > wl->inflight)
+        wait_wake(wl, t, g_des.shop_slots - wl->inflight, DV_ENTRY);
+}
+
+/*
+ * register_wake - Klient wyslal komunikat: bezczynny kasjer odbierze
+ * go przy najblizszym odpytaniu ze swojej siatki co 0.5 min.
+ */
+static void register_wake(int r, double t)
+{
+    DesRegister *rg = &g_des.reg[r];
+    if (rg->serving >= 0 || rg->poll_pending) return;
+
+    rg->poll_pending = 1;
+    des_push(des_grid_next(rg->idle_since, 0.5, t), DV_CASH_POLL, r);
+}
+
+/* ================================================================
+ *  OBSLUGA ZDARZEN
+ * ================================================================ */
+
+/*
+ * on_tick_tail - Druga czesc iteracji kierownika: auto-zamkniecie,
+ * zarzadzanie kasami i nastepny tik w terminie z siatki minut (-K catchup:
+ * zalegle tiki po spawnie wykonuja sie od razu).
+ */
+static void on_tick_tail(double t, int minute)
+{
+    DesResult *res = g_des.res;
+
+    /* Auto-zamkniecie po wszystkich klientach / 600 min bez postepu */
+    if (res->total_customers_entered >= MAX_CUSTOMERS_TOTAL) {
+        if (g_des.active == 0) {
+            g_des.running = 0;
+            res->end_minute = minute;
+            return;
+        }
+        if (g_des.last_active < 0) {
+            g_des.last_active = g_des.active;
+            g_des.idle_since  = t;
+        }
+        if (g_des.active < g_des.last_active) {
+            g_des.idle_since  = t;
+            g_des.last_active = g_des.active;
+        }
+        if (t - g_des.idle_since > 600.0) {
+            g_des.running = 0;
+            res->end_minute = minute;
+            return;
+        }
+    }
+
+    /* Zarzadzanie kasami (update_register_state) */
+    int threshold = g_des.cfg->max_customers / 4;
+    if (threshold < 1) threshold = 1;
+    if (g_des.in_shop >= threshold) {
+        if (!g_des.accepting[1]) {
+            g_des.accepting[1] = 1;
+            g_des.open[1]      = 1;
+        }
+    } else if (g_des.accepting[1]) {
+        g_des.accepting[1] = 0;
+    } else if (g_des.open[1] && g_des.qlen[1] == 0) {
+        g_des.open[1] = 0;
+    }
+
+    /* Nastepny termin na siatce minut; spozniony (spawn) - od razu */
+    des_push(t < minute ? (double)minute : t, DV_TICK, minute);
+}
+
+/*
+ * on_tick - Iteracja glownej petli kierownika (kolejnosc jak w main()).
+ * Spawnowanie zajmuje kierownikowi spawn_gap na klienta - tik sie
+ * przeciaga, reszta iteracji wykonuje sie po ostatnim fork(). Czekajacy
+ * w tym czasie ponawiaja proby na siatce minut (w trybie rzeczywistym:
+ * limit awaryjny wait_until_tick - przyblizenie).
+ */
+static void on_tick(double t, int minute)
+{
+    const SharedData *cfg = g_des.cfg;
+    DesResult *res = g_des.res;
+
+    /* Otwarcie sklepu (Tp + 30 min) */
+    if (!g_des.shop_open && minute >= cfg->open_min + 30)
+        g_des.shop_open = 1;
+
+    /* Zamkniecie o Tk - gdy nie ma aktywnych klientow */
+    int close_at = (cfg->close_hour - cfg->open_hour) * 60 + cfg->close_min;
+    if (minute >= close_at &&
+        !(res->total_customers_entered > 0 && g_des.active > 0)) {
+        g_des.running = 0;
+        res->end_minute = minute;
+        return;
+    }
+
+    /* Generowanie klientow (wszystkich naraz przy otwarciu) */
+    int spawned = 0;
+    if (g_des.shop_open) {
+        while (res->total_customers_entered < MAX_CUSTOMERS_TOTAL
+               && g_des.active < MAX_ACTIVE_CUST) {
+            int c = res->total_customers_entered++;
+            DesCustomer *cu = &g_des.cust[c];
+            memset(cu, 0, sizeof(*cu));
+            cu->prod    = catalog_pick(shm_products(cfg), cfg->num_products,
+                                       des_below(cfg->weight_total));
+            cu->want    = rng_cust_qty(&g_des.rng);
+            cu->t_start = t + (++spawned) * g_des.spawn_gap;
+            g_des.active++;
+            des_push(cu->t_start, DV_ENTRY, c);
+        }
+    }
+
+    if (spawned > 0 && g_des.spawn_gap > 0)
+        des_push(t + spawned * g_des.spawn_gap, DV_TICK_TAIL, minute);
+    else
+        on_tick_tail(t, minute);
+}
+
+/*
+ * on_bake - Watek piekarza: partia (bake_batch z katalogu lub 8-20 szt.
+ * kazdego produktu wylosowanego wedlug wag, ile zmiesci podajnik), potem
+ * opoznienie (20-59)*skala/100 ms odsypiane w krokach po 10 ms.
+ */
+static void on_bake(double t, int tid, int place)
+{
+    const SharedData *cfg = g_des.cfg;
+    int start = g_des.bake_start[tid];
+    int range = g_des.bake_end[tid] - start;
+
+    if (place) {
+        const ProductDef *products = shm_products(cfg);
+        int weight = g_des.bake_weight[tid];
+        int num_types = 1 + des_below(range);
+        for (int k = 0; k < num_types; k++) {
+            int prod     = start + (weight > 0 ? catalog_pick(products + start, range,
+                                                              des_below(weight))
+                                               : des_below(range));
+            int quantity = rng_bake_batch(&g_des.rng, products[prod].bake_batch);
+            int space    = shm_products(cfg)[prod].conveyor_capacity - g_des.conveyor[prod];
+            int placed   = quantity < space ? quantity : space;
+            if (placed <= 0) continue;
+
+            g_des.conveyor[prod] += placed;
+            g_des.res->baker_produced[prod] += placed;
+
+            DesWaitList *wl = &g_des.conv_wait[prod];
+            if (g_des.conveyor[prod] > wl->inflight)
+                wait_wake(wl, t, g_des.conveyor[prod] - wl->inflight, DV_PICK);
+        }
+    }
+
+    int delay  = rng_bake_delay_ms(&g_des.rng, cfg->time_scale_ms);
+    int sleeps = (delay + 9) / 10;
+    des_push(t + sleeps * 10.0 / cfg->time_scale_ms, DV_BAKE, tid);
+}
+
+/*
+ * on_entry - Proba wejscia (sem_trywait); pelny sklep - lista
+ * czekajacych (proby co 1 min, maks. 5000).
+ */
+static void on_entry(double t, int c)
+{
+    DesCustomer *cu = &g_des.cust[c];
+    DesWaitList *wl = &g_des.entry_wait;
+
+    if (cu->woken) wl->inflight--;
+
+    if (!g_des.shop_open) {
+        customer_exit(c, t);
+        return;
+    }
+
+    if (g_des.shop_slots > 0) {
+        g_des.shop_slots--;
+        g_des.in_shop++;
+        des_hist(HIST_ENTRY_WAIT, t - cu->t_start);
+        cu->woken = 0;
+        cu->gen++;
+        cu->t_wait = t;
+        des_push(t, DV_PICK, c);
+        return;
+    }
+
+    if (cu->woken && t >= cu->t_deadline - DES_EPS) {
+        g_des.res->customers_not_served++;
+        customer_exit(c, t);
+        return;
+    }
+    wait_park(PARK_ENTRY, c, t, 5000);
+}
+
+/*
+ * on_pick - Pobranie sztuki: sukces kosztuje 0.5 min, pusty podajnik -
+ * lista czekajacych (proby co 1 min, maks. 500 na sztuke).
+ */
+static void on_pick(double t, int c)
+{
+    DesCustomer *cu = &g_des.cust[c];
+    DesWaitList *wl = &g_des.conv_wait[cu->prod];
+
+    if (cu->woken) wl->inflight--;
+
+    if (g_des.conveyor[cu->prod] > 0) {
+        g_des.conveyor[cu->prod]--;
+        cu->got++;
+        des_hist(HIST_CONVEYOR_WAIT, t - cu->t_wait);
+        cu->woken  = 0;
+        cu->gen++;
+        cu->t_wait = t + 0.5;
+        des_push(t + 0.5, cu->got < cu->want ? DV_PICK : DV_CHECKOUT, c);
+        return;
+    }
+
+    if (cu->woken && t >= cu->t_deadline - DES_EPS) {
+        cu->woken = 0;
+        cu->gen++;
+        des_push(t, DV_CHECKOUT, c);
+        return;
+    }
+    wait_park(PARK_CONVEYOR, c, t, 500);
+}
+
+/*
+ * on_give_up - Termin czola kolejki terminow listy lid: klienci, ktorzy
+ * wciaz czekaja po ostatniej probie, rezygnuja - przy wejsciu odchodza,
+ * przy podajniku ida do kasy z tym co maja. Obudzony klient sprawdza
+ * termin sam przy ponowieniu.
+ */
+static void on_give_up(double t, int lid)
+{
+    DesWaitList *wl = wait_list(lid);
+    wl->tmo_armed = 0;
+
+    while (wl->tmo_count > 0) {
+        int c = wl->tmo_id[wl->tmo_head];
+        DesCustomer *cu = &g_des.cust[c];
+        int valid = (cu->gen == wl->tmo_gen[wl->tmo_head]);
+
+        if (valid && cu->t_deadline > t + DES_EPS)
+            break;
+        wl->tmo_head = (wl->tmo_head + 1) % WAIT_CAP;
+        wl->tmo_count--;
+        if (!valid || !cu->parked)
+            continue;
+
+        for (int k = 0; k < wl->count; k++) {
+            if (WL_AT(wl, k) == c) {
+                wait_remove(wl, k);
+                break;
+            }
+        }
+        cu->gen++;
+        if (lid == 0) {
+            g_des.res->customers_not_served++;
+            customer_exit(c, t);
+        } else {
+            des_push(t, DV_CHECKOUT, c);
+        }
+    }
+    tmo_arm(wl, lid);
+}
+
+/*
+ * on_checkout - Wybor kasy (krotsza kolejka, kasa 2 tylko gdy
+ * przyjmuje) i wyslanie koszyka; pusty koszyk = wyjscie.
+ */
+static void on_checkout(double t, int c)
+{
+    DesCustomer *cu = &g_des.cust[c];
+
+    if (cu->got == 0) {
+        g_des.res->customers_not_served++;
+        customer_leave(c, t);
+        return;
+    }
+
+    int r = 0;
+    if (g_des.accepting[1] && g_des.open[1] && g_des.qlen[1] < g_des.qlen[0])
+        r = 1;
+    g_des.qlen[r]++;
+
+    DesRegister *rg = &g_des.reg[r];
+    rg->ring[(rg->head + rg->count) % MAX_CUSTOMERS_TOTAL] = c;
+    rg->count++;
+    cu->t_chk = t;
+    register_wake(r, t);
+}
+
+/*
+ * on_cash_poll - msgrcv(IPC_NOWAIT) kasjera: klient w kolejce albo
+ * pusto (nastepne odpytanie na siatce po 0.5 min - planowane leniwie).
+ */
+static void on_cash_poll(double t, int r)
+{
+    DesRegister *rg = &g_des.reg[r];
+    rg->poll_pending = 0;
+
+    if (rg->count == 0) {
+        rg->idle_since = t;
+        return;
+    }
+
+    int c = rg->ring[rg->head];
+    rg->head = (rg->head + 1) % MAX_CUSTOMERS_TOTAL;
+    rg->count--;
+    rg->serving = c;
+
+    des_hist(HIST_CHECKOUT_QUEUE, t - g_des.cust[c].t_chk);
+    /* 0.05 min na kazda pozycje koszyka (klient kupuje jeden produkt) */
+    des_push(t + 0.05, DV_CASH_DONE, r);
+}
+
+/*
+ * on_cash_done - Koniec skanowania: sprzedaz, paragon, kolejka--.
+ * Klient odpytuje co 0.3 min od wyslania koszyka (maks. 2000 razy).
+ */
+static void on_cash_done(double t, int r)
+{
+    DesRegister *rg = &g_des.reg[r];
+    DesResult *res = g_des.res;
+    int c = rg->serving;
+    DesCustomer *cu = &g_des.cust[c];
+
+    res->register_sales[r][cu->prod] += cu->got;
+    res->register_revenue_gr[r] += (int64_t)cu->got * shm_products(g_des.cfg)[cu->prod].price_gr;
+    des_hist(HIST_SCAN, 0.05);
+    if (g_des.qlen[r] > 0) g_des.qlen[r]--;
+
+    cu->t_scan_end = t;
+    double t_rcpt = des_grid_next(cu->t_chk, 0.3, t);
+    if (t_rcpt - cu->t_chk > 2000 * 0.3 + DES_EPS) {
+        res->customers_not_served++;
+        customer_leave(c, t);
+    } else {
+        des_push(t_rcpt, DV_RECEIPT, c);
+    }
+
+    rg->serving      = -1;
+    rg->poll_pending = 1;
+    des_push(t, DV_CASH_POLL, r);
+}
+
+/*
+ * on_receipt - Klient odebral paragon i wychodzi.
+ */
+static void on_receipt(double t, int c)
+{
+    g_des.res->customers_served++;
+    des_hist(HIST_RECEIPT, t - g_des.cust[c].t_scan_end);
+    customer_leave(c, t);
+}
+
+/* ================================================================
+ *  PRZEBIEG
+ * ================================================================ */
+
+/*
+ * des_run - Jeden przebieg: stan poczatkowy jak init_shared_data(),
+ * petla zdarzen do zakonczenia przez tik kierownika.
+ */
+void des_run(const SharedData *cfg, const DesOptions *opt, int run,
+             DesResult *res)
+{
+    memset(res, 0, sizeof(*res));
+    g_des.cfg  = cfg;
+    g_des.res  = res;
+    rng_seed(&g_des.rng, opt->seed, RNG_STREAM_DES, (uint64_t)run);
+    g_des.spawn_gap = opt->fork_us / 1000.0 / cfg->time_scale_ms;
+    g_des.heap_len  = 0;
+    g_des.seq       = 0;
+
+    g_des.running    = 1;
+    g_des.shop_open  = 0;
+    g_des.shop_slots = cfg->max_customers;
+    g_des.in_shop    = 0;
+    g_des.active     = 0;
+    g_des.idle_since  = 0.0;
+    g_des.last_active = -1;
+    int P = cfg->num_products;
+    if (g_des.conv_cap < P) {
+        free(g_des.conv_wait);
+        g_des.conv_wait = calloc(P, sizeof(DesWaitList));
+        if (g_des.conv_wait == NULL) {
+            fprintf(stderr, "[DES] Brak pamieci na listy podajnikow (P=%d)\n", P);
+            exit(EXIT_FAILURE);
+        }
+        g_des.conv_cap = P;
+    }
+    for (int lid = 0; lid <= P; lid++) {
+        DesWaitList *wl = wait_list(lid);
+        wl->head = wl->count = wl->inflight = 0;
+        wl->tmo_head = wl->tmo_count = wl->tmo_armed = 0;
+    }
+    memset(g_des.conveyor, 0, sizeof(g_des.conveyor));
+    for (int r = 0; r < 2; r++) {
+        g_des.accepting[r] = 1;
+        g_des.open[r]      = 1;
+        g_des.qlen[r]      = 0;
+        g_des.reg[r].head = g_des.reg[r].count = 0;
+        g_des.reg[r].serving      = -1;
+        g_des.reg[r].poll_pending = 0;
+        g_des.reg[r].idle_since   = 0.0;
+    }
+
+    /* Piekarz: 2 watki (1 przy P=1), produkty podzielone na polowy */
+    int threads = (P >= 2) ? DES_BAKER_THREADS : 1;
+    int half = (P + 1) / 2;
+    for (int i = 0; i < threads; i++) {
+        g_des.bake_start[i] = (i == 0) ? 0 : half;
+        g_des.bake_end[i]   = (i == 0) ? half : P;
+        g_des.bake_weight[i] = catalog_weight(shm_products(cfg), g_des.bake_start[i],
+                                              g_des.bake_end[i]);
+        on_bake(0.0, i, 0);
+    }
+
+    des_push(0.0, DV_TICK, 0);
+
+    while (g_des.running && g_des.heap_len > 0) {
+        DesEvent ev = des_pop();
+        res->events++;
+
+        switch (EV_TYPE(&ev)) {
+            case DV_TICK:      on_tick(ev.t, ev.id + 1);     break;
+            case DV_TICK_TAIL: on_tick_tail(ev.t, ev.id);    break;
+            case DV_BAKE:      on_bake(ev.t, ev.id, 1);      break;
+            case DV_ENTRY:     on_entry(ev.t, ev.id);        break;
+            case DV_PICK:      on_pick(ev.t, ev.id);         break;
+            case DV_GIVE_UP:   on_give_up(ev.t, ev.id);      break;
+            case DV_CHECKOUT:  on_checkout(ev.t, ev.id);     break;
+            case DV_CASH_POLL: on_cash_poll(ev.t, ev.id);    break;
+            case DV_CASH_DONE: on_cash_done(ev.t, ev.id);    break;
+            case DV_RECEIPT:   on_receipt(ev.t, ev.id);      break;
+        }
+    }
+
+    for (int i = 0; i < P; i++)
+        res->conveyor_left[i] = g_des.conveyor[i];
+}
+
+/* ================================================================
+ *  RAPORT
+ * ================================================================ */
+
+/*
+ * print_run_report - Sekcje jak w generate_report() kierownika.
+ */
+static void print_run_report(FILE *out, const SharedData *cfg, const DesResult *res)
+{
+    fprintf(out,
+        "--- KONFIGURACJA ---\n"
+        "Produktow: %d\n"
+        "Maks. klientow w sklepie: %d\n"
+        "Godziny: %02d:%02d - %02d:%02d\n"
+        "Skala czasu: %d ms/min (przeliczenie opoznien)\n\n",
+        cfg->num_products, cfg->max_customers,
+        cfg->open_hour, cfg->open_min, cfg->close_hour, cfg->close_min,
+        cfg->time_scale_ms);
+
+    fprintf(out,
+        "--- STATYSTYKI OGOLNE ---\n"
+        "Laczna liczba klientow: %d\n"
+        "Obsluzonych (paragon):  %d\n"
+        "Nieobsluzonych:         %d\n"
+        "Koniec symulacji: %02d:%02d\n\n",
+        res->total_customers_entered, res->customers_served,
+        res->customers_not_served,
+        cfg->open_hour + res->end_minute / 60, res->end_minute % 60);
+
+    fprintf(out, "--- PRODUKCJA PIEKARZA ---\n");
+    int total_produced = 0;
+    for (int i = 0; i < cfg->num_products; i++) {
+        fprintf(out, "  %-20s: %d szt.\n",
+                shm_products(cfg)[i].name, res->baker_produced[i]);
+        total_produced += res->baker_produced[i];
+    }
+    fprintf(out, "  RAZEM: %d szt.\n\n", total_produced);
+
+    for (int r = 0; r < 2; r++) {
+        fprintf(out, "--- KASA NR %d - PODSUMOWANIE ---\n", r + 1);
+        int total_sold = 0;
+        for (int i = 0; i < cfg->num_products; i++) {
+            if (res->register_sales[r][i] > 0) {
+                fprintf(out, "  %-20s: %d szt. (%.2f PLN)\n",
+                        shm_products(cfg)[i].name, res->register_sales[r][i],
+                        (int64_t)res->register_sales[r][i] * shm_products(cfg)[i].price_gr / 100.0);
+                total_sold += res->register_sales[r][i];
+            }
+        }
+        fprintf(out, "  RAZEM: %d szt., PRZYCHOD: %.2f PLN\n\n",
+                total_sold, res->register_revenue_gr[r] / 100.0);
+    }
+
+    fprintf(out, "--- STAN PODAJNIKOW ---\n");
+    int total_remaining = 0;
+    for (int i = 0; i < cfg->num_products; i++) {
+        fprintf(out, "  %-20s: %d szt. (pojemnosc: %d)\n",
+                shm_products(cfg)[i].name, res->conveyor_left[i],
+                shm_products(cfg)[i].conveyor_capacity);
+        total_remaining += res->conveyor_left[i];
+    }
+    fprintf(out, "  RAZEM na podajnikach: %d szt.\n\n", total_remaining);
+
+    fprintf(out, "--- OPOZNIENIA (ms) ---\n");
+    for (int h = 0; h < HIST_COUNT; h++) {
+        char line[160];
+        hist_format(line, sizeof(line), &res->hist[h]);
+        fprintf(out, "  %-15s: %s\n", hist_name(h), line);
+    }
+    fprintf(out, "\n");
+}
+
+/*
+ * des_simulate - Seria przebiegow (strumienie 0, 1, ... ziarna) z pomiarem
+ * czasu rzeczywistego.
+ */
+int des_simulate(const SharedData *cfg, const DesOptions *opt, FILE *out)
+{
+    static DesResult first, cur;
+    uint64_t visits = 0, events = 0;
+    int served_min = 0, served_max = 0;
+    double served_sum = 0.0;
+
+    uint64_t t0 = hist_now_ns();
+    for (int i = 0; i < opt->runs; i++) {
+        DesResult *res = (i == 0) ? &first : &cur;
+        des_run(cfg, opt, i, res);
+
+        visits += (uint64_t)res->total_customers_entered;
+        events += res->events;
+        served_sum += res->customers_served;
+        if (i == 0 || res->customers_served < served_min)
+            served_min = res->customers_served;
+        if (i == 0 || res->customers_served > served_max)
+            served_max = res->customers_served;
+    }
+    double wall_s = (double)(hist_now_ns() - t0) / 1e9;
+    if (wall_s <= 0) wall_s = 1e-9;
+
+    fprintf(out,
+        "============================================\n"
+        "  RAPORT CIASTKARNI - CZAS WIRTUALNY (DES)\n"
+        "  Przebieg 1/%d, ziarno %llu (-S), fork+exec %d us\n"
+        "============================================\n\n",
+        opt->runs, (unsigned long long)opt->seed, opt->fork_us);
+    print_run_report(out, cfg, &first);
+
+    fprintf(out,
+        "--- TRYB WIRTUALNY ---\n"
+        "Przebiegow: %d\n"
+        "Obsluzonych (srednio): %.1f (min %d, max %d)\n"
+        "Zdarzen: %llu (%.1f na wizyte)\n"
+        "Czas rzeczywisty: %.3f s\n"
+        "Przepustowosc: %.0f wizyt/s, %.0f zdarzen/s\n"
+        "============================================\n",
+        opt->runs, served_sum / opt->runs, served_min, served_max,
+        (unsigned long long)events,
+        visits ? (double)events / (double)visits : 0.0,
+        wall_s, (double)visits / wall_s, (double)events / wall_s);
+
+    return EXIT_SUCCESS;
+}
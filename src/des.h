@@ -0,0 +1,66 @@
+/**
+ * des.h - Symulacja dyskretna zdarzeniowa ("czas wirtualny")
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Ten sam model co tryb rzeczywisty (kierownik, piekarz, kasjerzy,
+ * klienci), ale bez procesow, IPC i usleep(): zdarzenia ze znacznikiem
+ * czasu symulacji trafiaja do kopca binarnego, a zegar przeskakuje
+ * od razu do najblizszego. Opoznienia modelu (proby co 1 min, pobranie
+ * 0.5 min, skanowanie 0.05 min, odpytywanie paragonu co 0.3 min, kasa
+ * co 0.5 min) sa odwzorowane 1:1, a histogramy przeliczane sa na us
+ * wedlug time_scale_ms - raport mozna porownac z trybem rzeczywistym.
+ *
+ * Uruchomienie: ./kierownik -V RUNS [opcje modelu]
+ */
+
+#ifndef DES_H
+#define DES_H
+
+#include "common.h"
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * Wynik jednego przebiegu (odpowiednik statystyk z SharedData).
+ */
+typedef struct {
+    int      total_customers_entered;
+    int      customers_served;
+    int      customers_not_served;
+    int      baker_produced[MAX_PRODUCTS];
+    int      register_sales[2][MAX_PRODUCTS];
+    int64_t  register_revenue_gr[2];       /* Grosze, jak SharedData */
+    int      conveyor_left[MAX_PRODUCTS];  /* Sztuki na podajnikach na koncu */
+    int      end_minute;                   /* Minuta zakonczenia (od open_hour:00) */
+    uint64_t events;                       /* Obsluzone zdarzenia */
+    LatencyHist hist[HIST_COUNT];          /* Jak SharedData.hist (us przy skali) */
+} DesResult;
+
+/**
+ * Parametry serii przebiegow (-V, -F).
+ */
+typedef struct {
+    int          runs;     /* Liczba przebiegow */
+    uint64_t     seed;     /* Ziarno (-S); przebieg i = strumien RNG_STREAM_DES i */
+    int          fork_us;  /* Koszt fork+exec klienta (us) - kierownik
+                              spawnuje sekwencyjnie przy zatrzymanym zegarze */
+} DesOptions;
+
+/**
+ * Wykonuje jeden przebieg symulacji dla konfiguracji cfg
+ * (num_products, products[], max_customers, time_scale_ms, godziny).
+ * @param run Numer przebiegu - strumien RNG_STREAM_DES ziarna opt->seed
+ *            (ten sam seed i run = ten sam wynik)
+ */
+void des_run(const SharedData *cfg, const DesOptions *opt, int run,
+             DesResult *res);
+
+/**
+ * Wykonuje opt->runs przebiegow, drukuje raport pierwszego przebiegu
+ * (sekcje jak w raporcie kierownika), rozrzut miedzy przebiegami
+ * i przepustowosc (wizyt/s czasu rzeczywistego).
+ * @return EXIT_SUCCESS
+ */
+int des_simulate(const SharedData *cfg, const DesOptions *opt, FILE *out);
+
+#endif /* DES_H */
@@ -0,0 +1,177 @@
+/**
+ * histogram.c - Implementacja histogramow opoznien
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Indeks kubelka: wartosci < 16 us maja wlasne kubelki, wieksze - 16
+ * podkubelkow na kazda potege dwojki (mantysa 4 bity + wykladnik).
+ */
+
+#include "histogram.h"
+
+static const char *const HIST_NAMES[HIST_COUNT] = {
+    [HIST_ENTRY_WAIT]     = "entry_wait",
+    [HIST_CONVEYOR_WAIT]  = "conveyor_wait",
+    [HIST_CHECKOUT_QUEUE] = "checkout_queue",
+    [HIST_SCAN]           = "scan",
+    [HIST_RECEIPT]        = "receipt",
+    [HIST_VISIT]          = "visit",
+    [HIST_STARTUP]        = "startup",
+    [HIST_SHM_ATTACH]     = "shm_attach",
+    [HIST_SHM_TOUCH]      = "shm_touch",
+};
+
+/*
+ * bucket_index - Numer kubelka dla wartosci (obciety do ostatniego).
+ */
+static int bucket_index(uint64_t v)
+{
+    if (v < HIST_SUB_COUNT)
+        return (int)v;
+
+    int msb   = 63 - __builtin_clzll(v);
+    int shift = msb - HIST_SUB_BITS;
+    int idx   = (shift + 1) * HIST_SUB_COUNT
+              + (int)((v >> shift) - HIST_SUB_COUNT);
+    return idx < HIST_BUCKETS ? idx : HIST_BUCKETS - 1;
+}
+
+/*
+ * bucket_upper - Najwieksza wartosc nalezaca do kubelka.
+ */
+static uint64_t bucket_upper(int idx)
+{
+    if (idx < HIST_SUB_COUNT)
+        return (uint64_t)idx;
+
+    int shift  = idx / HIST_SUB_COUNT - 1;
+    uint64_t m = (uint64_t)(idx % HIST_SUB_COUNT + HIST_SUB_COUNT);
+    return ((m + 1) << shift) - 1;
+}
+
+/*
+ * hist_record - Probka do lokalnego histogramu (bez synchronizacji).
+ */
+void hist_record(LatencyHist *h, uint64_t value_us)
+{
+    h->buckets[bucket_index(value_us)]++;
+    h->count++;
+    h->sum_us += value_us;
+    if (value_us > h->max_us)
+        h->max_us = value_us;
+}
+
+/*
+ * hist_record_since - Probka z dwoch znacznikow czasu (ns).
+ */
+void hist_record_since(LatencyHist *h, uint64_t from_ns, uint64_t to_ns)
+{
+    if (from_ns == 0 || to_ns < from_ns)
+        return;
+    hist_record(h, (to_ns - from_ns) / 1000);
+}
+
+/*
+ * hist_merge - Scalenie do SHM: fetch_add na niezerowych kubelkach,
+ * maksimum przez petle compare-exchange.
+ */
+void hist_merge(LatencyHist *shared, const LatencyHist *local)
+{
+    if (local->count == 0)
+        return;
+
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        if (local->buckets[i] != 0)
+            __atomic_fetch_add(&shared->buckets[i], local->buckets[i],
+                               __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&shared->sum_us, local->sum_us, __ATOMIC_RELAXED);
+
+    uint64_t cur = __atomic_load_n(&shared->max_us, __ATOMIC_RELAXED);
+    while (local->max_us > cur &&
+           !__atomic_compare_exchange_n(&shared->max_us, &cur, local->max_us,
+                                        1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    /* count na koncu - czytelnik widzi kubelki co najmniej tak pelne jak count */
+    __atomic_fetch_add(&shared->count, local->count, __ATOMIC_RELEASE);
+}
+
+/*
+ * hist_record_shared - Jedna probka atomowo (bez lokalnej kopii i scalania).
+ */
+void hist_record_shared(LatencyHist *shared, uint64_t from_ns, uint64_t to_ns)
+{
+    if (from_ns == 0 || to_ns < from_ns)
+        return;
+    uint64_t us = (to_ns - from_ns) / 1000;
+
+    __atomic_fetch_add(&shared->buckets[bucket_index(us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&shared->sum_us, us, __ATOMIC_RELAXED);
+    uint64_t cur = __atomic_load_n(&shared->max_us, __ATOMIC_RELAXED);
+    while (us > cur &&
+           !__atomic_compare_exchange_n(&shared->max_us, &cur, us,
+                                        1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+    __atomic_fetch_add(&shared->count, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * hist_percentile - Percentyl z kubelkow (gorna granica, max jako sufit).
+ */
+uint64_t hist_percentile(const LatencyHist *h, double p)
+{
+    uint64_t count = __atomic_load_n(&h->count, __ATOMIC_ACQUIRE);
+    if (count == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t)(p * (double)count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+
+    uint64_t max = __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            uint64_t up = bucket_upper(i);
+            return up < max ? up : max;
+        }
+    }
+    return max;
+}
+
+/*
+ * hist_count_le - Suma kubelkow, ktorych gorna granica <= limit_us.
+ */
+uint64_t hist_count_le(const LatencyHist *h, uint64_t limit_us)
+{
+    uint64_t n = 0;
+    for (int i = 0; i < HIST_BUCKETS && bucket_upper(i) <= limit_us; i++)
+        n += __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+    return n;
+}
+
+/*
+ * hist_name - Nazwa histogramu do raportow.
+ */
+const char *hist_name(int id)
+{
+    if (id < 0 || id >= HIST_COUNT)
+        return "?";
+    return HIST_NAMES[id];
+}
+
+/*
+ * hist_format - Jedna linia podsumowania w milisekundach.
+ */
+int hist_format(char *buf, size_t size, const LatencyHist *h)
+{
+    return snprintf(buf, size,
+                    "n=%llu p50=%.3f p90=%.3f p99=%.3f p99.9=%.3f max=%.3f",
+                    (unsigned long long)__atomic_load_n(&h->count, __ATOMIC_ACQUIRE),
+                    hist_percentile(h, 0.50) / 1000.0,
+                    hist_percentile(h, 0.90) / 1000.0,
+                    hist_percentile(h, 0.99) / 1000.0,
+                    hist_percentile(h, 0.999) / 1000.0,
+                    __atomic_load_n(&h->max_us, __ATOMIC_RELAXED) / 1000.0);
+}
@@ -0,0 +1,70 @@
+/**
+ * histogram.h - Histogramy opoznien z kubelkami logarytmicznymi
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Kazdy proces zapisuje probki do lokalnej kopii (bez synchronizacji),
+ * a przy wyjsciu scala ja do SharedData.hist[] operacjami atomowymi -
+ * bez semafora SEM_SHM_MUTEX. Raport i check_shm wyliczaja percentyle
+ * p50/p90/p99/p99.9 z kubelkow.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "common.h"
+#include <stdint.h>
+
+/** Aktualny czas CLOCK_MONOTONIC w nanosekundach. */
+static inline uint64_t hist_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Dodaje probke (w mikrosekundach) do lokalnego histogramu.
+ */
+void hist_record(LatencyHist *h, uint64_t value_us);
+
+/**
+ * Dodaje probke - roznice dwoch znacznikow hist_now_ns().
+ * Probki z ujemnym czasem (zegary z roznych maszyn) sa pomijane.
+ */
+void hist_record_since(LatencyHist *h, uint64_t from_ns, uint64_t to_ns);
+
+/**
+ * Pojedyncza probka (roznica znacznikow ns) wprost do histogramu
+ * wspoldzielonego - atomowo, dla procesow mierzacych jedno zdarzenie.
+ */
+void hist_record_shared(LatencyHist *shared, uint64_t from_ns, uint64_t to_ns);
+
+/**
+ * Scala lokalny histogram do wspoldzielonego (atomowo, bez blokad).
+ */
+void hist_merge(LatencyHist *shared, const LatencyHist *local);
+
+/**
+ * Wartosc percentyla (0.0-1.0) w mikrosekundach - gorna granica kubelka,
+ * ograniczona przez max. Zwraca 0 dla pustego histogramu.
+ */
+uint64_t hist_percentile(const LatencyHist *h, double p);
+
+/**
+ * Liczba probek <= limit_us (dokladna, gdy limit_us jest gorna granica
+ * kubelka, np. 2^k - 1). Do kumulatywnych kubelkow Prometheusa.
+ */
+uint64_t hist_count_le(const LatencyHist *h, uint64_t limit_us);
+
+/**
+ * Nazwa histogramu (np. "entry_wait").
+ */
+const char *hist_name(int id);
+
+/**
+ * Formatuje podsumowanie "n=.. p50=.. p90=.. p99=.. p99.9=.. max=.." (ms).
+ * @return Liczba zapisanych znakow (jak snprintf)
+ */
+int hist_format(char *buf, size_t size, const LatencyHist *h);
+
+#endif /* HISTOGRAM_H */
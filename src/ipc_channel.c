@@ -0,0 +1,572 @@
+/**
+ * ipc_channel.c - Backendy kanalow IPC: System V i POSIX
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Backend sysv opakowuje dotychczasowe kolejki z semaforami-straznikami
+ * (msgsnd_guarded / msgrcv_guarded); podajniki dziela jedna kolejke
+ * (mtype = produkt) albo - z -Q - maja kolejke i straznika na produkt,
+ * wiec msgrcv nie przeszukuje cudzych komunikatow. Backend posix tworzy kolejke
+ * mq_open() na kazdy podajnik (mq_maxmsg = Ki) i kase (mq_maxmsg = N),
+ * wiec glebokosc ogranicza sam kernel, a mq_send() blokuje przy pelnej
+ * kolejce. Deskryptory potomkow sa otwierane leniwie przy pierwszym
+ * uzyciu - klient otwiera tylko podajniki ze swojej listy zakupow.
+ *
+ * Uklad -r R (oba backendy dla paragonow): kasa ma wlasna kolejke
+ * i straznika, a paragony ida do jednej z R kolejek wg PID % R - kasjerzy
+ * nie dziela blokady kolejki, a msgrcv(PID) przeszukuje ~1/R paragonow.
+ *
+ * Koszyki i paragony maja zmienna dlugosc (CHECKOUT_MSG_SIZE(n)) - wysylane
+ * sa tylko uzyte linie, a straznik kolejki kas liczy bajty w jednostkach
+ * CHECKOUT_GUARD_UNIT zamiast pelnych komunikatow.
+ */
+
+#include "ipc_channel.h"
+#include "ipc_utils.h"
+#include "error_handler.h"
+#include <mqueue.h>
+#include <semaphore.h>
+
+/* ================================================================
+ *  STAN PROCESU (wspolny dla backendow)
+ * ================================================================ */
+
+static int g_sem_id     = -1;
+static int g_num_prod   = 0;
+static int g_mq_conv    = -1;   /* sysv: kolejka podajnikow */
+static int g_mq_conv_prod[MAX_CONV_QUEUES]; /* sysv -Q: kolejka podajnika i */
+static int g_conv_split = 0;    /* sysv: 1 = kolejka na produkt (-Q) */
+static int g_mq_chkout[NUM_REGISTERS];     /* sysv: kolejki kas (-r: na kase) */
+static int g_num_chkout = 1;
+static int g_mq_rcpt[MAX_RECEIPT_SHARDS];  /* oba backendy: paragony (System V) */
+static int g_num_rcpt   = 1;
+
+static mqd_t g_px_conv[MAX_PRODUCTS];
+static mqd_t g_px_chkout[NUM_REGISTERS];
+static sem_t *g_px_entry = SEM_FAILED;
+
+/* ================================================================
+ *  PARAGONY (System V w obu backendach, shard = PID % R)
+ * ================================================================ */
+
+static void rcpt_setup(const SharedData *shm)
+{
+    g_num_rcpt = (shm->queue_shards > 0) ? shm->queue_shards : 1;
+}
+
+/*
+ * rcpt_create - Kolejki paragonow. Kazdy shard na N paragonow: PID % R
+ * nie ogranicza liczby klientow w jednym shardzie, a pelny shard gubi
+ * paragon (kasjer wysyla z IPC_NOWAIT). msg_qbytes to tylko limit -
+ * bajty nie sa rezerwowane.
+ */
+static void rcpt_create(const SharedData *shm, const char *keyfile)
+{
+    rcpt_setup(shm);
+    int slots = shm->max_customers;
+    for (int s = 0; s < g_num_rcpt; s++) {
+        char label[32];
+        snprintf(label, sizeof(label), g_num_rcpt > 1 ? "paragonow %d" : "paragonow", s);
+        g_mq_rcpt[s] = create_message_queue(keyfile, PROJ_MQ_RCPT_SHARD(s));
+        size_message_queue(g_mq_rcpt[s], slots, sizeof(struct receipt_msg), label);
+    }
+}
+
+static void rcpt_attach(const SharedData *shm, const char *keyfile)
+{
+    rcpt_setup(shm);
+    for (int s = 0; s < g_num_rcpt; s++)
+        g_mq_rcpt[s] = shm->boot.ready ? shm->boot.mq_rcpt[s]
+                                       : get_message_queue(keyfile, PROJ_MQ_RCPT_SHARD(s));
+}
+
+/*
+ * boot_publish - Zapis identyfikatorow kolejek do bloku startowego
+ * (kierownik ustawia boot.ready po wpisaniu shm_id).
+ */
+static void boot_publish(SharedData *shm, int sem_id)
+{
+    shm->boot.sem_id  = sem_id;
+    shm->boot.mq_conv = g_mq_conv;
+    memcpy(shm->boot.mq_conv_prod, g_mq_conv_prod, sizeof(g_mq_conv_prod));
+    memcpy(shm->boot.mq_chkout, g_mq_chkout, sizeof(g_mq_chkout));
+    memcpy(shm->boot.mq_rcpt, g_mq_rcpt, sizeof(g_mq_rcpt));
+}
+
+static int rcpt_queue(pid_t pid)
+{
+    return g_mq_rcpt[(unsigned int)pid % (unsigned int)g_num_rcpt];
+}
+
+static int sysv_receipt_send(const struct receipt_msg *msg)
+{
+    if (msgsnd(rcpt_queue((pid_t)msg->mtype), msg,
+               RECEIPT_MSG_SIZE(msg->num_lines) - sizeof(long), IPC_NOWAIT) == 0)
+        return 0;
+    if (errno == EAGAIN) errno = ENOMSG;
+    else if (errno == EINVAL) errno = EIDRM;
+    return -1;
+}
+
+static int sysv_receipt_take(pid_t pid, struct receipt_msg *msg)
+{
+    ssize_t ret = msgrcv(rcpt_queue(pid), msg, sizeof(*msg) - sizeof(long),
+                         (long)pid, IPC_NOWAIT);
+    return (ret >= 0) ? 0 : -1;
+}
+
+/* ================================================================
+ *  BACKEND SYSTEM V
+ * ================================================================ */
+
+/*
+ * sysv_create_split - Uklad -Q: kolejka PROJ_MQ_CONV_PROD(i) na podajnik,
+ * msg_qbytes na Ki sztuk i wlasny straznik SEM_GUARD_CONV_PROD(P, i).
+ */
+static void sysv_create_split(SharedData *shm, const char *keyfile, int sem_id)
+{
+    int P = shm->num_products;
+    for (int i = 0; i < P; i++) {
+        char label[MAX_NAME_LEN + 16];
+        snprintf(label, sizeof(label), "podajnika %d", i);
+        g_mq_conv_prod[i] = create_message_queue(keyfile, PROJ_MQ_CONV_PROD(i));
+        size_message_queue(g_mq_conv_prod[i], shm_products(shm)[i].conveyor_capacity,
+                           sizeof(struct conveyor_msg), label);
+        init_semaphore(sem_id, SEM_GUARD_CONV_PROD(P, i),
+                       calc_queue_guard_init(g_mq_conv_prod[i],
+                                             sizeof(struct conveyor_msg)));
+    }
+}
+
+/* Straznik kolejki kas q (q = 0: kolejka wspolna lub kasy 0) */
+static int sysv_chkout_guard(int q)
+{
+    return (q == 0) ? SEM_GUARD_CHKOUT(g_num_prod)
+                    : SEM_GUARD_CHKOUT_REG(g_num_prod, q);
+}
+
+static int sysv_create(SharedData *shm, const char *keyfile, int sem_id)
+{
+    int P = shm->num_products;
+    g_sem_id     = sem_id;
+    g_num_prod   = P;
+    g_conv_split = shm->conveyor_queues;
+    g_num_chkout = (shm->queue_shards > 0) ? NUM_REGISTERS : 1;
+
+    if (g_conv_split) {
+        sysv_create_split(shm, keyfile, sem_id);
+    } else {
+        /* msg_qbytes: wszystkie podajniki pelne naraz */
+        int conv_slots = 0;
+        for (int i = 0; i < P; i++)
+            conv_slots += shm_products(shm)[i].conveyor_capacity;
+        g_mq_conv = create_message_queue(keyfile, PROJ_MQ_CONV);
+        size_message_queue(g_mq_conv, conv_slots, sizeof(struct conveyor_msg),
+                           "podajnikow");
+        init_semaphore(sem_id, SEM_GUARD_CONV(P),
+                       calc_queue_guard_init(g_mq_conv, sizeof(struct conveyor_msg)));
+    }
+
+    /* Kasy: kazdy klient w sklepie moze stac w jednej kolejce. Kolejka
+     * na N pelnych koszykow, straznik liczy bajty (koszyki maja 1..8 linii) */
+    for (int q = 0; q < g_num_chkout; q++) {
+        char label[32];
+        snprintf(label, sizeof(label), g_num_chkout > 1 ? "kasy %d" : "kas", q);
+        g_mq_chkout[q] = create_message_queue(keyfile, PROJ_MQ_CHKOUT_REG(q));
+        size_message_queue(g_mq_chkout[q], shm->max_customers,
+                           sizeof(struct checkout_msg), label);
+        init_semaphore(sem_id, sysv_chkout_guard(q),
+                       calc_queue_guard_init(g_mq_chkout[q], CHECKOUT_GUARD_UNIT));
+    }
+
+    rcpt_create(shm, keyfile);
+    init_semaphore(sem_id, SEM_GUARD_RCPT(P),
+                   calc_queue_guard_init(g_mq_rcpt[0], sizeof(struct receipt_msg)));
+    boot_publish(shm, sem_id);
+    return 0;
+}
+
+static int sysv_attach(SharedData *shm, const char *keyfile, int sem_id)
+{
+    g_sem_id     = sem_id;
+    g_num_prod   = shm->num_products;
+    g_conv_split = shm->conveyor_queues;
+    g_num_chkout = (shm->queue_shards > 0) ? NUM_REGISTERS : 1;
+    rcpt_attach(shm, keyfile);
+    if (shm->boot.ready) {
+        g_mq_conv = shm->boot.mq_conv;
+        memcpy(g_mq_conv_prod, shm->boot.mq_conv_prod, sizeof(g_mq_conv_prod));
+        memcpy(g_mq_chkout, shm->boot.mq_chkout, sizeof(g_mq_chkout));
+        return 0;
+    }
+    if (g_conv_split) {
+        for (int i = 0; i < g_num_prod; i++)
+            g_mq_conv_prod[i] = get_message_queue(keyfile, PROJ_MQ_CONV_PROD(i));
+    } else {
+        g_mq_conv = get_message_queue(keyfile, PROJ_MQ_CONV);
+    }
+    for (int q = 0; q < g_num_chkout; q++)
+        g_mq_chkout[q] = get_message_queue(keyfile, PROJ_MQ_CHKOUT_REG(q));
+    return 0;
+}
+
+/* Kolejka i straznik podajnika (mtype = product + 1 w obu ukladach) */
+static int sysv_conv_queue(int product, int *guard)
+{
+    if (g_conv_split) {
+        *guard = SEM_GUARD_CONV_PROD(g_num_prod, product);
+        return g_mq_conv_prod[product];
+    }
+    *guard = SEM_GUARD_CONV(g_num_prod);
+    return g_mq_conv;
+}
+
+static int sysv_conveyor_put(int product, const struct conveyor_msg *msg)
+{
+    int guard;
+    int mq = sysv_conv_queue(product, &guard);
+    return msgsnd_guarded(mq, msg, sizeof(*msg) - sizeof(long), g_sem_id, guard);
+}
+
+static int sysv_conveyor_take(int product, struct conveyor_msg *msg)
+{
+    int guard;
+    int mq = sysv_conv_queue(product, &guard);
+    ssize_t ret = msgrcv_guarded(mq, msg, sizeof(*msg) - sizeof(long),
+                                 product + 1, IPC_NOWAIT, g_sem_id, guard);
+    return (ret >= 0) ? 0 : -1;
+}
+
+static int sysv_checkout_send(const struct checkout_msg *msg)
+{
+    int q = (g_num_chkout > 1) ? (int)msg->mtype - 1 : 0;
+    return msgsnd_guarded_unit(g_mq_chkout[q], msg,
+                               CHECKOUT_MSG_SIZE(msg->num_lines) - sizeof(long),
+                               g_sem_id, sysv_chkout_guard(q), CHECKOUT_GUARD_UNIT);
+}
+
+/* Brak msgrcv z limitem czasu - proba IPC_NOWAIT, potem usleep */
+static int sysv_checkout_recv(int reg, struct checkout_msg *msg, int timeout_us)
+{
+    int q = (g_num_chkout > 1) ? reg : 0;
+    ssize_t ret = msgrcv_guarded_unit(g_mq_chkout[q], msg, sizeof(*msg) - sizeof(long),
+                                      reg + 1, IPC_NOWAIT, g_sem_id,
+                                      sysv_chkout_guard(q), CHECKOUT_GUARD_UNIT);
+    if (ret >= 0) return 0;
+    if (errno == ENOMSG) {
+        usleep(timeout_us);
+        errno = ENOMSG;
+    }
+    return -1;
+}
+
+static int sysv_admission_try(void)
+{
+    if (sem_trywait_undo(g_sem_id, SEM_SHOP_ENTRY) == 0) return 0;
+    errno = ENOMSG;
+    return -1;
+}
+
+static void sysv_admission_release(void)
+{
+    sem_signal_undo(g_sem_id, SEM_SHOP_ENTRY);
+}
+
+static int sysv_admission_adjust(int delta)
+{
+    return sem_adjust_op(g_sem_id, SEM_SHOP_ENTRY, delta);
+}
+
+static int sysv_admission_value(void)
+{
+    return sem_getval(g_sem_id, SEM_SHOP_ENTRY);
+}
+
+/* ================================================================
+ *  BACKEND POSIX (mq_open, sem_open)
+ * ================================================================ */
+
+/*
+ * px_create_queue - Tworzy kolejke POSIX o glebokosci depth.
+ * Bez CAP_SYS_RESOURCE kernel odrzuca mq_maxmsg > fs/mqueue/msg_max
+ * (EINVAL) - glebokosc spada do msg_max; suma kolejek uzytkownika jest
+ * ograniczona RLIMIT_MSGQUEUE (EMFILE) - wtedy glebokosc jest polowiona.
+ * @return Deskryptor; *depth = faktyczna glebokosc
+ */
+static mqd_t px_create_queue(const char *name, long *depth, long msgsize)
+{
+    long want = (*depth > 0) ? *depth : 1;
+    struct mq_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.mq_msgsize = msgsize;
+    attr.mq_maxmsg  = want;
+
+    mq_unlink(name); /* Pozostalosc po awarii poprzedniego uruchomienia */
+    for (;;) {
+        mqd_t q = mq_open(name, O_CREAT | O_EXCL | O_RDWR, 0600, &attr);
+        if (q != (mqd_t)-1) {
+            if (attr.mq_maxmsg < want)
+                fprintf(stderr, "%s[IPC]%s %s: glebokosc %ld zamiast %ld "
+                        "(fs/mqueue/msg_max lub RLIMIT_MSGQUEUE)\n",
+                        C_YELLOW, C_RESET, name, attr.mq_maxmsg, want);
+            *depth = attr.mq_maxmsg;
+            return q;
+        }
+        int err = errno;
+        long msg_max = read_sysctl_long("/proc/sys/fs/mqueue/msg_max");
+        errno = err;
+        if (err == EINVAL && msg_max > 0 && attr.mq_maxmsg > msg_max)
+            attr.mq_maxmsg = msg_max;
+        else if ((err == EMFILE || err == ENOMEM) && attr.mq_maxmsg > 1)
+            attr.mq_maxmsg /= 2;
+        else
+            handle_error("mq_open (tworzenie)");
+    }
+}
+
+/*
+ * px_queue - Deskryptor kolejki (otwierany przy pierwszym uzyciu).
+ * Kolejka usunieta przez kierownika (ENOENT) = koniec symulacji (EIDRM).
+ */
+static mqd_t px_queue(mqd_t *slot, const char *fmt, int idx)
+{
+    if (*slot == (mqd_t)-1) {
+        char name[64];
+        snprintf(name, sizeof(name), fmt, idx);
+        *slot = mq_open(name, O_RDWR);
+        if (*slot == (mqd_t)-1 && errno == ENOENT)
+            errno = EIDRM;
+    }
+    return *slot;
+}
+
+/* Termin bezwzgledny za us mikrosekund (mq_timed*: CLOCK_REALTIME) */
+static void px_deadline(struct timespec *abs, long us)
+{
+    clock_gettime(CLOCK_REALTIME, abs);
+    abs->tv_sec  += us / 1000000;
+    abs->tv_nsec += (us % 1000000) * 1000;
+    if (abs->tv_nsec >= 1000000000L) {
+        abs->tv_sec++;
+        abs->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Odbior z limitem czasu; timeout_us < 0 = bez czekania */
+static int px_receive(mqd_t q, void *msg, size_t size, int timeout_us)
+{
+    struct timespec abs = { 0, 0 }; /* Termin w przeszlosci - bez czekania */
+    if (timeout_us >= 0)
+        px_deadline(&abs, timeout_us);
+    if (mq_timedreceive(q, (char *)msg, size, NULL, &abs) >= 0)
+        return 0;
+    if (errno == ETIMEDOUT) errno = ENOMSG;
+    return -1;
+}
+
+static void px_reset(SharedData *shm, int sem_id)
+{
+    g_sem_id   = sem_id;
+    g_num_prod = shm->num_products;
+    for (int i = 0; i < MAX_PRODUCTS; i++) g_px_conv[i] = (mqd_t)-1;
+    for (int r = 0; r < NUM_REGISTERS; r++) g_px_chkout[r] = (mqd_t)-1;
+}
+
+static int posix_create(SharedData *shm, const char *keyfile, int sem_id)
+{
+    char name[64];
+    px_reset(shm, sem_id);
+
+    /* Podajnik i: glebokosc Ki - komplet sztuk z modelu SEM_CONVEYOR_BASE+i.
+     * Przycieta kolejka zmniejsza Ki, zeby model i kolejka sie zgadzaly. */
+    for (int i = 0; i < shm->num_products; i++) {
+        long depth = shm_products(shm)[i].conveyor_capacity;
+        snprintf(name, sizeof(name), POSIX_MQ_CONV_FMT, i);
+        mq_close(px_create_queue(name, &depth, sizeof(struct conveyor_msg)));
+        if (depth < shm_products(shm)[i].conveyor_capacity) {
+            shm_products(shm)[i].conveyor_capacity = (int)depth;
+            init_semaphore(sem_id, SEM_CONVEYOR_BASE + i, (int)depth);
+        }
+    }
+    /* Kasa r: glebokosc N - cala zawartosc sklepu w jednej kolejce */
+    for (int r = 0; r < NUM_REGISTERS; r++) {
+        long depth = shm->max_customers;
+        snprintf(name, sizeof(name), POSIX_MQ_CHKOUT_FMT, r);
+        mq_close(px_create_queue(name, &depth, sizeof(struct checkout_msg)));
+    }
+
+    sem_unlink(POSIX_SEM_ENTRY);
+    g_px_entry = sem_open(POSIX_SEM_ENTRY, O_CREAT | O_EXCL, 0600,
+                          (unsigned int)shm->max_customers);
+    if (g_px_entry == SEM_FAILED)
+        handle_error("sem_open (tworzenie)");
+
+    /* Paragony zostaja w System V (adresowanie mtype = PID klienta) */
+    rcpt_create(shm, keyfile);
+    boot_publish(shm, sem_id);
+    return 0;
+}
+
+static int posix_attach(SharedData *shm, const char *keyfile, int sem_id)
+{
+    px_reset(shm, sem_id);
+    rcpt_attach(shm, keyfile);
+    return 0;
+}
+
+/*
+ * Glebokosc = Ki (posix_create przycina Ki do kolejki), wiec po zajeciu
+ * miejsca w SEM_CONVEYOR_BASE+i kolejka ma wolny slot. Limit czasu to
+ * zabezpieczenie watku piekarza - po nim sztuka jest odrzucana (ENOMSG).
+ */
+#define PX_PUT_TIMEOUT_US 100000
+
+static int posix_conveyor_put(int product, const struct conveyor_msg *msg)
+{
+    mqd_t q = px_queue(&g_px_conv[product], POSIX_MQ_CONV_FMT, product);
+    if (q == (mqd_t)-1) return -1;
+
+    struct timespec abs;
+    px_deadline(&abs, PX_PUT_TIMEOUT_US);
+    if (mq_timedsend(q, (const char *)msg, sizeof(*msg), 0, &abs) == 0)
+        return 0;
+    if (errno == ETIMEDOUT) errno = ENOMSG;
+    return -1;
+}
+
+static int posix_conveyor_take(int product, struct conveyor_msg *msg)
+{
+    mqd_t q = px_queue(&g_px_conv[product], POSIX_MQ_CONV_FMT, product);
+    if (q == (mqd_t)-1) return -1;
+    return px_receive(q, msg, sizeof(*msg), -1);
+}
+
+static int posix_checkout_send(const struct checkout_msg *msg)
+{
+    int reg = (int)msg->mtype - 1;
+    mqd_t q = px_queue(&g_px_chkout[reg], POSIX_MQ_CHKOUT_FMT, reg);
+    if (q == (mqd_t)-1) return -1;
+    return mq_send(q, (const char *)msg, CHECKOUT_MSG_SIZE(msg->num_lines), 0);
+}
+
+static int posix_checkout_recv(int reg, struct checkout_msg *msg, int timeout_us)
+{
+    mqd_t q = px_queue(&g_px_chkout[reg], POSIX_MQ_CHKOUT_FMT, reg);
+    if (q == (mqd_t)-1) return -1;
+    return px_receive(q, msg, sizeof(*msg), timeout_us);
+}
+
+static sem_t *px_entry(void)
+{
+    if (g_px_entry == SEM_FAILED) {
+        g_px_entry = sem_open(POSIX_SEM_ENTRY, 0);
+        if (g_px_entry == SEM_FAILED && errno == ENOENT)
+            errno = EIDRM;
+    }
+    return g_px_entry;
+}
+
+/* Semafor POSIX nie ma SEM_UNDO - zabity klient nie oddaje miejsca */
+static int posix_admission_try(void)
+{
+    sem_t *s = px_entry();
+    if (s == SEM_FAILED) return -1;
+    if (sem_trywait(s) == 0) return 0;
+    if (errno == EAGAIN) errno = ENOMSG;
+    return -1;
+}
+
+static void posix_admission_release(void)
+{
+    sem_t *s = px_entry();
+    if (s != SEM_FAILED) sem_post(s);
+}
+
+/* Odpowiednik semop(delta) z IPC_NOWAIT: ujemna delta wszystko albo nic */
+static int posix_admission_adjust(int delta)
+{
+    sem_t *s = px_entry();
+    if (s == SEM_FAILED) return -1;
+    for (int i = 0; i < delta; i++)
+        sem_post(s);
+    for (int i = 0; i < -delta; i++) {
+        if (sem_trywait(s) == -1) {
+            while (i-- > 0) sem_post(s);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int posix_admission_value(void)
+{
+    sem_t *s = px_entry();
+    int val = -1;
+    if (s == SEM_FAILED || sem_getvalue(s, &val) == -1) return -1;
+    return val;
+}
+
+/* ================================================================
+ *  WYBOR BACKENDU
+ * ================================================================ */
+
+static const IpcBackend g_backends[IPC_BACKEND_COUNT] = {
+    [IPC_BACKEND_SYSV] = {
+        .name              = "sysv",
+        .create            = sysv_create,
+        .attach            = sysv_attach,
+        .conveyor_put      = sysv_conveyor_put,
+        .conveyor_take     = sysv_conveyor_take,
+        .checkout_send     = sysv_checkout_send,
+        .checkout_recv     = sysv_checkout_recv,
+        .receipt_send      = sysv_receipt_send,
+        .receipt_take      = sysv_receipt_take,
+        .admission_try     = sysv_admission_try,
+        .admission_release = sysv_admission_release,
+        .admission_adjust  = sysv_admission_adjust,
+        .admission_value   = sysv_admission_value,
+    },
+    [IPC_BACKEND_POSIX] = {
+        .name              = "posix",
+        .create            = posix_create,
+        .attach            = posix_attach,
+        .conveyor_put      = posix_conveyor_put,
+        .conveyor_take     = posix_conveyor_take,
+        .checkout_send     = posix_checkout_send,
+        .checkout_recv     = posix_checkout_recv,
+        .receipt_send      = sysv_receipt_send,
+        .receipt_take      = sysv_receipt_take,
+        .admission_try     = posix_admission_try,
+        .admission_release = posix_admission_release,
+        .admission_adjust  = posix_admission_adjust,
+        .admission_value   = posix_admission_value,
+    },
+};
+
+const IpcBackend *ipc_backend_get(int kind)
+{
+    if (kind < 0 || kind >= IPC_BACKEND_COUNT) return NULL;
+    return &g_backends[kind];
+}
+
+int ipc_backend_parse(const char *name)
+{
+    for (int k = 0; k < IPC_BACKEND_COUNT; k++) {
+        if (strcmp(name, g_backends[k].name) == 0)
+            return k;
+    }
+    return -1;
+}
+
+void ipc_posix_unlink_all(void)
+{
+    char name[64];
+    for (int i = 0; i < MAX_PRODUCTS; i++) {
+        snprintf(name, sizeof(name), POSIX_MQ_CONV_FMT, i);
+        mq_unlink(name);
+    }
+    for (int r = 0; r < NUM_REGISTERS; r++) {
+        snprintf(name, sizeof(name), POSIX_MQ_CHKOUT_FMT, r);
+        mq_unlink(name);
+    }
+    sem_unlink(POSIX_SEM_ENTRY);
+}
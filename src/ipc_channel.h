@@ -0,0 +1,102 @@
+/**
+ * ipc_channel.h - Warstwa kanalow IPC z wymiennym backendem
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Procesy nie wolaja msgsnd/msgrcv/semop bezposrednio dla podajnikow,
+ * kas, paragonow i wejscia do sklepu - robia to przez tablice funkcji
+ * IpcBackend wybrana opcja kierownika -I (SharedData.ipc_backend):
+ *
+ * - sysv:  jedna kolejka System V na kanal (mtype = produkt/kasa/PID)
+ *          z semaforem-straznikiem, wejscie przez SEM_SHOP_ENTRY z SEM_UNDO.
+ * - posix: osobna kolejka mq_open() na kazdy podajnik i kase z limitem
+ *          glebokosci mq_maxmsg (bez straznika), kasjer czeka na klienta
+ *          w mq_timedreceive(), wejscie przez nazwany semafor sem_open().
+ *
+ * Wspolne dla obu backendow: liczniki w pamieci dzielonej System V
+ * (check_shm i metrics_server dolaczaja sie po kluczu ftok), semafory
+ * SEM_CONVEYOR_BASE+i (model zapelnienia podajnika) oraz kolejka paragonow
+ * System V - paragon jest adresowany PID-em klienta, a POSIX nie ma
+ * odpowiednika mtype (kolejka na klienta przekroczylaby queues_max).
+ * Opcja -r (SharedData.queue_shards) dzieli kolejke kas sysv na kolejke
+ * na kase i paragony na R kolejek wg PID % R w obu backendach.
+ */
+
+#ifndef IPC_CHANNEL_H
+#define IPC_CHANNEL_H
+
+#include "common.h"
+
+/** Rodzaj backendu (wartosc SharedData.ipc_backend). */
+typedef enum {
+    IPC_BACKEND_SYSV = 0,
+    IPC_BACKEND_POSIX,
+    IPC_BACKEND_COUNT
+} IpcBackendKind;
+
+/**
+ * Operacje kanalow. Funkcje zwracajace int: 0 - sukces, -1 - blad
+ * z errno: ENOMSG (brak komunikatu / miejsca), EINTR (sygnal),
+ * EIDRM (kanal usuniety - koniec symulacji).
+ */
+typedef struct {
+    const char *name;
+
+    /** Kierownik: tworzy kanaly po init_semaphore_values(). */
+    int  (*create)(SharedData *shm, const char *keyfile, int sem_id);
+    /** Potomek: dolacza do istniejacych kanalow. */
+    int  (*attach)(SharedData *shm, const char *keyfile, int sem_id);
+
+    /** Piekarz: odklada sztuke na podajnik (blokuje przy pelnej kolejce). */
+    int  (*conveyor_put)(int product, const struct conveyor_msg *msg);
+    /** Klient: zdejmuje sztuke z podajnika bez czekania. */
+    int  (*conveyor_take)(int product, struct conveyor_msg *msg);
+
+    /** Klient: wysyla koszyk do kasy msg->mtype - 1. */
+    int  (*checkout_send)(const struct checkout_msg *msg);
+    /** Kasjer: czeka na koszyk najwyzej timeout_us (ENOMSG po czasie). */
+    int  (*checkout_recv)(int reg, struct checkout_msg *msg, int timeout_us);
+
+    /** Kasjer: wysyla paragon bez czekania (ENOMSG przy pelnej kolejce). */
+    int  (*receipt_send)(const struct receipt_msg *msg);
+    /** Klient: odbiera swoj paragon (mtype = PID) bez czekania. */
+    int  (*receipt_take)(pid_t pid, struct receipt_msg *msg);
+
+    /** Klient: proba zajecia miejsca w sklepie (ENOMSG gdy pelny). */
+    int  (*admission_try)(void);
+    /** Klient: zwolnienie miejsca. */
+    void (*admission_release)(void);
+    /** Kierownik: zmiana liczby wolnych miejsc o delta (zmiana N). */
+    int  (*admission_adjust)(int delta);
+    /** Aktualna liczba wolnych miejsc. */
+    int  (*admission_value)(void);
+} IpcBackend;
+
+/**
+ * Zwraca backend danego rodzaju (NULL dla nieznanego).
+ */
+const IpcBackend *ipc_backend_get(int kind);
+
+/**
+ * Parsuje nazwe backendu ("sysv" / "posix").
+ * @return IpcBackendKind lub -1
+ */
+int ipc_backend_parse(const char *name);
+
+/**
+ * Nazwa backendu do logow i raportu (inline - uzywana tez przez check_shm,
+ * ktory nie linkuje warstwy kanalow).
+ */
+static inline const char *ipc_backend_name(int kind)
+{
+    return kind == IPC_BACKEND_POSIX ? "posix"
+         : kind == IPC_BACKEND_SYSV  ? "sysv" : "?";
+}
+
+/**
+ * Usuwa obiekty POSIX (kolejki podajnikow i kas, semafor wejscia).
+ * Brakujace nazwy sa pomijane - wolane z cleanup_all_ipc() niezaleznie
+ * od backendu, takze po awarii poprzedniego uruchomienia.
+ */
+void ipc_posix_unlink_all(void);
+
+#endif /* IPC_CHANNEL_H */
@@ -5,34 +5,90 @@
  */
 
 #include "ipc_utils.h"
+#include "ipc_channel.h"
 #include "error_handler.h"
+#include "seqlock.h"
+#include "histogram.h"
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 
 /* Minimalne uprawnienia dostepu dla zasobow IPC */
 #define IPC_PERMS 0660
 
 // PAMIEC DZIELONA (Shared Memory)
 
+/*
+ * huge_page_size - Rozmiar duzej strony (Hugepagesize z /proc/meminfo,
+ * domyslnie 2 MiB).
+ */
+static size_t huge_page_size(void)
+{
+    size_t kb = 2048;
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (f) {
+        char line[128];
+        while (fgets(line, sizeof(line), f))
+            if (sscanf(line, "Hugepagesize: %zu kB", &kb) == 1)
+                break;
+        fclose(f);
+    }
+    return kb * 1024;
+}
+
+/*
+ * shm_create_fresh - shmget(IPC_CREAT | IPC_EXCL); segment pozostaly
+ * po poprzednim uruchomieniu jest usuwany i tworzony ponownie.
+ */
+static int shm_create_fresh(key_t key, size_t size, int extra_flags)
+{
+    int flags = IPC_CREAT | IPC_EXCL | IPC_PERMS | extra_flags;
+    int shm_id = shmget(key, size, flags);
+    if (shm_id == -1 && errno == EEXIST) {
+        /* Rozmiar 0 - stary segment moze byc mniejszy niz obecny uklad */
+        int old_id = shmget(key, 0, IPC_PERMS);
+        if (old_id != -1)
+            shmctl(old_id, IPC_RMID, NULL);
+        shm_id = shmget(key, size, flags);
+    }
+    return shm_id;
+}
+
 /*
  * create_shared_memory - Tworzy nowy segment pamieci dzielonej.
  * Uzywa ftok() do wygenerowania klucza na podstawie pliku i identyfikatora.
  * Ustawia minimalne prawa dostepu (0660).
  */
-int create_shared_memory(const char *keyfile)
+int create_shared_memory(const char *keyfile, int opts, size_t bytes,
+                         int *active, size_t *size)
 {
     key_t key = ftok(keyfile, PROJ_SHM);
     if (key == -1)
         handle_error("ftok (shared memory)");
 
-    int shm_id = shmget(key, sizeof(SharedData), IPC_CREAT | IPC_EXCL | IPC_PERMS);
-    if (shm_id == -1) {
-        /* Jesli segment juz istnieje, sprobuj go usunac i utworzyc ponownie */
-        if (errno == EEXIST) {
-            shm_id = shmget(key, sizeof(SharedData), IPC_PERMS);
-            if (shm_id != -1) {
-                shmctl(shm_id, IPC_RMID, NULL);
-            }
-            shm_id = shmget(key, sizeof(SharedData), IPC_CREAT | IPC_EXCL | IPC_PERMS);
+    int shm_id = -1;
+    *active = 0;
+    *size   = bytes;
+
+    if (opts & SHM_OPT_HUGE) {
+        size_t hp = huge_page_size();
+        size_t hsize = (bytes + hp - 1) / hp * hp;
+        shm_id = shm_create_fresh(key, hsize, SHM_HUGETLB);
+        if (shm_id != -1) {
+            *active |= SHM_OPT_HUGE;
+            *size = hsize;
+        } else {
+            int err = errno;
+            fprintf(stderr, "%s[SHM]%s SHM_HUGETLB (%zu B): %s, vm.nr_hugepages=%ld "
+                    "- zwykle strony (sysctl -w vm.nr_hugepages=%zu)\n",
+                    C_YELLOW, C_RESET, hsize, strerror(err),
+                    read_sysctl_long("/proc/sys/vm/nr_hugepages"), hsize / hp);
         }
+    }
+    if (shm_id == -1) {
+        shm_id = shm_create_fresh(key, bytes, 0);
         if (shm_id == -1)
             handle_error("shmget (create)");
     }
@@ -42,9 +98,22 @@ int create_shared_memory(const char *keyfile)
     if (shm == (SharedData *)-1)
         handle_error("shmat (init)");
 
-    memset(shm, 0, sizeof(SharedData));
+    memset(shm, 0, bytes);
     shmdt(shm);
 
+    if (opts & SHM_OPT_PREFAULT)
+        *active |= SHM_OPT_PREFAULT;
+    if (opts & SHM_OPT_LOCK) {
+        if (shmctl(shm_id, SHM_LOCK, NULL) == 0) {
+            *active |= SHM_OPT_LOCK;
+        } else {
+            int err = errno;
+            fprintf(stderr, "%s[SHM]%s SHM_LOCK: %s - segment bez blokady "
+                    "(CAP_IPC_LOCK lub ulimit -l >= %zu KiB)\n",
+                    C_YELLOW, C_RESET, strerror(err), (*size + 1023) / 1024);
+        }
+    }
+
     return shm_id;
 }
 
@@ -69,6 +138,65 @@ SharedData *attach_shared_memory(const char *keyfile)
     return shm;
 }
 
+/*
+ * shm_account_attach - Koszt dolaczenia SHM w tym procesie: shmat
+ * (+ MADV_POPULATE_WRITE przy SHM_OPT_PREFAULT - tablice stron wypelnione
+ * jednym wywolaniem) oraz pierwszy dotyk kazdej strony segmentu (czas
+ * i minor faults z getrusage). Probki trafiaja atomowo do SHM.
+ */
+static void shm_account_attach(SharedData *shm, uint64_t t0)
+{
+    if (shm->shm_active & SHM_OPT_PREFAULT) {
+        if (madvise(shm, shm->shm_size, MADV_POPULATE_WRITE) == -1
+            && errno != EINVAL) /* EINVAL: jadro < 5.14 - zostaja faulty */
+            handle_warning("madvise (MADV_POPULATE_WRITE)");
+    }
+    uint64_t t1 = hist_now_ns();
+
+    struct rusage ru0, ru1;
+    getrusage(RUSAGE_SELF, &ru0);
+    long page = sysconf(_SC_PAGESIZE);
+    const volatile char *p = (const volatile char *)shm;
+    for (size_t off = 0; off < shm->shm_size; off += (size_t)page)
+        (void)p[off];
+    getrusage(RUSAGE_SELF, &ru1);
+    uint64_t t2 = hist_now_ns();
+
+    hist_record_shared(&shm->hist[HIST_SHM_ATTACH], t0, t1);
+    hist_record_shared(&shm->hist[HIST_SHM_TOUCH], t1, t2);
+    __atomic_fetch_add(&shm->shm_touch_faults,
+                       (uint64_t)(ru1.ru_minflt - ru0.ru_minflt), __ATOMIC_RELAXED);
+}
+
+/*
+ * attach_child_ipc - Start potomka bez ftok(): kierownik eksportuje
+ * shm_id (ENV_SHM_ID), a sem_id i kolejki czeka w shm->boot. Zaoszczedza
+ * ftok() (stat pliku klucza) i wyszukiwanie po kluczu dla kazdego obiektu
+ * - przy tysiacach klientow to koszt kazdego fork+exec.
+ */
+SharedData *attach_child_ipc(const char *keyfile, int *sem_id)
+{
+    uint64_t t0 = hist_now_ns();
+    const char *env = getenv(ENV_SHM_ID);
+    if (env != NULL && *env != '\0') {
+        int shm_id = atoi(env);
+        SharedData *shm = (SharedData *)shmat(shm_id, NULL, 0);
+        if (shm != (SharedData *)-1) {
+            if (shm->boot.ready && shm->boot.shm_id == shm_id) {
+                *sem_id = shm->boot.sem_id;
+                shm_account_attach(shm, t0);
+                return shm;
+            }
+            shmdt(shm);
+        }
+    }
+
+    SharedData *shm = attach_shared_memory(keyfile);
+    *sem_id = get_semaphores(keyfile, TOTAL_SEMS(shm->num_products));
+    shm_account_attach(shm, t0);
+    return shm;
+}
+
 /*
  * detach_shared_memory - Odlacza pamiec dzielona od biezacego procesu.
  */
@@ -89,7 +217,7 @@ void remove_shared_memory(const char *keyfile)
     key_t key = ftok(keyfile, PROJ_SHM);
     if (key == -1) return;
 
-    int shm_id = shmget(key, sizeof(SharedData), IPC_PERMS);
+    int shm_id = shmget(key, 0, IPC_PERMS);
     if (shm_id == -1) return;
 
     if (shmctl(shm_id, IPC_RMID, NULL) == -1)
@@ -211,6 +339,25 @@ int sem_trywait_op(int sem_id, int sem_num)
     return 0;
 }
 
+/*
+ * sem_adjust_op - Zmiana wartosci semafora o delta jedna operacja semop().
+ * Nie blokuje: przy zbyt malej wartosci (EAGAIN) wraca -1 bez zmian.
+ */
+int sem_adjust_op(int sem_id, int sem_num, int delta)
+{
+    struct sembuf sop;
+    sop.sem_num = sem_num;
+    sop.sem_op  = delta;
+    sop.sem_flg = IPC_NOWAIT;
+
+    if (semop(sem_id, &sop, 1) == -1) {
+        if (errno != EAGAIN && errno != EINTR)
+            handle_warning("semop (adjust)");
+        return -1;
+    }
+    return 0;
+}
+
 /*
  * sem_wait_undo - Operacja P z SEM_UNDO.
  * Kernel cofnie operacje jesli proces zginie trzymajac semafor.
@@ -269,10 +416,28 @@ int sem_trywait_undo(int sem_id, int sem_num)
     return 0;
 }
 
+/*
+ * shm_lock - SEM_SHM_MUTEX + poczatek zapisu seqlocka stanu.
+ */
+void shm_lock(int sem_id, SharedData *shm)
+{
+    sem_wait_undo(sem_id, SEM_SHM_MUTEX);
+    seq_write_begin(&shm->state_seq);
+}
+
+/*
+ * shm_unlock - Koniec zapisu seqlocka stanu + zwolnienie SEM_SHM_MUTEX.
+ */
+void shm_unlock(int sem_id, SharedData *shm)
+{
+    seq_write_end(&shm->state_seq);
+    sem_signal_undo(sem_id, SEM_SHM_MUTEX);
+}
+
 /*
  * sem_wait_interruptible - Operacja P przerwalna przez sygnaly.
  * Wraca -1 przy EINTR (zamiast powtarzac jak sem_wait_op).
- * Uzywane w msgsnd_guarded zeby SIGTERM mogl przerwac blokujace czekanie.
+ * SIGTERM moze przerwac blokujace czekanie (jak guard_op w msgsnd_guarded).
  */
 int sem_wait_interruptible(int sem_id, int sem_num)
 {
@@ -377,6 +542,65 @@ void remove_message_queue(const char *keyfile, int proj_id)
         handle_warning("msgctl IPC_RMID");
 }
 
+/*
+ * read_sysctl_long - Pierwsza liczba z pliku /proc/sys (-1 gdy nieczytelny).
+ */
+long read_sysctl_long(const char *path)
+{
+    long val = -1;
+    FILE *f = fopen(path, "r");
+    if (f) {
+        if (fscanf(f, "%ld", &val) != 1) val = -1;
+        fclose(f);
+    }
+    return val;
+}
+
+/*
+ * size_message_queue - Podnosi msg_qbytes do (slots + 1) * msgsz.
+ * Domyslne msg_qbytes (kernel.msgmnb, zwykle 16 KiB) bywa mniejsze niz
+ * suma pojemnosci podajnikow - wtedy piekarz czeka na wspolnym
+ * strazniku zamiast odrzucac sztuki przy pelnym podajniku.
+ */
+size_t size_message_queue(int mq_id, int slots, size_t msgsz, const char *label)
+{
+    struct msqid_ds info;
+    if (msgctl(mq_id, IPC_STAT, &info) == -1) {
+        handle_warning("msgctl IPC_STAT (size queue)");
+        return 0;
+    }
+
+    size_t need = ((size_t)slots + 1) * msgsz;
+    if (info.msg_qbytes >= need)
+        return info.msg_qbytes;
+
+    msglen_t before = info.msg_qbytes;
+    info.msg_qbytes = need;
+    if (msgctl(mq_id, IPC_SET, &info) == 0)
+        return need;
+    if (errno != EPERM) {
+        handle_warning("msgctl IPC_SET (msg_qbytes)");
+        return before;
+    }
+
+    /* Bez CAP_SYS_RESOURCE limitem jest kernel.msgmnb */
+    long msgmnb = read_sysctl_long("/proc/sys/kernel/msgmnb");
+    msglen_t got = before;
+    if (msgmnb > (long)before) {
+        info.msg_qbytes = (msglen_t)msgmnb;
+        if (msgctl(mq_id, IPC_SET, &info) == 0)
+            got = (msglen_t)msgmnb;
+    }
+    fprintf(stderr, "%s[IPC]%s kolejka %s: potrzeba %zu B (%d kom. x %zu B), "
+            "kernel.msgmnb=%ld, ustawiono %lu B (%lu kom.) - "
+            "sysctl -w kernel.msgmnb=%zu\n",
+            C_YELLOW, C_RESET, label, need, slots + 1, msgsz, msgmnb,
+            (unsigned long)got, (unsigned long)(got / msgsz), need);
+    return got;
+}
+
+#define GUARD_SEMVMX 32767  /* Maks. wartosc semafora System V */
+
 /*
  * calc_queue_guard_init - Oblicza poczatkowa wartosc semafora-straznika.
  * Na podstawie msg_qbytes (max bajtow w kolejce) i rozmiaru komunikatu
@@ -395,8 +619,43 @@ int calc_queue_guard_init(int mq_id, size_t msgsz)
     if (qbytes == 0 || msgsz == 0)
         return 8;
 
-    int slots = (int)(qbytes / msgsz);
-    return (slots > 1) ? (slots - 1) : 1;
+    /* Straznik w bajtach (msgsz = jednostka) moze przekroczyc SEMVMX */
+    size_t slots = qbytes / msgsz;
+    if (slots > GUARD_SEMVMX) slots = GUARD_SEMVMX;
+    return (slots > 1) ? (int)(slots - 1) : 1;
+}
+
+/*
+ * guard_units - Jednostki straznika zajmowane przez komunikat: jedna
+ * (unit = 0, straznik liczy komunikaty) albo ceil(msgsz / unit), gdy
+ * straznik liczy bajty komunikatow o zmiennej dlugosci.
+ */
+static int guard_units(size_t msgsz, size_t unit)
+{
+    if (unit == 0) return 1;
+    return (int)((msgsz + unit - 1) / unit);
+}
+
+/*
+ * guard_op - semop o delta jednostek na strazniku. Czekanie (delta < 0)
+ * przerywalne przez sygnaly jak sem_wait_interruptible.
+ */
+static int guard_op(int sem_id, int guard_idx, int delta)
+{
+    struct sembuf sop;
+    sop.sem_num = guard_idx;
+    sop.sem_op  = delta;
+    sop.sem_flg = 0;
+
+    if (semop(sem_id, &sop, 1) == -1) {
+        if (errno == EINTR || errno == EIDRM || errno == EINVAL)
+            return -1;
+        if (delta < 0)
+            handle_error("semop (guard wait)");
+        handle_warning("semop (guard signal)");
+        return -1;
+    }
+    return 0;
 }
 
 /*
@@ -407,14 +666,24 @@ int calc_queue_guard_init(int mq_id, size_t msgsz)
 int msgsnd_guarded(int mq_id, const void *msg, size_t msgsz,
                    int sem_id, int guard_idx)
 {
-    /* Czekaj na wolny slot (przerywalne przez sygnaly) */
-    if (sem_wait_interruptible(sem_id, guard_idx) == -1)
+    return msgsnd_guarded_unit(mq_id, msg, msgsz, sem_id, guard_idx, 0);
+}
+
+int msgsnd_guarded_unit(int mq_id, const void *msg, size_t msgsz,
+                        int sem_id, int guard_idx, size_t unit)
+{
+    int units = guard_units(msgsz, unit);
+
+    /* Czekaj na wolne miejsce (przerywalne przez sygnaly) */
+    if (guard_op(sem_id, guard_idx, -units) == -1)
         return -1; /* Przerwane sygnalem lub semafor usuniety */
 
     if (msgsnd(mq_id, msg, msgsz, 0) == -1) {
         /* ZAWSZE przywroc semafor straznika przy bledzie msgsnd.
          * Bez tego guard jest trwale dekrementowany (leak slotow). */
-        sem_signal_op(sem_id, guard_idx);
+        int saved = errno;
+        guard_op(sem_id, guard_idx, units);
+        errno = saved;
         if (errno == EIDRM || errno == EINVAL)
             return -1; /* Kolejka usunieta - shutdown */
         if (errno == EINTR)
@@ -432,6 +701,13 @@ int msgsnd_guarded(int mq_id, const void *msg, size_t msgsz,
  */
 ssize_t msgrcv_guarded(int mq_id, void *msg, size_t msgsz, long mtype,
                        int msgflg, int sem_id, int guard_idx)
+{
+    return msgrcv_guarded_unit(mq_id, msg, msgsz, mtype, msgflg,
+                               sem_id, guard_idx, 0);
+}
+
+ssize_t msgrcv_guarded_unit(int mq_id, void *msg, size_t msgsz, long mtype,
+                            int msgflg, int sem_id, int guard_idx, size_t unit)
 {
     ssize_t ret = msgrcv(mq_id, msg, msgsz, mtype, msgflg);
     if (ret == -1) {
@@ -445,8 +721,8 @@ ssize_t msgrcv_guarded(int mq_id, void *msg, size_t msgsz, long mtype,
         return -1;
     }
 
-    /* Zwolnij slot - sygnalizuj ze miejsce sie zrobilo */
-    sem_signal_op(sem_id, guard_idx);
+    /* Zwolnij miejsce tego komunikatu - sygnalizuj nadawcom */
+    guard_op(sem_id, guard_idx, guard_units((size_t)ret, unit));
 
     return ret;
 }
@@ -492,6 +768,95 @@ void remove_fifo(const char *path)
     }
 }
 
+// ZEGAR SYMULACJI (licznik tykniec + futex)
+
+/*
+ * futex_call - Wywolanie futex(2) (glibc nie ma wrappera). Slowo lezy
+ * w segmencie SysV dzielonym miedzy procesami - bez FUTEX_PRIVATE_FLAG.
+ */
+static long futex_call(uint32_t *addr, int op, uint32_t val,
+                       const struct timespec *timeout)
+{
+    return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+/*
+ * sim_tick_now - Odczyt licznika tykniec.
+ */
+uint32_t sim_tick_now(const SharedData *shm)
+{
+    return __atomic_load_n(&shm->tick, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * tick_publish - Nowa minuta: licznik w gore, potem FUTEX_WAKE.
+ * Kolejnosc (licznik przed tick_waiters, SEQ_CST) paruje sie z
+ * wait_until_tick: czekajacy albo widzi nowy licznik, albo zostaje
+ * policzony i obudzony (FUTEX_WAIT z nieaktualna wartoscia wraca EAGAIN).
+ */
+void tick_publish(SharedData *shm, uint32_t minutes)
+{
+    __atomic_add_fetch(&shm->tick, minutes, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&shm->tick_waiters, __ATOMIC_SEQ_CST) > 0)
+        futex_call(&shm->tick, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+/*
+ * tick_wake_all - Budzi wszystkich czekajacych (np. po simulation_running = 0).
+ */
+void tick_wake_all(SharedData *shm)
+{
+    futex_call(&shm->tick, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+/*
+ * wait_until_tick - FUTEX_WAIT na SharedData.tick do osiagniecia target
+ * (porownanie modulo 2^32). Licznik tick_waiters pozwala kierownikowi
+ * pominac FUTEX_WAKE, gdy nikt nie spi; proces zabity w trakcie
+ * zostawia go zawyzonego - kosztuje to tylko zbedne wywolania.
+ */
+int wait_until_tick(SharedData *shm, uint32_t target)
+{
+    uint32_t cur = sim_tick_now(shm);
+    if ((int32_t)(cur - target) >= 0)
+        return 0;
+
+    /* Limit awaryjny liczony od teraz (CLOCK_MONOTONIC) */
+    struct timespec now, limit;
+    uint64_t wait_ns = (uint64_t)(target - cur + TICK_WAIT_SLACK)
+                       * (uint64_t)shm->time_scale_ms * 1000000ULL;
+    clock_gettime(CLOCK_MONOTONIC, &limit);
+    uint64_t limit_ns = (uint64_t)limit.tv_sec * 1000000000ULL
+                        + (uint64_t)limit.tv_nsec + wait_ns;
+
+    int rc;
+    __atomic_add_fetch(&shm->tick_waiters, 1, __ATOMIC_SEQ_CST);
+    for (;;) {
+        cur = sim_tick_now(shm);
+        if ((int32_t)(cur - target) >= 0) { rc = 0; break; }
+        if (!shm->simulation_running)     { rc = -1; break; }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000ULL
+                          + (uint64_t)now.tv_nsec;
+        if (now_ns >= limit_ns) { rc = 1; break; }
+
+        /* FUTEX_WAIT przyjmuje czas wzgledny */
+        uint64_t left = limit_ns - now_ns;
+        struct timespec rel = {
+            .tv_sec  = (time_t)(left / 1000000000ULL),
+            .tv_nsec = (long)(left % 1000000000ULL),
+        };
+        if (futex_call(&shm->tick, FUTEX_WAIT, cur, &rel) == -1
+            && errno == EINTR) {
+            rc = -1;
+            break;
+        }
+    }
+    __atomic_sub_fetch(&shm->tick_waiters, 1, __ATOMIC_SEQ_CST);
+    return rc;
+}
+
 //CZYSZCZENIE WSZYSTKICH ZASOBOW IPC
 
 /*
@@ -507,6 +872,15 @@ void cleanup_all_ipc(const char *keyfile, int num_products)
     remove_message_queue(keyfile, PROJ_MQ_CONV);
     remove_message_queue(keyfile, PROJ_MQ_CHKOUT);
     remove_message_queue(keyfile, PROJ_MQ_RCPT);
+    for (int i = 0; i < MAX_CONV_QUEUES; i++)
+        remove_message_queue(keyfile, PROJ_MQ_CONV_PROD(i));
+    for (int r = 1; r < NUM_REGISTERS; r++)
+        remove_message_queue(keyfile, PROJ_MQ_CHKOUT_REG(r));
+    for (int sh = 1; sh < MAX_RECEIPT_SHARDS; sh++)
+        remove_message_queue(keyfile, PROJ_MQ_RCPT_SHARD(sh));
+
+    /* Usun kolejki i semafor POSIX (backend -I posix) */
+    ipc_posix_unlink_all();
 
     /* Usun semafory */
     remove_semaphores(keyfile);
@@ -514,8 +888,9 @@ void cleanup_all_ipc(const char *keyfile, int num_products)
     /* Usun pamiec dzielona */
     remove_shared_memory(keyfile);
 
-    /* Usun FIFO polecen */
+    /* Usun FIFO polecen i potwierdzen */
     remove_fifo(FIFO_CMD_PATH);
+    remove_fifo(FIFO_ACK_PATH);
 
     /* Usun plik klucza */
     if (unlink(keyfile) == -1) {
@@ -8,11 +8,19 @@
 
 /**
  * Tworzy segment pamieci dzielonej.
- * Uzywa ftok() z keyfile i PROJ_SHM.
+ * Uzywa ftok() z keyfile i PROJ_SHM. Opcje SHM_OPT_*: duze strony
+ * (przy bledzie - zwykle, z ostrzezeniem), SHM_LOCK (przy EPERM/ENOMEM -
+ * bez blokady). Segment jest zerowany, wiec strony sa juz wypelnione
+ * w procesie tworzacym.
  * @param keyfile Plik klucza dla ftok()
+ * @param opts    Zadane SHM_OPT_*
+ * @param bytes   Rozmiar ukladu (shm_layout_size dla katalogu)
+ * @param active  [out] Opcje wlaczone naprawde
+ * @param size    [out] Rozmiar segmentu w bajtach
  * @return ID segmentu pamieci dzielonej
  */
-int create_shared_memory(const char *keyfile);
+int create_shared_memory(const char *keyfile, int opts, size_t bytes,
+                         int *active, size_t *size);
 
 /**
  * Dolacza do istniejacego segmentu pamieci dzielonej.
@@ -21,6 +29,16 @@ int create_shared_memory(const char *keyfile);
  */
 SharedData *attach_shared_memory(const char *keyfile);
 
+/**
+ * Dolaczenie procesu potomnego: SHM po shm_id z ENV_SHM_ID i sem_id
+ * z bloku startowego (bez ftok). Gdy zmiennej brak lub blok nie jest
+ * gotowy - attach_shared_memory() i get_semaphores() po kluczu.
+ * @param keyfile Plik klucza (sciezka awaryjna)
+ * @param sem_id  [out] ID zbioru semaforow
+ * @return Wskaznik do struktury SharedData
+ */
+SharedData *attach_child_ipc(const char *keyfile, int *sem_id);
+
 /**
  * Odlacza pamiec dzielona od procesu.
  */
@@ -74,6 +92,13 @@ void sem_signal_op(int sem_id, int sem_num);
  */
 int sem_trywait_op(int sem_id, int sem_num);
 
+/**
+ * Zmienia wartosc semafora o delta (bez SEM_UNDO, IPC_NOWAIT).
+ * Uzywane przez kierownika do zmiany N (SEM_SHOP_ENTRY) w trakcie symulacji.
+ * @return 0 jesli sukces, -1 jesli ujemna delta wymagalaby czekania
+ */
+int sem_adjust_op(int sem_id, int sem_num, int delta);
+
 /**
  * Pobiera aktualna wartosc semafora.
  */
@@ -97,6 +122,17 @@ void sem_signal_undo(int sem_id, int sem_num);
  */
 int sem_trywait_undo(int sem_id, int sem_num);
 
+/**
+ * Wejscie do sekcji stanu SHM: SEM_SHM_MUTEX (z SEM_UNDO) i otwarcie
+ * zapisu seqlocka state_seq - czytelnicy (shm_read_state) ponowia kopie.
+ */
+void shm_lock(int sem_id, SharedData *shm);
+
+/**
+ * Wyjscie z sekcji stanu SHM: zamkniecie zapisu seqlocka i zwolnienie mutexu.
+ */
+void shm_unlock(int sem_id, SharedData *shm);
+
 /**
  * Operacja P przerwalna przez sygnaly.
  * Wraca -1 przy EINTR zamiast powtarzac (caller sprawdza g_terminate).
@@ -129,11 +165,31 @@ int get_message_queue(const char *keyfile, int proj_id);
  */
 void remove_message_queue(const char *keyfile, int proj_id);
 
+/**
+ * Odczytuje limit kernela z pliku /proc/sys (np. kernel/msgmnb).
+ * @return Wartosc lub -1 gdy plik nieczytelny
+ */
+long read_sysctl_long(const char *path);
+
+/**
+ * Ustawia msg_qbytes kolejki tak, aby semafor-straznik (calc_queue_guard_init)
+ * mial co najmniej slots miejsc: (slots + 1) * msgsz bajtow. Powyzej
+ * kernel.msgmnb IPC_SET wymaga CAP_SYS_RESOURCE - wtedy ustawia msgmnb
+ * i wypisuje ostrzezenie z dokladnymi liczbami. Nigdy nie zmniejsza kolejki.
+ * @param mq_id  ID kolejki komunikatow
+ * @param slots  Wymagana liczba komunikatow w kolejce
+ * @param msgsz  Rozmiar jednego komunikatu (payload + sizeof(long))
+ * @param label  Nazwa kolejki do ostrzezenia
+ * @return Ustawione msg_qbytes lub 0 przy bledzie IPC_STAT
+ */
+size_t size_message_queue(int mq_id, int slots, size_t msgsz, const char *label);
+
 /**
  * Oblicza poczatkowa wartosc semafora-straznika kolejki.
  * @param mq_id   ID kolejki komunikatow
  * @param msgsz   Rozmiar jednego komunikatu (payload + sizeof(long))
- * @return Liczba slotow (minimum 1)
+ *                lub jednostka straznika liczacego bajty
+ * @return Liczba slotow (minimum 1, maksimum SEMVMX - 1)
  */
 int calc_queue_guard_init(int mq_id, size_t msgsz);
 
@@ -158,6 +214,22 @@ int msgsnd_guarded(int mq_id, const void *msg, size_t msgsz,
 ssize_t msgrcv_guarded(int mq_id, void *msg, size_t msgsz, long mtype,
                        int msgflg, int sem_id, int guard_idx);
 
+/**
+ * msgsnd_guarded dla komunikatow o zmiennej dlugosci: straznik liczy
+ * jednostki po unit bajtow, komunikat zajmuje ceil(msgsz / unit).
+ * unit = 0 - jeden slot na komunikat (jak msgsnd_guarded).
+ */
+int msgsnd_guarded_unit(int mq_id, const void *msg, size_t msgsz,
+                        int sem_id, int guard_idx, size_t unit);
+
+/**
+ * msgrcv_guarded dla komunikatow o zmiennej dlugosci: zwalnia
+ * ceil(odebrane bajty / unit) jednostek straznika.
+ * @return Liczba bajtow danych lub -1 przy bledzie
+ */
+ssize_t msgrcv_guarded_unit(int mq_id, void *msg, size_t msgsz, long mtype,
+                            int msgflg, int sem_id, int guard_idx, size_t unit);
+
 /* ===== Lacza (Pipes & FIFOs) ===== */
 
 /**
@@ -177,6 +249,39 @@ void create_fifo(const char *path);
  */
 void remove_fifo(const char *path);
 
+/* ===== Zegar symulacji (licznik tykniec + futex) ===== */
+
+/**
+ * Zapas (w minutach symulacji) limitu awaryjnego wait_until_tick() -
+ * gdy kierownik nie tyka (spawn, zatrzymanie), czekajacy budza sie sami.
+ */
+#define TICK_WAIT_SLACK 2
+
+/**
+ * Aktualna wartosc licznika tykniec SharedData.tick.
+ */
+uint32_t sim_tick_now(const SharedData *shm);
+
+/**
+ * Kierownik: zwieksza licznik o minutes i budzi wszystkich czekajacych
+ * (FUTEX_WAKE tylko gdy tick_waiters > 0).
+ */
+void tick_publish(SharedData *shm, uint32_t minutes);
+
+/**
+ * Budzi czekajacych bez zmiany licznika (zamykanie symulacji).
+ */
+void tick_wake_all(SharedData *shm);
+
+/**
+ * Usypia proces do tykniecia target (futex na SharedData.tick) zamiast
+ * wlasnego usleep() - opoznienia liczone w minutach leza na zegarze
+ * kierownika. Limit awaryjny: (target - teraz + TICK_WAIT_SLACK) minut.
+ * @return 0 - tykniecie osiagniete, 1 - limit awaryjny,
+ *         -1 - sygnal (EINTR) lub symulacja zatrzymana
+ */
+int wait_until_tick(SharedData *shm, uint32_t target);
+
 /* ===== Czyszczenie wszystkich zasobow IPC ===== */
 
 /**
@@ -0,0 +1,206 @@
+/**
+ * journal.c - Implementacja binarnego dziennika zdarzen
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Kierownik tworzy plik (creat + ftruncate) i zapisuje naglowek,
+ * procesy potomne mapuja go z MAP_SHARED. Slot rekordu rezerwowany jest
+ * atomowo w pamieci dzielonej - brak semaforow na goracej sciezce.
+ */
+
+#include "journal.h"
+#include "error_handler.h"
+#include "seqlock.h"
+#include <sys/mman.h>
+
+JournalRecord *g_journal_records = NULL;
+
+/* Zmienne globalne modulu */
+static SharedData    *g_shm        = NULL;
+static JournalHeader *g_header     = NULL;
+static size_t         g_map_len    = 0;
+static uint8_t        g_proc_type  = PROC_MANAGER;
+
+static const char *const EVENT_NAMES[EV_COUNT] = {
+    [0]                  = "NONE",
+    [EV_CUST_SPAWN]      = "CUST_SPAWN",
+    [EV_CUST_ENTRY_WAIT] = "CUST_ENTRY_WAIT",
+    [EV_CUST_ENTER]      = "CUST_ENTER",
+    [EV_CUST_PICK]       = "CUST_PICK",
+    [EV_CUST_CHECKOUT]   = "CUST_CHECKOUT",
+    [EV_CUST_RECEIPT]    = "CUST_RECEIPT",
+    [EV_CUST_EXIT]       = "CUST_EXIT",
+    [EV_CASH_SCAN_START] = "CASH_SCAN_START",
+    [EV_CASH_SCAN_END]   = "CASH_SCAN_END",
+    [EV_BAKE_BATCH]      = "BAKE_BATCH",
+    [EV_BAKE_START]      = "BAKE_START",
+    [EV_SAMPLE_CONVEYOR] = "SAMPLE_CONVEYOR",
+    [EV_SAMPLE_QUEUES]   = "SAMPLE_QUEUES",
+    [EV_COMMAND]         = "COMMAND",
+};
+
+static const char *const COMMAND_NAMES[CMD_COUNT] = {
+    [CMD_UNKNOWN]       = "nieznane",
+    [CMD_INVENTORY]     = "inwentaryzacja",
+    [CMD_EVACUATE]      = "ewakuacja",
+    [CMD_LOG]           = "log",
+    [CMD_SCALE]         = "set skala",
+    [CMD_MAX_CUSTOMERS] = "set n",
+    [CMD_ARRIVALS]      = "set przybycia",
+    [CMD_REGISTER_PCT]  = "set kasa",
+    [CMD_BAKERS]        = "set piekarze",
+};
+
+/*
+ * journal_map - Mapuje plik dziennika (wspolne dla create i attach).
+ */
+static int journal_map(int fd, uint64_t capacity)
+{
+    g_map_len = sizeof(JournalHeader) + capacity * sizeof(JournalRecord);
+    void *p = mmap(NULL, g_map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        handle_warning("mmap (journal)");
+        g_map_len = 0;
+        return -1;
+    }
+
+    g_header          = (JournalHeader *)p;
+    g_journal_records = (JournalRecord *)(g_header + 1);
+    return 0;
+}
+
+/*
+ * journal_create - Tworzy i mapuje plik dziennika (kierownik).
+ */
+int journal_create(SharedData *shm, const char *path, uint64_t capacity)
+{
+    shm->journal_capacity = 0;
+    shm->journal_next     = 0;
+    shm->journal_dropped  = 0;
+    if (capacity == 0)
+        return 0;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        handle_warning("open (journal)");
+        return -1;
+    }
+
+    off_t len = (off_t)(sizeof(JournalHeader) + capacity * sizeof(JournalRecord));
+    if (ftruncate(fd, len) == -1) {
+        handle_warning("ftruncate (journal)");
+        close(fd);
+        return -1;
+    }
+
+    if (journal_map(fd, capacity) == -1) {
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    memcpy(g_header->magic, JOURNAL_MAGIC, sizeof(g_header->magic));
+    g_header->version     = JOURNAL_VERSION;
+    g_header->record_size = sizeof(JournalRecord);
+    g_header->capacity    = capacity;
+    g_header->start_ns    = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+
+    g_shm       = shm;
+    g_proc_type = PROC_MANAGER;
+    shm->journal_capacity = capacity;
+    return 0;
+}
+
+/*
+ * journal_attach - Dolacza proces potomny do dziennika (jesli wlaczony).
+ */
+void journal_attach(SharedData *shm, const char *path, ProcessType type)
+{
+    if (shm == NULL || shm->journal_capacity == 0)
+        return;
+
+    int fd = open(path, O_RDWR);
+    if (fd == -1) {
+        handle_warning("open (journal attach)");
+        return;
+    }
+    if (journal_map(fd, shm->journal_capacity) == 0) {
+        g_shm       = shm;
+        g_proc_type = (uint8_t)type;
+    }
+    close(fd);
+}
+
+/*
+ * journal_write - Rezerwuje slot i zapisuje rekord.
+ * Pole event zapisywane jest na koncu (release) - slot z event != 0
+ * jest kompletny.
+ */
+void journal_write(int event, int pid, int actor, int a0, int a1, int a2)
+{
+    uint64_t idx = __atomic_fetch_add(&g_shm->journal_next, 1, __ATOMIC_RELAXED);
+    if (idx >= g_shm->journal_capacity) {
+        __atomic_fetch_add(&g_shm->journal_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    JournalRecord *r = &g_journal_records[idx];
+    r->ts_ns     = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    int hour, min;
+    shm_read_clock(g_shm, &hour, &min);
+    r->sim_min   = (uint16_t)(hour * 60 + min);
+    r->proc_type = g_proc_type;
+    r->pid       = pid;
+    r->actor     = actor;
+    r->arg[0]    = a0;
+    r->arg[1]    = a1;
+    r->arg[2]    = a2;
+    __atomic_store_n(&r->event, (uint8_t)event, __ATOMIC_RELEASE);
+}
+
+/*
+ * journal_close - Odmapowuje dziennik; kierownik uzupelnia naglowek.
+ */
+void journal_close(int finalize)
+{
+    if (g_header == NULL)
+        return;
+
+    if (finalize && g_shm != NULL) {
+        uint64_t next = __atomic_load_n(&g_shm->journal_next, __ATOMIC_ACQUIRE);
+        g_header->count   = (next < g_header->capacity) ? next : g_header->capacity;
+        g_header->dropped = __atomic_load_n(&g_shm->journal_dropped, __ATOMIC_RELAXED);
+        msync(g_header, g_map_len, MS_SYNC);
+    }
+
+    munmap(g_header, g_map_len);
+    g_header          = NULL;
+    g_journal_records = NULL;
+    g_map_len         = 0;
+    g_shm             = NULL;
+}
+
+/*
+ * journal_event_name - Nazwa zdarzenia do wydrukow dekodera.
+ */
+const char *journal_event_name(int event)
+{
+    if (event < 0 || event >= EV_COUNT || EVENT_NAMES[event] == NULL)
+        return "UNKNOWN";
+    return EVENT_NAMES[event];
+}
+
+/*
+ * journal_command_name - Nazwa polecenia FIFO (actor EV_COMMAND).
+ */
+const char *journal_command_name(int cmd)
+{
+    if (cmd < 0 || cmd >= CMD_COUNT)
+        return COMMAND_NAMES[CMD_UNKNOWN];
+    return COMMAND_NAMES[cmd];
+}
@@ -0,0 +1,142 @@
+/**
+ * journal.h - Binarny dziennik zdarzen symulacji
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Plik mapowany w pamiec (mmap, MAP_SHARED), tylko do dopisywania.
+ * Rekordy maja staly rozmiar; kazdy proces rezerwuje slot atomowym
+ * zwiekszeniem SharedData.journal_next, wiec zapis nie wymaga semafora.
+ * Dekoder: journal_dump (CSV, JSON, przebieg klienta, opoznienia faz,
+ * trace-event JSON dla chrome://tracing / Perfetto).
+ *
+ * Wylaczony dziennik (brak -j) kosztuje jedno porownanie wskaznika.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "common.h"
+#include <stdint.h>
+
+#define JOURNAL_MAGIC   "CIASTJNL"
+#define JOURNAL_VERSION 1
+
+/**
+ * Typy zdarzen. Pola rekordu: pid = PID klienta, ktorego zdarzenie dotyczy
+ * (lub PID procesu dla piekarza), actor = numer kasy / watku piekarza.
+ */
+typedef enum {
+    EV_CUST_SPAWN      = 1,  /* kierownik: fork klienta */
+    EV_CUST_ENTRY_WAIT = 2,  /* klient: czeka na wejscie (exec zakonczony) */
+    EV_CUST_ENTER      = 3,  /* klient: wszedl do sklepu */
+    EV_CUST_PICK       = 4,  /* klient: arg0=produkt, arg1=pobrano, arg2=prob */
+    EV_CUST_CHECKOUT   = 5,  /* klient: w kolejce; arg0=kasa, arg1=sztuk */
+    EV_CUST_RECEIPT    = 6,  /* klient: paragon odebrany; arg0=grosze */
+    EV_CUST_EXIT       = 7,  /* klient: wyjscie; arg0=CustomerExit */
+    EV_CASH_SCAN_START = 8,  /* kasjer: poczatek skanowania; actor=kasa */
+    EV_CASH_SCAN_END   = 9,  /* kasjer: koniec skanowania; arg0=sztuk, arg1=grosze */
+    EV_BAKE_BATCH      = 10, /* piekarz: arg0=produkt, arg1=polozono, arg2=zadano */
+    EV_BAKE_START      = 11, /* piekarz: poczatek ukladania partii; actor=watek */
+    EV_SAMPLE_CONVEYOR = 12, /* kierownik: actor=produkt, arg0=zapelnienie, arg1=pojemnosc */
+    EV_SAMPLE_QUEUES   = 13, /* kierownik: arg0/arg1=kolejka kasy 1/2, arg2=w sklepie */
+    EV_COMMAND         = 14, /* kierownik: actor=FifoCommand, arg0=1 przyjete, arg1=stara, arg2=nowa */
+    EV_COUNT
+} JournalEvent;
+
+/** Powod wyjscia klienta (arg0 zdarzenia EV_CUST_EXIT). */
+typedef enum {
+    EXIT_SERVED        = 0,  /* obsluzony (paragon) */
+    EXIT_EMPTY_CART    = 1,  /* nic nie kupil */
+    EXIT_SHOP_CLOSED   = 2,  /* sklep zamkniety przed wejsciem */
+    EXIT_ENTRY_TIMEOUT = 3,  /* zbyt dlugo czekal na wejscie */
+    EXIT_EVACUATION    = 4,  /* ewakuacja */
+    EXIT_NO_RECEIPT    = 5   /* timeout czekania na paragon */
+} CustomerExit;
+
+/** Polecenie FIFO kierownika (actor zdarzenia EV_COMMAND). */
+typedef enum {
+    CMD_UNKNOWN       = 0,
+    CMD_INVENTORY     = 1,  /* inwentaryzacja */
+    CMD_EVACUATE      = 2,  /* ewakuacja */
+    CMD_LOG           = 3,  /* log <spec> */
+    CMD_SCALE         = 4,  /* set skala <ms> */
+    CMD_MAX_CUSTOMERS = 5,  /* set n <N> */
+    CMD_ARRIVALS      = 6,  /* set przybycia <klientow/tykniecie> */
+    CMD_REGISTER_PCT  = 7,  /* set kasa <% N> */
+    CMD_BAKERS        = 8,  /* set piekarze <watki> */
+    CMD_COUNT
+} FifoCommand;
+
+/**
+ * Rekord dziennika - 32 bajty, bez dopelnien.
+ */
+typedef struct {
+    uint64_t ts_ns;      /* CLOCK_MONOTONIC w ns */
+    uint16_t sim_min;    /* Czas symulacji: godzina*60 + minuta */
+    uint8_t  proc_type;  /* ProcessType */
+    uint8_t  event;      /* JournalEvent (0 = slot niezapisany) */
+    int32_t  pid;
+    int32_t  actor;
+    int32_t  arg[3];
+} JournalRecord;
+
+/**
+ * Naglowek pliku (64 bajty), rekordy zaczynaja sie zaraz za nim.
+ */
+typedef struct {
+    char     magic[8];       /* JOURNAL_MAGIC */
+    uint32_t version;
+    uint32_t record_size;    /* sizeof(JournalRecord) */
+    uint64_t capacity;       /* Liczba slotow w pliku */
+    uint64_t count;          /* Zapisane rekordy (uzupelniane przy zamknieciu) */
+    uint64_t dropped;        /* Zdarzenia odrzucone (plik pelny) */
+    uint64_t start_ns;       /* CLOCK_MONOTONIC przy utworzeniu */
+    uint8_t  reserved[16];
+} JournalHeader;
+
+/** Rekordy dziennika; NULL = dziennik wylaczony. */
+extern JournalRecord *g_journal_records;
+
+/**
+ * Zapisuje zdarzenie do dziennika. Przy wylaczonym dzienniku jedno porownanie,
+ * argumenty nie sa wyliczane.
+ */
+#define JOURNAL(ev, pid, actor, a0, a1, a2) \
+    do { if (g_journal_records != NULL) \
+        journal_write((ev), (pid), (actor), (a0), (a1), (a2)); } while (0)
+
+/**
+ * Tworzy plik dziennika o pojemnosci capacity rekordow i mapuje go
+ * (wywoluje kierownik). Zapisuje pojemnosc do SHM - procesy potomne
+ * dolaczaja przez journal_attach().
+ * @return 0 przy sukcesie, -1 przy bledzie (dziennik pozostaje wylaczony)
+ */
+int journal_create(SharedData *shm, const char *path, uint64_t capacity);
+
+/**
+ * Dolacza do dziennika utworzonego przez kierownika (jesli wlaczony).
+ * @param type Typ procesu zapisywany w rekordach
+ */
+void journal_attach(SharedData *shm, const char *path, ProcessType type);
+
+/**
+ * Zapisuje zdarzenie (uzywac przez makro JOURNAL).
+ */
+void journal_write(int event, int pid, int actor, int a0, int a1, int a2);
+
+/**
+ * Odmapowuje dziennik. Kierownik (finalize=1) uzupelnia naglowek
+ * o liczbe rekordow i odrzuconych zdarzen.
+ */
+void journal_close(int finalize);
+
+/**
+ * Nazwa zdarzenia (np. "CUST_ENTER").
+ */
+const char *journal_event_name(int event);
+
+/**
+ * Nazwa polecenia FIFO (np. "set skala").
+ */
+const char *journal_command_name(int cmd);
+
+#endif /* JOURNAL_H */
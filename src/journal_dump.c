@@ -0,0 +1,597 @@
+/**
+ * @file journal_dump.c
+ * @brief Dekoder binarnego dziennika zdarzen (logs/journal.bin).
+ *
+ * Formaty wyjscia (-f):
+ *   csv       - jeden rekord na linie (domyslnie)
+ *   json      - tablica obiektow JSON
+ *   timeline  - przebieg kazdego klienta: czasy etapow od spawn (ms)
+ *   phases    - rozklad opoznien faz wizyty (n, srednia, p50/p90/p99, max)
+ *   trace     - Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev):
+ *               tor na watek piekarza, na kase i na klienta, liczniki
+ *               zapelnienia podajnikow i dlugosci kolejek do kas
+ *
+ * Uzycie: ./journal_dump [-f csv|json|timeline|phases|trace] [plik_dziennika]
+ * Zwraca 0 przy sukcesie, 1 jesli plik nie jest poprawnym dziennikiem.
+ */
+
+#include "common.h"
+#include "journal.h"
+
+static const char *const PROC_NAMES[NUM_PROC_TYPES] = {
+    "kierownik", "piekarz", "kasjer", "klient"
+};
+
+/* Etapy wizyty klienta rekonstruowane z dziennika */
+enum {
+    ST_SPAWN, ST_ENTRY_WAIT, ST_ENTER, ST_CHECKOUT,
+    ST_SCAN_START, ST_SCAN_END, ST_RECEIPT, ST_EXIT, ST_COUNT
+};
+
+static const char *const STAGE_NAMES[ST_COUNT] = {
+    "spawn", "entry_wait", "enter", "checkout",
+    "scan_start", "scan_end", "receipt", "exit"
+};
+
+/* Fazy = roznice miedzy etapami */
+typedef struct {
+    const char *name;
+    int from, to;
+} PhaseDef;
+
+static const PhaseDef PHASES[] = {
+    { "start_procesu",   ST_SPAWN,      ST_ENTRY_WAIT },
+    { "wejscie",         ST_ENTRY_WAIT, ST_ENTER      },
+    { "zakupy",          ST_ENTER,      ST_CHECKOUT   },
+    { "kolejka_do_kasy", ST_CHECKOUT,   ST_SCAN_START },
+    { "skanowanie",      ST_SCAN_START, ST_SCAN_END   },
+    { "dostarczenie",    ST_SCAN_END,   ST_RECEIPT    },
+    { "wizyta",          ST_SPAWN,      ST_EXIT       },
+};
+#define NUM_PHASES ((int)(sizeof(PHASES) / sizeof(PHASES[0])))
+
+typedef struct {
+    int      pid;
+    uint64_t t[ST_COUNT];   /* 0 = etap nie wystapil */
+    int      exit_reason;
+    int      reg;
+    int      items;
+    int      total_gr;
+    int      picks;
+} Visit;
+
+/* ================================================================
+ *  WCZYTYWANIE
+ * ================================================================ */
+
+static JournalRecord *load_journal(const char *path, JournalHeader *hdr, size_t *out_n)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+
+    if (fread(hdr, sizeof(*hdr), 1, f) != 1 ||
+        memcmp(hdr->magic, JOURNAL_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->record_size != sizeof(JournalRecord)) {
+        fprintf(stderr, "%s: to nie jest dziennik symulacji (v%d)\n",
+                path, JOURNAL_VERSION);
+        fclose(f);
+        return NULL;
+    }
+
+    /* count == 0 - dziennik nie zamkniety poprawnie, czytaj wszystkie sloty */
+    uint64_t n = hdr->count ? hdr->count : hdr->capacity;
+    JournalRecord *recs = malloc(n * sizeof(JournalRecord) + 1);
+    if (recs == NULL) {
+        perror("malloc");
+        fclose(f);
+        return NULL;
+    }
+    n = fread(recs, sizeof(JournalRecord), n, f);
+    fclose(f);
+
+    /* Odrzuc sloty zarezerwowane, ale niezapisane */
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (recs[i].event != 0)
+            recs[k++] = recs[i];
+    }
+    *out_n = k;
+    return recs;
+}
+
+static int cmp_ts(const void *a, const void *b)
+{
+    const JournalRecord *x = a, *y = b;
+    return (x->ts_ns > y->ts_ns) - (x->ts_ns < y->ts_ns);
+}
+
+static int cmp_pid_ts(const void *a, const void *b)
+{
+    const JournalRecord *x = a, *y = b;
+    if (x->pid != y->pid) return (x->pid > y->pid) - (x->pid < y->pid);
+    return cmp_ts(a, b);
+}
+
+/* ================================================================
+ *  CSV / JSON
+ * ================================================================ */
+
+static const char *proc_name(int t)
+{
+    return (t >= 0 && t < NUM_PROC_TYPES) ? PROC_NAMES[t] : "?";
+}
+
+static void dump_csv(const JournalRecord *r, size_t n, uint64_t t0)
+{
+    printf("t_us,sim_time,proc,event,pid,actor,arg0,arg1,arg2\n");
+    for (size_t i = 0; i < n; i++) {
+        printf("%llu,%02d:%02d,%s,%s,%d,%d,%d,%d,%d\n",
+               (unsigned long long)((r[i].ts_ns - t0) / 1000),
+               r[i].sim_min / 60, r[i].sim_min % 60,
+               proc_name(r[i].proc_type), journal_event_name(r[i].event),
+               r[i].pid, r[i].actor, r[i].arg[0], r[i].arg[1], r[i].arg[2]);
+    }
+}
+
+static void dump_json(const JournalRecord *r, size_t n, uint64_t t0)
+{
+    printf("[\n");
+    for (size_t i = 0; i < n; i++) {
+        printf("  {\"t_us\":%llu,\"sim_time\":\"%02d:%02d\",\"proc\":\"%s\","
+               "\"event\":\"%s\",\"pid\":%d,\"actor\":%d,\"args\":[%d,%d,%d]}%s\n",
+               (unsigned long long)((r[i].ts_ns - t0) / 1000),
+               r[i].sim_min / 60, r[i].sim_min % 60,
+               proc_name(r[i].proc_type), journal_event_name(r[i].event),
+               r[i].pid, r[i].actor, r[i].arg[0], r[i].arg[1], r[i].arg[2],
+               (i + 1 < n) ? "," : "");
+    }
+    printf("]\n");
+}
+
+/* ================================================================
+ *  REKONSTRUKCJA WIZYT KLIENTOW
+ * ================================================================ */
+
+/**
+ * Grupuje rekordy klientow po PID (posortowane pid, ts) w wizyty.
+ * Kolejny CUST_SPAWN z tym samym PID (reuse PID) otwiera nowa wizyte.
+ */
+static Visit *build_visits(JournalRecord *r, size_t n, size_t *out_n)
+{
+    qsort(r, n, sizeof(JournalRecord), cmp_pid_ts);
+
+    Visit *v = calloc(n + 1, sizeof(Visit));
+    if (v == NULL) {
+        perror("calloc");
+        return NULL;
+    }
+
+    size_t nv = 0;
+    Visit *cur = NULL;
+    for (size_t i = 0; i < n; i++) {
+        int st = -1;
+        switch (r[i].event) {
+            case EV_CUST_SPAWN:      st = ST_SPAWN;      break;
+            case EV_CUST_ENTRY_WAIT: st = ST_ENTRY_WAIT; break;
+            case EV_CUST_ENTER:      st = ST_ENTER;      break;
+            case EV_CUST_CHECKOUT:   st = ST_CHECKOUT;   break;
+            case EV_CASH_SCAN_START: st = ST_SCAN_START; break;
+            case EV_CASH_SCAN_END:   st = ST_SCAN_END;   break;
+            case EV_CUST_RECEIPT:    st = ST_RECEIPT;    break;
+            case EV_CUST_EXIT:       st = ST_EXIT;       break;
+            case EV_CUST_PICK:       break;
+            default:                 continue; /* zdarzenia piekarza itp. */
+        }
+
+        if (cur == NULL || cur->pid != r[i].pid ||
+            (st == ST_SPAWN && cur->t[ST_SPAWN] != 0)) {
+            cur = &v[nv++];
+            cur->pid = r[i].pid;
+            cur->exit_reason = -1;
+            cur->reg = -1;
+        }
+
+        if (r[i].event == EV_CUST_PICK) {
+            cur->picks += r[i].arg[1];
+            continue;
+        }
+        if (cur->t[st] == 0)
+            cur->t[st] = r[i].ts_ns;
+
+        if (st == ST_EXIT)       cur->exit_reason = r[i].arg[0];
+        if (st == ST_CHECKOUT) { cur->reg = r[i].arg[0]; cur->items = r[i].arg[1]; }
+        if (st == ST_RECEIPT)    cur->total_gr = r[i].arg[0];
+    }
+
+    *out_n = nv;
+    return v;
+}
+
+static void dump_timeline(const Visit *v, size_t nv)
+{
+    printf("pid,exit_reason,register,items,total_pln");
+    for (int s = 1; s < ST_COUNT; s++)
+        printf(",%s_ms", STAGE_NAMES[s]);
+    printf("\n");
+
+    for (size_t i = 0; i < nv; i++) {
+        printf("%d,%d,%d,%d,%.2f", v[i].pid, v[i].exit_reason,
+               v[i].reg >= 0 ? v[i].reg + 1 : 0, v[i].items,
+               v[i].total_gr / 100.0);
+        for (int s = 1; s < ST_COUNT; s++) {
+            if (v[i].t[ST_SPAWN] && v[i].t[s])
+                printf(",%.3f", (double)(v[i].t[s] - v[i].t[ST_SPAWN]) / 1e6);
+            else
+                printf(",");
+        }
+        printf("\n");
+    }
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double pct_ms(const uint64_t *sorted, size_t n, double p)
+{
+    size_t idx = (size_t)(p * (double)(n - 1) + 0.5);
+    return sorted[idx] / 1e6;
+}
+
+static void dump_phases(const Visit *v, size_t nv)
+{
+    uint64_t *d = malloc((nv + 1) * sizeof(uint64_t));
+    if (d == NULL) {
+        perror("malloc");
+        return;
+    }
+
+    printf("faza,n,srednia_ms,p50_ms,p90_ms,p99_ms,max_ms\n");
+    for (int p = 0; p < NUM_PHASES; p++) {
+        size_t n = 0;
+        double sum = 0.0;
+        for (size_t i = 0; i < nv; i++) {
+            uint64_t a = v[i].t[PHASES[p].from], b = v[i].t[PHASES[p].to];
+            if (a == 0 || b == 0 || b < a) continue;
+            d[n++] = b - a;
+            sum += (double)(b - a);
+        }
+        if (n == 0) {
+            printf("%s,0,,,,,\n", PHASES[p].name);
+            continue;
+        }
+        qsort(d, n, sizeof(uint64_t), cmp_u64);
+        printf("%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f\n", PHASES[p].name, n,
+               sum / (double)n / 1e6, pct_ms(d, n, 0.50), pct_ms(d, n, 0.90),
+               pct_ms(d, n, 0.99), d[n - 1] / 1e6);
+    }
+
+    /* Podsumowanie powodow wyjscia */
+    int reasons[8] = {0};
+    for (size_t i = 0; i < nv; i++) {
+        if (v[i].exit_reason >= 0 && v[i].exit_reason < 8)
+            reasons[v[i].exit_reason]++;
+    }
+    printf("\nwizyt=%zu obsluzeni=%d pusty_koszyk=%d zamkniete=%d "
+           "timeout_wejscia=%d ewakuacja=%d brak_paragonu=%d\n",
+           nv, reasons[EXIT_SERVED], reasons[EXIT_EMPTY_CART],
+           reasons[EXIT_SHOP_CLOSED], reasons[EXIT_ENTRY_TIMEOUT],
+           reasons[EXIT_EVACUATION], reasons[EXIT_NO_RECEIPT]);
+    free(d);
+}
+
+/* ================================================================
+ *  EKSPORT TRACE (Chrome trace-event JSON)
+ * ================================================================ */
+
+/* "Procesy" w przegladarce trace - grupy torow */
+enum { TR_BAKER = 1, TR_CASH = 2, TR_CUST = 3, TR_COUNTERS = 4 };
+
+/* Tory watkow piekarza i kas; liczniki podajnikow maja osobny zakres
+ * (aktor = indeks produktu, do MAX_PRODUCTS) */
+#define MAX_TRACE_ACTORS 64
+
+static int g_trace_first = 1;
+
+static double trace_us(uint64_t ts, uint64_t t0)
+{
+    return ts > t0 ? (double)(ts - t0) / 1000.0 : 0.0;
+}
+
+/* Wypisuje separator miedzy zdarzeniami tablicy traceEvents */
+static void trace_sep(void)
+{
+    if (!g_trace_first) printf(",\n");
+    g_trace_first = 0;
+}
+
+static void trace_meta(const char *what, int pid, int tid, const char *name)
+{
+    trace_sep();
+    printf("{\"ph\":\"M\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,"
+           "\"args\":{\"name\":\"%s\"}}", what, pid, tid, name);
+}
+
+/* Zdarzenie "X" (span); args - gotowy fragment JSON bez nawiasow lub NULL */
+static void trace_span(int pid, int tid, const char *name, uint64_t from,
+                       uint64_t to, uint64_t t0, const char *args)
+{
+    if (from == 0 || to < from) return;
+    trace_sep();
+    printf("{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,"
+           "\"ts\":%.3f,\"dur\":%.3f,\"args\":{%s}}",
+           name, pid, tid, trace_us(from, t0),
+           (double)(to - from) / 1000.0, args ? args : "");
+}
+
+static void trace_counter(const char *name, uint64_t ts, uint64_t t0, const char *args)
+{
+    trace_sep();
+    printf("{\"ph\":\"C\",\"name\":\"%s\",\"pid\":%d,\"ts\":%.3f,\"args\":{%s}}",
+           name, TR_COUNTERS, trace_us(ts, t0), args);
+}
+
+/* Zdarzenie "i" (chwilowe, zasieg globalny) - np. polecenie FIFO */
+static void trace_instant(const char *name, uint64_t ts, uint64_t t0, const char *args)
+{
+    trace_sep();
+    printf("{\"ph\":\"i\",\"s\":\"g\",\"name\":\"%s\",\"pid\":%d,\"tid\":0,"
+           "\"ts\":%.3f,\"args\":{%s}}",
+           name, TR_COUNTERS, trace_us(ts, t0), args);
+}
+
+/**
+ * Tory piekarza, kas i liczniki - rekordy posortowane po czasie.
+ */
+static void trace_actors(const JournalRecord *r, size_t n, uint64_t t0)
+{
+    uint64_t bake_last[MAX_TRACE_ACTORS] = {0};
+    uint64_t scan_start[MAX_TRACE_ACTORS] = {0};
+    int      seen_bake[MAX_TRACE_ACTORS] = {0};
+    int      seen_cash[MAX_TRACE_ACTORS] = {0};
+    char name[64], args[128];
+
+    for (size_t i = 0; i < n; i++) {
+        int a = r[i].actor;
+        if (a < 0) continue;
+
+        switch (r[i].event) {
+            case EV_BAKE_START:
+                if (a >= MAX_TRACE_ACTORS) break;
+                if (!seen_bake[a]) {
+                    seen_bake[a] = 1;
+                    snprintf(name, sizeof(name), "watek %d", a);
+                    trace_meta("thread_name", TR_BAKER, a, name);
+                }
+                bake_last[a] = r[i].ts_ns;
+                break;
+
+            case EV_BAKE_BATCH:
+                if (a >= MAX_TRACE_ACTORS) break;
+                /* Span od poczatku partii / poprzedniego produktu */
+                snprintf(name, sizeof(name), "podajnik %d", r[i].arg[0]);
+                snprintf(args, sizeof(args), "\"polozono\":%d,\"zadano\":%d",
+                         r[i].arg[1], r[i].arg[2]);
+                trace_span(TR_BAKER, a, name, bake_last[a], r[i].ts_ns, t0, args);
+                bake_last[a] = r[i].ts_ns;
+                break;
+
+            case EV_CASH_SCAN_START:
+                if (a >= MAX_TRACE_ACTORS) break;
+                if (!seen_cash[a]) {
+                    seen_cash[a] = 1;
+                    snprintf(name, sizeof(name), "kasa %d", a + 1);
+                    trace_meta("thread_name", TR_CASH, a, name);
+                }
+                scan_start[a] = r[i].ts_ns;
+                break;
+
+            case EV_CASH_SCAN_END:
+                if (a >= MAX_TRACE_ACTORS) break;
+                snprintf(args, sizeof(args),
+                         "\"klient\":%d,\"sztuk\":%d,\"zl\":%.2f",
+                         r[i].pid, r[i].arg[0], r[i].arg[1] / 100.0);
+                trace_span(TR_CASH, a, "skanowanie", scan_start[a],
+                           r[i].ts_ns, t0, args);
+                scan_start[a] = 0;
+                break;
+
+            case EV_SAMPLE_CONVEYOR:
+                if (a >= MAX_PRODUCTS) break;
+                snprintf(name, sizeof(name), "podajnik %d", a);
+                snprintf(args, sizeof(args), "\"zapelnienie\":%d", r[i].arg[0]);
+                trace_counter(name, r[i].ts_ns, t0, args);
+                break;
+
+            case EV_SAMPLE_QUEUES:
+                snprintf(args, sizeof(args), "\"kasa 1\":%d,\"kasa 2\":%d",
+                         r[i].arg[0], r[i].arg[1]);
+                trace_counter("kolejki do kas", r[i].ts_ns, t0, args);
+                snprintf(args, sizeof(args), "\"klienci\":%d", r[i].arg[2]);
+                trace_counter("w sklepie", r[i].ts_ns, t0, args);
+                break;
+
+            case EV_COMMAND:
+                snprintf(args, sizeof(args),
+                         "\"przyjete\":%d,\"stara\":%d,\"nowa\":%d",
+                         r[i].arg[0], r[i].arg[1], r[i].arg[2]);
+                trace_instant(journal_command_name(a), r[i].ts_ns, t0, args);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * Tory klientow - rekordy posortowane (pid, ts). Tor = PID klienta;
+ * kolejne wizyty z tym samym PID nie nakladaja sie w czasie.
+ * Spany zakupow per podajnik lacza kolejne pobrania tego samego produktu.
+ */
+static void trace_customers(const JournalRecord *r, size_t n, uint64_t t0)
+{
+    uint64_t t[ST_COUNT] = {0};
+    uint64_t last_ts = 0, pick_from = 0;
+    int cur_pid = -1, pick_prod = -1, pick_got = 0, pick_tries = 0;
+    char name[64], args[128];
+
+    for (size_t i = 0; i <= n; i++) {
+        int ev = (i < n) ? r[i].event : 0;
+        int pid = (i < n) ? r[i].pid : -1;
+
+        if (i < n && ev != EV_CUST_SPAWN && ev != EV_CUST_ENTRY_WAIT &&
+            ev != EV_CUST_ENTER && ev != EV_CUST_PICK &&
+            ev != EV_CUST_CHECKOUT && ev != EV_CASH_SCAN_START &&
+            ev != EV_CASH_SCAN_END && ev != EV_CUST_RECEIPT &&
+            ev != EV_CUST_EXIT)
+            continue;
+
+        /* Zamknij otwarty span podajnika przy zmianie produktu lub wizyty */
+        if (pick_prod >= 0 && (pid != cur_pid || ev != EV_CUST_PICK ||
+                               r[i].arg[0] != pick_prod)) {
+            snprintf(name, sizeof(name), "podajnik %d", pick_prod);
+            snprintf(args, sizeof(args), "\"pobrano\":%d,\"prob\":%d",
+                     pick_got, pick_tries);
+            trace_span(TR_CUST, cur_pid, name, pick_from, last_ts, t0, args);
+            pick_prod = -1;
+        }
+
+        if (i == n) break;
+
+        if (pid != cur_pid || (ev == EV_CUST_SPAWN && t[ST_SPAWN] != 0)) {
+            if (pid != cur_pid) {
+                snprintf(name, sizeof(name), "klient %d", pid);
+                trace_meta("thread_name", TR_CUST, pid, name);
+            }
+            memset(t, 0, sizeof(t));
+            cur_pid = pid;
+            last_ts = 0;
+        }
+
+        uint64_t ts = r[i].ts_ns;
+        switch (ev) {
+            case EV_CUST_SPAWN:
+                t[ST_SPAWN] = ts;
+                break;
+            case EV_CUST_ENTRY_WAIT:
+                t[ST_ENTRY_WAIT] = ts;
+                trace_span(TR_CUST, pid, "start procesu", t[ST_SPAWN], ts, t0, NULL);
+                break;
+            case EV_CUST_ENTER:
+                t[ST_ENTER] = ts;
+                trace_span(TR_CUST, pid, "czeka na wejscie", t[ST_ENTRY_WAIT], ts, t0, NULL);
+                break;
+            case EV_CUST_PICK:
+                if (pick_prod < 0) {
+                    pick_prod  = r[i].arg[0];
+                    pick_from  = last_ts;
+                    pick_got   = 0;
+                    pick_tries = 0;
+                }
+                pick_got   += r[i].arg[1];
+                pick_tries += r[i].arg[2] + 1;
+                break;
+            case EV_CUST_CHECKOUT:
+                t[ST_CHECKOUT] = ts;
+                trace_span(TR_CUST, pid, "zakupy", t[ST_ENTER], ts, t0, NULL);
+                break;
+            case EV_CASH_SCAN_START:
+                t[ST_SCAN_START] = ts;
+                snprintf(name, sizeof(name), "kolejka do kasy %d", r[i].actor + 1);
+                trace_span(TR_CUST, pid, name, t[ST_CHECKOUT], ts, t0, NULL);
+                break;
+            case EV_CASH_SCAN_END:
+                t[ST_SCAN_END] = ts;
+                trace_span(TR_CUST, pid, "skanowanie", t[ST_SCAN_START], ts, t0, NULL);
+                break;
+            case EV_CUST_RECEIPT:
+                t[ST_RECEIPT] = ts;
+                trace_span(TR_CUST, pid, "czeka na paragon", t[ST_SCAN_END], ts, t0, NULL);
+                break;
+            case EV_CUST_EXIT:
+                snprintf(args, sizeof(args), "\"powod_wyjscia\":%d", r[i].arg[0]);
+                trace_span(TR_CUST, pid, "wizyta", t[ST_SPAWN], ts, t0, args);
+                break;
+        }
+        last_ts = ts;
+    }
+}
+
+static void dump_trace(JournalRecord *r, size_t n, uint64_t t0)
+{
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    trace_meta("process_name", TR_BAKER, 0, "piekarz");
+    trace_meta("process_name", TR_CASH, 0, "kasy");
+    trace_meta("process_name", TR_CUST, 0, "klienci");
+    trace_meta("process_name", TR_COUNTERS, 0, "liczniki");
+
+    qsort(r, n, sizeof(JournalRecord), cmp_ts);
+    trace_actors(r, n, t0);
+    qsort(r, n, sizeof(JournalRecord), cmp_pid_ts);
+    trace_customers(r, n, t0);
+    printf("\n]}\n");
+}
+
+/* ================================================================
+ *  MAIN
+ * ================================================================ */
+
+int main(int argc, char *argv[])
+{
+    const char *format = "csv";
+    int opt;
+    while ((opt = getopt(argc, argv, "f:h")) != -1) {
+        switch (opt) {
+            case 'f':
+                format = optarg;
+                break;
+            default:
+                fprintf(stderr, "Uzycie: %s [-f csv|json|timeline|phases|trace] "
+                        "[plik_dziennika]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    const char *path = (optind < argc) ? argv[optind] : JOURNAL_FILE;
+
+    JournalHeader hdr;
+    size_t n = 0;
+    JournalRecord *recs = load_journal(path, &hdr, &n);
+    if (recs == NULL)
+        return 1;
+
+    if (hdr.dropped > 0)
+        fprintf(stderr, "UWAGA: %llu zdarzen odrzuconych (dziennik pelny, "
+                "pojemnosc %llu)\n", (unsigned long long)hdr.dropped,
+                (unsigned long long)hdr.capacity);
+
+    int rc = 0;
+    if (strcmp(format, "csv") == 0 || strcmp(format, "json") == 0) {
+        qsort(recs, n, sizeof(JournalRecord), cmp_ts);
+        if (format[0] == 'c') dump_csv(recs, n, hdr.start_ns);
+        else                  dump_json(recs, n, hdr.start_ns);
+    } else if (strcmp(format, "timeline") == 0 || strcmp(format, "phases") == 0) {
+        size_t nv = 0;
+        Visit *v = build_visits(recs, n, &nv);
+        if (v != NULL) {
+            if (format[0] == 't') dump_timeline(v, nv);
+            else                  dump_phases(v, nv);
+            free(v);
+        } else {
+            rc = 1;
+        }
+    } else if (strcmp(format, "trace") == 0) {
+        dump_trace(recs, n, hdr.start_ns);
+    } else {
+        fprintf(stderr, "Nieznany format: %s\n", format);
+        rc = 1;
+    }
+
+    free(recs);
+    return rc;
+}
@@ -13,13 +13,17 @@
  * - Checkout: kolejka komunikatow (msgrcv z mtype = register_id + 1)
  * - Paragony: kolejka komunikatow (msgsnd z mtype = customer_pid)
  * - Stan: pamiec dzielona
+ * - Ceny: lokalna tablica groszy (kopia katalogu z SHM przy starcie)
  * - Sygnaly: SIGUSR1 (inwentaryzacja), SIGUSR2 (ewakuacja), SIGTERM
  */
 
 #include "common.h"
 #include "error_handler.h"
 #include "ipc_utils.h"
+#include "ipc_channel.h"
 #include "logger.h"
+#include "journal.h"
+#include "histogram.h"
 
 /* ================================================================
  *  ZMIENNE GLOBALNE PROCESU
@@ -27,9 +31,23 @@
 
 static SharedData *g_shm         = NULL;
 static int         g_sem_id      = -1;
-static int         g_mq_checkout = -1;
-static int         g_mq_receipt  = -1;
+static const IpcBackend *g_ipc   = NULL;  /* Kanaly IPC (SharedData.ipc_backend) */
 static int         g_register_id = -1;  /* Numer kasy (0 lub 1) */
+static LatencyHist g_hist_queue;        /* HIST_CHECKOUT_QUEUE (scalany przy wyjsciu) */
+static LatencyHist g_hist_scan;         /* HIST_SCAN */
+
+/**
+ * Cennik kasy (struktura tablic): ceny w groszach skopiowane z katalogu
+ * przy starcie. Suma koszyka czyta tylko te tablice, nie ProductDef
+ * w SHM obok czesto zapisywanych licznikow. Katalog nie zmienia sie
+ * w trakcie symulacji - zmiana wymagalaby ponownego price_table_load().
+ */
+typedef struct {
+    int      n;
+    int32_t *price_gr;   /* [n], wyrownane do 64 B (linia cache) */
+} PriceTable;
+
+static PriceTable g_prices;
 
 static volatile sig_atomic_t g_evacuation = 0;
 static volatile sig_atomic_t g_inventory  = 0;
@@ -124,6 +142,40 @@ static void *monitor_thread(void *arg)
  *  OBSLUGA KLIENTA PRZY KASIE
  * ================================================================ */
 
+/*
+ * price_table_load - Kopia cen katalogu (grosze) do g_prices.
+ */
+static void price_table_load(const SharedData *shm)
+{
+    int n = shm->num_products;
+    int32_t *gr = aligned_alloc(64, SHM_ALIGN(n * sizeof(int32_t)));
+    if (gr == NULL)
+        handle_error("aligned_alloc (cennik)");
+
+    const ProductDef *products = shm_products(shm);
+    for (int i = 0; i < n; i++)
+        gr[i] = products[i].price_gr;
+
+    free(g_prices.price_gr);
+    g_prices.price_gr = gr;
+    g_prices.n        = n;
+}
+
+/*
+ * basket_total_gr - Iloczyn skalarny ilosci i cen koszyka w groszach.
+ * Linie w osobnych tablicach, dopelnione do MAX_BASKET_LINES iloscia 0 -
+ * petla o stalej dlugosci bez rozgalezien, dokladna (int64).
+ */
+static int64_t basket_total_gr(const PriceTable *t,
+                               const uint16_t id[MAX_BASKET_LINES],
+                               const uint16_t qty[MAX_BASKET_LINES])
+{
+    int64_t sum = 0;
+    for (int k = 0; k < MAX_BASKET_LINES; k++)
+        sum += (int64_t)qty[k] * t->price_gr[id[k]];
+    return sum;
+}
+
 /**
  * Przetwarza zakupy klienta.
  * Oblicza laczna kwote, aktualizuje statystyki i wysyla paragon.
@@ -132,68 +184,80 @@ static void *monitor_thread(void *arg)
  */
 static void process_checkout(struct checkout_msg *cmsg)
 {
-    double total = 0.0;
     int total_items = 0;
+    uint64_t scan_from = hist_now_ns();
     struct receipt_msg rmsg;
-    rmsg.mtype = cmsg->customer_pid;
-    memset(rmsg.items, 0, sizeof(rmsg.items));
-
-    /* Skanowanie produktow - z symulowanym opoznieniem */
-    for (int i = 0; i < g_shm->num_products; i++) {
-        if (cmsg->items[i] > 0) {
-            /* Symulacja skanowania: szybkie skanowanie */
-            usleep(g_shm->time_scale_ms * 50); /* 0.05 min na szt */
-
-            rmsg.items[i] = cmsg->items[i];
-            double item_cost = cmsg->items[i] * g_shm->products[i].price;
-            total += item_cost;
-            total_items += cmsg->items[i];
-
-            /* Aktualizuj statystyki kasy (chronione semaforem) */
-            sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
-            g_shm->register_sales[g_register_id][i] += cmsg->items[i];
-            sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
-        }
+    rmsg.mtype     = cmsg->customer_pid;
+    rmsg.num_lines = 0;
+
+    int lines = cmsg->num_lines;
+    if (lines < 0 || lines > MAX_BASKET_LINES) lines = 0;
+
+    /* Skanowanie linii koszyka - z symulowanym opoznieniem. Poprawne
+     * linie trafiaja do tablic id/qty (reszta: produkt 0, ilosc 0) */
+    uint16_t id[MAX_BASKET_LINES]  = { 0 };
+    uint16_t qty[MAX_BASKET_LINES] = { 0 };
+    for (int k = 0; k < lines; k++) {
+        const BasketLine *ln = &cmsg->lines[k];
+        if (ln->product_id >= g_prices.n || ln->qty == 0) continue;
+
+        /* Symulacja skanowania: szybkie skanowanie */
+        usleep(g_shm->time_scale_ms * 50); /* 0.05 min na szt */
+
+        id[rmsg.num_lines]  = ln->product_id;
+        qty[rmsg.num_lines] = ln->qty;
+        rmsg.lines[rmsg.num_lines++] = *ln;
+        total_items += ln->qty;
     }
 
-    rmsg.total = total;
+    int64_t total_gr = basket_total_gr(&g_prices, id, qty);
+    rmsg.total_gr = total_gr;
+
+    /* Statystyki kasy i przychod - jedna sekcja krytyczna na koszyk */
+    shm_lock(g_sem_id, g_shm);
+    for (int k = 0; k < rmsg.num_lines; k++)
+        shm_stats(g_shm)[id[k]].register_sales[g_register_id] += qty[k];
+    g_shm->register_revenue_gr[g_register_id] += total_gr;
+    shm_unlock(g_sem_id, g_shm);
 
-    /* Aktualizuj przychod kasy */
-    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
-    g_shm->register_revenue[g_register_id] += total;
-    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+    /* Koniec skanowania - zapis przed wyslaniem, bo klient moze odebrac
+     * paragon zanim kasjer wroci z msgsnd() */
+    JOURNAL(EV_CASH_SCAN_END, cmsg->customer_pid, g_register_id,
+            total_items, (int)total_gr, 0);
+    rmsg.sent_ns = hist_now_ns();
+    hist_record_since(&g_hist_scan, scan_from, rmsg.sent_ns);
 
     /* Wyslij paragon klientowi (IPC_NOWAIT z retry).
      * Kolejka moze byc chwilowo pelna - klienci wlasnie odbieraja.
      * Ponawiamy kilka razy z krotkim opoznieniem zanim zrezygnujemy. */
     int sent = 0;
     for (int attempt = 0; attempt < 10; attempt++) {
-        if (msgsnd(g_mq_receipt, &rmsg, sizeof(rmsg) - sizeof(long), IPC_NOWAIT) == 0) {
+        if (g_ipc->receipt_send(&rmsg) == 0) {
             sent = 1;
             break;
         }
-        if (errno == EAGAIN) {
+        if (errno == ENOMSG) {
             /* Kolejka pelna - poczekaj chwile i ponow */
             usleep(g_shm->time_scale_ms * 100);
             continue;
         }
-        if (errno == EIDRM || errno == EINVAL || errno == EINTR) {
+        if (errno == EIDRM || errno == EINTR) {
             log_msg("Paragon dla PID:%d nie wyslany (zamykanie symulacji)",
                     cmsg->customer_pid);
             break;
         }
         handle_warning("msgsnd (receipt)");
-        log_msg("Blad wysylania paragonu do klienta PID:%d",
+        log_error("Blad wysylania paragonu do klienta PID:%d",
                 cmsg->customer_pid);
         break;
     }
-    if (!sent && errno == EAGAIN) {
-        log_msg("Paragon dla PID:%d nie wyslany (kolejka pelna po 10 probach)",
+    if (!sent && errno == ENOMSG) {
+        log_warn("Paragon dla PID:%d nie wyslany (kolejka pelna po 10 probach)",
                 cmsg->customer_pid);
     }
 
-    log_msg("Obsluzono klienta PID:%d - %d produktow, %.2f PLN",
-            cmsg->customer_pid, total_items, total);
+    log_debug("Obsluzono klienta PID:%d - %d produktow, %.2f PLN",
+            cmsg->customer_pid, total_items, total_gr / 100.0);
 }
 
 /* ================================================================
@@ -214,19 +278,16 @@ int main(int argc, char *argv[])
     if (validate_int_range(g_register_id, 0, 1, "register_id") != 0)
         return EXIT_FAILURE;
 
-    srand(time(NULL) ^ getpid());
-
     /* --- Dolaczenie do zasobow IPC --- */
-    g_shm = attach_shared_memory(keyfile);
-
-    int num_sems = TOTAL_SEMS(g_shm->num_products);
-    g_sem_id = get_semaphores(keyfile, num_sems);
+    g_shm = attach_child_ipc(keyfile, &g_sem_id);
 
-    g_mq_checkout = get_message_queue(keyfile, PROJ_MQ_CHKOUT);
-    g_mq_receipt  = get_message_queue(keyfile, PROJ_MQ_RCPT);
+    g_ipc = ipc_backend_get(g_shm->ipc_backend);
+    g_ipc->attach(g_shm, keyfile, g_sem_id);
+    price_table_load(g_shm);
 
     /* --- Logger --- */
     logger_init(g_shm, PROC_CASHIER, g_register_id);
+    journal_attach(g_shm, JOURNAL_FILE, PROC_CASHIER);
 
     /* --- Sygnaly --- */
     setup_signals();
@@ -247,9 +308,9 @@ int main(int argc, char *argv[])
         /* Sprawdz czy symulacja wciaz trwa */
         if (!g_shm->simulation_running) {
             /* Symulacja konczy sie - obsluz pozostalych w kolejce */
-            sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+            shm_lock(g_sem_id, g_shm);
             int queue = g_shm->register_queue_len[g_register_id];
-            sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+            shm_unlock(g_sem_id, g_shm);
             if (queue == 0) break;
         }
 
@@ -274,28 +335,27 @@ int main(int argc, char *argv[])
         /* Kasa 0 jest zawsze aktywna; kasa 1 moze byc nieaktywna */
         if (!active && g_register_id == 1) {
             /* Sprawdz czy sa jeszcze klienci w kolejce do obslugi */
-            sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+            shm_lock(g_sem_id, g_shm);
             int queue = g_shm->register_queue_len[g_register_id];
-            sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+            shm_unlock(g_sem_id, g_shm);
 
             if (queue == 0) {
-                /* Brak klientow, kasa moze odpoczac */
-                usleep(g_shm->time_scale_ms * 2000);
+                /* Brak klientow, kasa moze odpoczac (2 tykniecia zegara) */
+                wait_until_tick(g_shm, sim_tick_now(g_shm) + 2);
                 continue;
             }
             /* Jesli sa klienci - obsluz ich przed zamknieciem */
         }
 
-        /* Proba odbioru komunikatu checkout (nieblokujaca z krotkim opoznieniem) */
+        /* Odbior komunikatu checkout z limitem 0.5 min symulacji
+         * (sysv: IPC_NOWAIT + usleep, posix: mq_timedreceive) */
         struct checkout_msg cmsg;
-        ssize_t ret = msgrcv_guarded(g_mq_checkout, &cmsg,
-                             sizeof(cmsg) - sizeof(long),
-                             g_register_id + 1, IPC_NOWAIT,
-                             g_sem_id, SEM_GUARD_CHKOUT(g_shm->num_products));
+        int ret = g_ipc->checkout_recv(g_register_id, &cmsg,
+                                       g_shm->time_scale_ms * 500);
 
         if (ret == -1) {
-            if (errno == ENOMSG || errno == EINTR) {
-                /* Brak komunikatu - czekaj chwile */
+            if (errno == ENOMSG) continue;  /* Limit minal bez klienta */
+            if (errno == EINTR) {
                 usleep(g_shm->time_scale_ms * 500);
                 continue;
             }
@@ -309,41 +369,50 @@ int main(int argc, char *argv[])
         }
 
         /* Mamy klienta do obslugi! */
-        log_msg("Rozpoczynam obsluge klienta PID:%d", cmsg.customer_pid);
+        log_debug("Rozpoczynam obsluge klienta PID:%d", cmsg.customer_pid);
+        JOURNAL(EV_CASH_SCAN_START, cmsg.customer_pid, g_register_id, 0, 0, 0);
+        hist_record_since(&g_hist_queue, cmsg.sent_ns, hist_now_ns());
         process_checkout(&cmsg);
 
         /* Zmniejsz kolejke */
-        sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_lock(g_sem_id, g_shm);
         if (g_shm->register_queue_len[g_register_id] > 0)
             g_shm->register_queue_len[g_register_id]--;
-        sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_unlock(g_sem_id, g_shm);
     }
 
     /* --- Podsumowanie sprzedazy --- */
     log_msg("=== PODSUMOWANIE KASY NR %d ===", g_register_id + 1);
     int total_sold = 0;
     for (int i = 0; i < g_shm->num_products; i++) {
-        if (g_shm->register_sales[g_register_id][i] > 0) {
+        if (shm_stats(g_shm)[i].register_sales[g_register_id] > 0) {
             log_msg("  %s: %d szt.",
-                    g_shm->products[i].name,
-                    g_shm->register_sales[g_register_id][i]);
-            total_sold += g_shm->register_sales[g_register_id][i];
+                    shm_products(g_shm)[i].name,
+                    shm_stats(g_shm)[i].register_sales[g_register_id]);
+            total_sold += shm_stats(g_shm)[i].register_sales[g_register_id];
         }
     }
     log_msg("  RAZEM: %d szt., PRZYCHOD: %.2f PLN",
-            total_sold, g_shm->register_revenue[g_register_id]);
+            total_sold, g_shm->register_revenue_gr[g_register_id] / 100.0);
 
     /* Zapisz podsumowanie na stderr (do pliku logu) */
     fprintf(stderr, "=== PODSUMOWANIE KASY %d ===\n", g_register_id + 1);
     fprintf(stderr, "Razem: %d szt., Przychod: %.2f PLN\n",
-            total_sold, g_shm->register_revenue[g_register_id]);
+            total_sold, g_shm->register_revenue_gr[g_register_id] / 100.0);
+
+    log_msg("Kasjer %d zakonczyl prace. PID: %d",
+            g_register_id + 1, getpid());
+
+    /* --- Scalenie histogramow do SHM (atomowo) --- */
+    hist_merge(&g_shm->hist[HIST_CHECKOUT_QUEUE], &g_hist_queue);
+    hist_merge(&g_shm->hist[HIST_SCAN], &g_hist_scan);
 
-    /* --- Sprzatanie --- */
+    /* --- Sprzatanie (logger i dziennik czytaja SHM - najpierw one) --- */
     pthread_mutex_destroy(&g_cash_mutex);
     pthread_cond_destroy(&g_cash_cond);
+    journal_close(0);
+    logger_init(NULL, PROC_CASHIER, g_register_id);
     detach_shared_memory(g_shm);
-
-    log_msg("Kasjer %d zakonczyl prace. PID: %d",
-            g_register_id + 1, getpid());
+    free(g_prices.price_gr);
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,243 @@
+/**
+ * kernel_limits.c - Kontrola limitow jadra przed startem symulacji
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Odczyt limitow IPC i zadan z /proc oraz plan pojemnosci kierownika
+ * (liczba procesow klientow naraz, N, liczba semaforow i kolejek).
+ */
+
+#include "kernel_limits.h"
+#include "ipc_utils.h"
+#include "ipc_channel.h"
+#include <sys/resource.h>
+#include <dirent.h>
+#include <ctype.h>
+
+/*
+ * count_sysvipc - Liczba obiektow w /proc/sysvipc/<plik> (wiersze bez
+ * naglowka); sum_col > 0 sumuje dodatkowo kolumne o tym numerze (od 1).
+ */
+static long count_sysvipc(const char *path, int sum_col, long *sum)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+
+    char line[512];
+    long rows = 0;
+    if (sum) *sum = 0;
+    if (fgets(line, sizeof(line), f) == NULL) { /* Naglowek */
+        fclose(f);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        rows++;
+        if (sum_col > 0 && sum) {
+            char *tok = strtok(line, " \t");
+            for (int c = 1; tok && c < sum_col; c++)
+                tok = strtok(NULL, " \t");
+            if (tok) *sum += atol(tok);
+        }
+    }
+    fclose(f);
+    return rows;
+}
+
+/*
+ * read_tasks_now - Liczba zadan (procesow i watkow) w systemie - pole
+ * "biezace/wszystkie" z /proc/loadavg.
+ */
+static long read_tasks_now(void)
+{
+    FILE *f = fopen("/proc/loadavg", "r");
+    if (!f) return -1;
+    long running, total;
+    int ok = fscanf(f, "%*s %*s %*s %ld/%ld", &running, &total) == 2;
+    fclose(f);
+    return ok ? total : -1;
+}
+
+/*
+ * read_user_tasks - Liczba zadan (watkow) procesow o rzeczywistym UID
+ * uid - to zuzycie liczy RLIMIT_NPROC. Pola Uid i Threads
+ * z /proc/<pid>/status; procesy znikajace w trakcie skanu sa pomijane.
+ */
+static long read_user_tasks(uid_t uid)
+{
+    DIR *d = opendir("/proc");
+    if (!d) return -1;
+
+    long total = 0;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        if (!isdigit((unsigned char)de->d_name[0])) continue;
+
+        char path[300], line[256];
+        snprintf(path, sizeof(path), "/proc/%s/status", de->d_name);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+
+        long ruid = -1, threads = 0;
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, "Uid:", 4) == 0)
+                ruid = strtol(line + 4, NULL, 10);
+            else if (strncmp(line, "Threads:", 8) == 0)
+                threads = strtol(line + 8, NULL, 10);
+        }
+        fclose(f);
+        if (ruid == (long)uid)
+            total += threads > 0 ? threads : 1;
+    }
+    closedir(d);
+    return total;
+}
+
+void kernel_limits_read(KernelLimits *kl)
+{
+    memset(kl, 0, sizeof(*kl));
+    kl->sem_msl = kl->sem_mns = kl->sem_opm = kl->sem_mni = -1;
+
+    FILE *f = fopen("/proc/sys/kernel/sem", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld %ld %ld", &kl->sem_msl, &kl->sem_mns,
+                   &kl->sem_opm, &kl->sem_mni) != 4)
+            kl->sem_msl = kl->sem_mns = kl->sem_opm = kl->sem_mni = -1;
+        fclose(f);
+    }
+    kl->msgmnb      = read_sysctl_long("/proc/sys/kernel/msgmnb");
+    kl->msgmax      = read_sysctl_long("/proc/sys/kernel/msgmax");
+    kl->msgmni      = read_sysctl_long("/proc/sys/kernel/msgmni");
+    kl->mq_queues_max = read_sysctl_long("/proc/sys/fs/mqueue/queues_max");
+    kl->threads_max = read_sysctl_long("/proc/sys/kernel/threads-max");
+    kl->pid_max     = read_sysctl_long("/proc/sys/kernel/pid_max");
+
+    struct rlimit rl;
+    kl->nproc = -1;
+    if (getrlimit(RLIMIT_NPROC, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+        kl->nproc = (long)rl.rlim_cur;
+
+    kl->tasks_now       = read_tasks_now();
+    kl->tasks_user      = (kl->nproc >= 0) ? read_user_tasks(getuid()) : -1;
+    kl->sem_sets_used   = count_sysvipc("/proc/sysvipc/sem", 4, &kl->sems_used);
+    kl->msg_queues_used = count_sysvipc("/proc/sysvipc/msg", 0, NULL);
+}
+
+/*
+ * queues_needed - Kolejki System V tworzone przez backend dla cfg
+ * (paragony zawsze w System V, podajniki i kasy tylko w sysv).
+ */
+static int queues_needed(const SharedData *cfg)
+{
+    int n = (cfg->queue_shards > 0) ? cfg->queue_shards : 1;
+    if (cfg->ipc_backend == IPC_BACKEND_SYSV) {
+        n += cfg->conveyor_queues ? cfg->num_products : 1;
+        n += (cfg->queue_shards > 0) ? NUM_REGISTERS : 1;
+    }
+    return n;
+}
+
+/* Wolne zadania wg jednego limitu (-1 = limit nieznany) */
+static void task_limit(CapacityPlan *plan, long limit, long used, const char *name)
+{
+    if (limit < 0 || used < 0) return;
+    long free_tasks = limit - used;
+    if (plan->task_headroom < 0 || free_tasks < plan->task_headroom) {
+        plan->task_headroom = free_tasks;
+        plan->task_used     = used;
+        plan->task_limit    = name;
+    }
+}
+
+int capacity_plan(const KernelLimits *kl, const SharedData *cfg,
+                  CapacityPlan *plan, FILE *err)
+{
+    int rc = 0;
+    memset(plan, 0, sizeof(*plan));
+    plan->num_sems      = TOTAL_SEMS(cfg->num_products);
+    plan->num_queues    = queues_needed(cfg);
+    plan->task_headroom = -1;
+    plan->task_limit    = "MAX_ACTIVE_CUST";
+
+    /* --- Semafory: jeden zbior TOTAL_SEMS(P) pozycji --- */
+    if (kl->sem_msl >= 0 && plan->num_sems > kl->sem_msl) {
+        fprintf(err, "%s[LIMITY]%s zbior semaforow: potrzeba %d, SEMMSL=%ld - "
+                "zmniejsz -p lub sysctl -w kernel.sem=\"%d %ld %ld %ld\"\n",
+                C_RED, C_RESET, plan->num_sems, kl->sem_msl, plan->num_sems,
+                kl->sem_mns, kl->sem_opm, kl->sem_mni);
+        rc = -1;
+    }
+    if (kl->sem_mni >= 0 && kl->sem_sets_used >= kl->sem_mni) {
+        fprintf(err, "%s[LIMITY]%s zbiory semaforow: zajete %ld z SEMMNI=%ld "
+                "(ipcs -s)\n", C_RED, C_RESET, kl->sem_sets_used, kl->sem_mni);
+        rc = -1;
+    }
+    if (kl->sem_mns >= 0 && kl->sems_used + plan->num_sems > kl->sem_mns) {
+        fprintf(err, "%s[LIMITY]%s semafory: zajete %ld + potrzeba %d > "
+                "SEMMNS=%ld (ipcs -s)\n", C_RED, C_RESET, kl->sems_used,
+                plan->num_sems, kl->sem_mns);
+        rc = -1;
+    }
+
+    /* --- Kolejki: liczba i najwiekszy komunikat --- */
+    if (kl->msgmni >= 0 && kl->msg_queues_used + plan->num_queues > kl->msgmni) {
+        fprintf(err, "%s[LIMITY]%s kolejki: zajete %ld + potrzeba %d > "
+                "kernel.msgmni=%ld (ipcs -q)\n", C_RED, C_RESET,
+                kl->msg_queues_used, plan->num_queues, kl->msgmni);
+        rc = -1;
+    }
+    /* POSIX: kolejka na podajnik i na kase (limit wspolny dla systemu,
+     * bez CAP_SYS_RESOURCE mq_open konczy sie ENOSPC) */
+    int px_queues = cfg->num_products + NUM_REGISTERS;
+    if (cfg->ipc_backend == IPC_BACKEND_POSIX && kl->mq_queues_max >= 0
+        && px_queues > kl->mq_queues_max) {
+        fprintf(err, "%s[LIMITY]%s kolejki POSIX: potrzeba %d > fs.mqueue.queues_max=%ld "
+                "- zmniejsz -p / katalog lub sysctl -w fs.mqueue.queues_max=%d\n",
+                C_RED, C_RESET, px_queues, kl->mq_queues_max, px_queues);
+        rc = -1;
+    }
+    long msg_size = (long)(sizeof(struct checkout_msg) > sizeof(struct receipt_msg)
+                           ? sizeof(struct checkout_msg) : sizeof(struct receipt_msg))
+                    - (long)sizeof(long);
+    if (kl->msgmax >= 0 && msg_size > kl->msgmax) {
+        fprintf(err, "%s[LIMITY]%s komunikat %ld B > kernel.msgmax=%ld - "
+                "sysctl -w kernel.msgmax=%ld\n", C_RED, C_RESET,
+                msg_size, kl->msgmax, msg_size);
+        rc = -1;
+    }
+
+    /* --- Procesy klientow naraz: najciasniejszy limit zadan ---
+     * Limity systemowe wobec wszystkich zadan, RLIMIT_NPROC wobec
+     * zadan uzytkownika (inni uzytkownicy nie zuzywaja jego limitu) */
+    task_limit(plan, kl->threads_max, kl->tasks_now,  "kernel.threads-max");
+    task_limit(plan, kl->pid_max,     kl->tasks_now,  "kernel.pid_max");
+    task_limit(plan, kl->nproc,       kl->tasks_user, "RLIMIT_NPROC");
+
+    long active = MAX_ACTIVE_CUST;
+    if (plan->task_headroom >= 0 && plan->task_headroom - LIMITS_TASK_RESERVE < active)
+        active = plan->task_headroom - LIMITS_TASK_RESERVE;
+    else
+        plan->task_limit = "MAX_ACTIVE_CUST";
+    plan->max_active    = (active > 0) ? (int)active : 0;
+    plan->max_customers = cfg->max_customers;
+
+    if (plan->max_active < 2) {
+        fprintf(err, "%s[LIMITY]%s wolnych zadan: %ld (%s, zajete %ld), "
+                "rezerwa %d - brak miejsca na klientow (ulimit -u / "
+                "sysctl kernel.threads-max)\n", C_RED, C_RESET,
+                plan->task_headroom, plan->task_limit, plan->task_used,
+                LIMITS_TASK_RESERVE);
+        return -1;
+    }
+    if (plan->max_active < MAX_ACTIVE_CUST)
+        fprintf(err, "%s[LIMITY]%s %s: wolnych zadan %ld (zajete %ld, "
+                "rezerwa %d) - klienci naraz: %d zamiast %d\n",
+                C_YELLOW, C_RESET, plan->task_limit, plan->task_headroom,
+                plan->task_used, LIMITS_TASK_RESERVE, plan->max_active,
+                MAX_ACTIVE_CUST);
+    if (plan->max_customers > plan->max_active) {
+        fprintf(err, "%s[LIMITY]%s N=%d > klientow naraz %d - N przyciete do %d\n",
+                C_YELLOW, C_RESET, plan->max_customers, plan->max_active,
+                plan->max_active);
+        plan->max_customers = plan->max_active;
+    }
+    return rc;
+}
@@ -0,0 +1,69 @@
+/**
+ * kernel_limits.h - Kontrola limitow jadra przed startem symulacji
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Kierownik przed utworzeniem semaforow i kolejek czyta limity IPC
+ * (/proc/sys/kernel/{sem,msgmnb,msgmax,msgmni}, fs.mqueue.queues_max
+ * dla backendu posix - kolejka na kazdy produkt katalogu), limity zadan
+ * (threads-max, pid_max, RLIMIT_NPROC) i biezace zuzycie
+ * (/proc/sysvipc, /proc/loadavg, zadania uzytkownika z /proc/<pid>/status
+ * dla RLIMIT_NPROC). Z nich wylicza plan pojemnosci:
+ * ile procesow klientow moze istniec naraz i czy N miesci sie w tym
+ * limicie. Przekroczenia, ktorych nie da sie obejsc (za malo semaforow
+ * w zbiorze, za maly msgmax), koncza start z opisem sysctl zamiast
+ * bledu semget/msgsnd w trakcie symulacji.
+ */
+
+#ifndef KERNEL_LIMITS_H
+#define KERNEL_LIMITS_H
+
+#include "common.h"
+#include <stdio.h>
+
+/** Zadania zarezerwowane poza klientami (kierownik, watki piekarza,
+ *  kasjerzy z monitorem, narzedzia diagnostyczne, powloka). */
+#define LIMITS_TASK_RESERVE (1 + (1 + MAX_BAKER_THREADS) + 2 * NUM_REGISTERS + 64)
+
+/**
+ * Limity jadra i biezace zuzycie (-1 = nieznane / bez limitu).
+ */
+typedef struct {
+    long sem_msl, sem_mns, sem_opm, sem_mni; /* kernel.sem */
+    long msgmnb, msgmax, msgmni;
+    long mq_queues_max;                      /* fs.mqueue.queues_max (-I posix) */
+    long threads_max, pid_max;
+    long nproc;                              /* RLIMIT_NPROC (miekki) */
+    long tasks_now;                          /* Zadania w systemie (loadavg) */
+    long tasks_user;                         /* Zadania uzytkownika (RLIMIT_NPROC) */
+    long sem_sets_used, sems_used;           /* /proc/sysvipc/sem */
+    long msg_queues_used;                    /* /proc/sysvipc/msg */
+} KernelLimits;
+
+/**
+ * Plan pojemnosci wyliczony z limitow i konfiguracji.
+ */
+typedef struct {
+    int  max_active;      /* Procesy klientow naraz (<= MAX_ACTIVE_CUST) */
+    int  max_customers;   /* N po dopasowaniu do max_active */
+    int  num_sems;        /* TOTAL_SEMS(P) */
+    int  num_queues;      /* Kolejki System V tworzone przez backend */
+    long task_headroom;   /* Wolne zadania przed rezerwa */
+    long task_used;       /* Zajete zadania wg tego limitu */
+    const char *task_limit; /* Nazwa limitu, ktory wyznaczyl max_active */
+} CapacityPlan;
+
+/**
+ * Odczytuje limity i zuzycie z /proc i getrlimit().
+ */
+void kernel_limits_read(KernelLimits *kl);
+
+/**
+ * Wylicza plan dla konfiguracji cfg (num_products, max_customers,
+ * ipc_backend, conveyor_queues, queue_shards). Ostrzezenia o przycieciu
+ * i bledy trafiaja do err.
+ * @return 0 - mozna startowac, -1 - limit nie do obejscia
+ */
+int capacity_plan(const KernelLimits *kl, const SharedData *cfg,
+                  CapacityPlan *plan, FILE *err);
+
+#endif /* KERNEL_LIMITS_H */
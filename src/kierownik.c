@@ -5,7 +5,8 @@
  * Glowny proces symulacji. Odpowiada za:
  * - Tworzenie i inicjalizacje zasobow IPC
  * - Uruchamianie procesow piekarza, kasjerow i klientow (fork + exec)
- * - Zarzadzanie zegarem symulacji
+ * - Zarzadzanie zegarem symulacji (petla epoll: signalfd, timerfd,
+ *   FIFO polecen, pipe piekarza)
  * - Monitorowanie stanu sklepu (otwieranie/zamykanie kas)
  * - Obsluge sygnalow (inwentaryzacja, ewakuacja)
  * - Generowanie raportu koncowego
@@ -13,12 +14,25 @@
  *
  * Uzycie: ./kierownik [-n max_klientow] [-p produkty] [-s skala_czasu_ms]
  *                      [-o godzina_otwarcia] [-c godzina_zamkniecia]
+ *                      [-L poziomy_logowania] [-j rekordy_dziennika]
+ *                      [-K catchup|skip]
  */
 
 #include "common.h"
 #include "error_handler.h"
 #include "ipc_utils.h"
+#include "ipc_channel.h"
 #include "logger.h"
+#include "journal.h"
+#include "histogram.h"
+#include "seqlock.h"
+#include "des.h"
+#include "kernel_limits.h"
+#include "catalog.h"
+#include "rng.h"
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 
 /* ================================================================
  *  ZMIENNE GLOBALNE PROCESU
@@ -26,15 +40,33 @@
 
 static SharedData *g_shm         = NULL;   /* Wskaznik do pamieci dzielonej */
 static int         g_sem_id      = -1;     /* ID zbioru semaforow */
+static const IpcBackend *g_ipc   = NULL;   /* Backend kanalow (-I) */
 static int         g_baker_pipe[2] = {-1, -1}; /* Pipe: piekarz -> kierownik */
 static pid_t      *g_customer_pids = NULL;  /* Dynamiczna tablica PIDow klientow */
 static int         g_num_customers = 0;    /* Liczba slotow w tablicy */
 static int         g_customer_cap  = 0;    /* Pojemnosc tablicy */
-static volatile sig_atomic_t g_sigchld_received = 0;
-static volatile sig_atomic_t g_sigint_received  = 0;
-static volatile sig_atomic_t g_sigcont_received = 0;
+static int         g_sigint_received = 0;  /* SIGINT/SIGTERM z signalfd */
 static int         g_max_time     = 0;     /* Maks. czas symulacji w sekundach (0 = bez limitu) */
 static int         g_cleanup_done = 0;     /* Flaga zapobiegajaca podwojnemu czyszczeniu */
+static long        g_journal_cap  = 0;     /* Pojemnosc dziennika zdarzen (0 = wylaczony) */
+static int         g_virtual_runs = 0;     /* Przebiegi w czasie wirtualnym (-V, 0 = tryb rzeczywisty) */
+static int         g_fork_us      = 0;     /* Koszt fork+exec klienta w trybie -V (us) */
+static int         g_tick_skip    = 0;     /* -K skip: zalegle tykniecia pomijane zamiast nadrabiane */
+static struct timespec g_wall_start;       /* Start petli glownej (-t timeout) */
+static int         g_timer_fd     = -1;    /* timerfd tykniec zegara */
+static int         g_register_pct = 25;    /* Prog otwarcia kasy 2 (% N, "set kasa") */
+static int         g_arrivals     = 0;     /* Klientow na tykniecie (0 = wszyscy naraz) */
+static int         g_entry_debt   = 0;     /* Miejsca SEM_SHOP_ENTRY do odebrania po zmniejszeniu N */
+static int         g_arrivals_closed = 0;  /* Po Tk / -t: bez nowych klientow (przy "set przybycia") */
+static KernelLimits g_limits;              /* Limity jadra odczytane przy starcie */
+static CapacityPlan g_plan;                /* Plan pojemnosci (klienci naraz, N) */
+static const char  *g_catalog_path = NULL; /* Plik katalogu produktow (-f, NULL = domyslny) */
+static int         g_products_set = 0;     /* -p podane jawnie (z -f: pierwsze P pozycji) */
+static int         g_seed_set     = 0;     /* -S podane (inaczej ziarno z zegara i PID) */
+
+/* Zrodla zdarzen petli epoll (epoll_event.data.u32) */
+enum { SRC_SIGNAL = 0, SRC_TICK, SRC_FIFO, SRC_BAKER_PIPE };
+#define EPOLL_MAX_EVENTS 8
 
 /**
  * EINTR-resistant sleep (milisekundy).
@@ -55,6 +87,8 @@ static void atexit_cleanup(void)
     if (g_cleanup_done) return;
     g_cleanup_done = 1;
     if (g_shm != NULL) {
+        journal_close(1);
+        logger_init(NULL, PROC_MANAGER, 0);
         detach_shared_memory(g_shm);
         g_shm = NULL;
     }
@@ -70,75 +104,81 @@ static void atexit_cleanup(void)
  * ================================================================ */
 
 /**
- * Handler SIGCHLD - natychmiastowe zbieranie zombie.
- * Wywoluje waitpid() bezposrednio w handlerze (async-signal-safe)
- * aby zapobiec akumulacji zombie podczas SIGTSTP (Ctrl+Z).
+ * Sygnaly kierownika odbierane przez signalfd w petli epoll zamiast
+ * handlerow: SIGCHLD (zbieranie potomkow), SIGINT/SIGTERM (zamkniecie),
+ * SIGCONT (wznowienie po Ctrl+Z). Sa zablokowane w masce procesu -
+ * potomkowie przywracaja maske z g_saved_sigmask przed exec.
  */
-static void sigchld_handler(int sig)
-{
-    (void)sig;
-    int saved_errno = errno;
-    /* Natychmiast zbieraj zombie - zapobiega ich akumulacji podczas SIGTSTP */
-    while (waitpid(-1, NULL, WNOHANG) > 0)
-        ;
-    g_sigchld_received = 1;
-    errno = saved_errno;
-}
+static sigset_t g_saved_sigmask;
+static int      g_signal_fd = -1;   /* signalfd (SIGCHLD/SIGINT/SIGTERM/SIGCONT) */
 
 /**
- * Handler SIGINT/SIGTERM - czyste zamkniecie symulacji.
+ * Blokuje sygnaly kierownika i tworzy dla nich signalfd.
+ * @return Deskryptor signalfd (nieblokujacy, CLOEXEC)
  */
-static void sigint_handler(int sig)
+static int setup_signalfd(void)
 {
-    (void)sig;
-    g_sigint_received = 1;
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGCONT);
+
+    if (sigprocmask(SIG_BLOCK, &mask, &g_saved_sigmask) == -1)
+        handle_error("sigprocmask (signalfd)");
+
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd == -1)
+        handle_error("signalfd");
+    return sfd;
 }
 
-/**
- * Handler SIGCONT - po wznowieniu procesu (po Ctrl+Z + fg).
- * Natychmiast zbiera zombie ktore mogly sie nagromadzic podczas zatrzymania.
- */
-static void sigcont_handler(int sig)
+/* restore_child_sigmask - w potomku przed exec: maska sprzed signalfd */
+static void restore_child_sigmask(void)
 {
-    (void)sig;
-    int saved_errno = errno;
-    /* Po wznowieniu z SIGTSTP - zbierz wszystkie zombie */
-    while (waitpid(-1, NULL, WNOHANG) > 0)
-        ;
-    g_sigcont_received = 1;
-    g_sigchld_received = 1;
-    errno = saved_errno;
+    sigprocmask(SIG_SETMASK, &g_saved_sigmask, NULL);
 }
 
+static void reap_children(void);
+
 /**
- * Konfiguracja handlerow sygnalow za pomoca sigaction().
+ * Odczytuje oczekujace sygnaly z signalfd (do EAGAIN).
+ * Wiele SIGCHLD laczy sie w jeden - reap_children() zbiera wszystkich.
  */
-static void setup_signal_handlers(void)
+static void handle_signals(int signal_fd)
+{
+    struct signalfd_siginfo si;
+    int reap = 0;
+
+    while (read(signal_fd, &si, sizeof(si)) == (ssize_t)sizeof(si)) {
+        switch (si.ssi_signo) {
+            case SIGCHLD:
+                reap = 1;
+                break;
+            case SIGINT:
+            case SIGTERM:
+                g_sigint_received = 1;
+                break;
+            case SIGCONT:
+                log_msg("Wznowiono po zatrzymaniu (SIGCONT) - czyszczenie zombie...");
+                reap = 1;
+                break;
+        }
+    }
+    if (reap)
+        reap_children();
+}
+
+/* epoll_add - rejestruje deskryptor (EPOLLIN) ze znacznikiem zrodla */
+static void epoll_add(int epoll_fd, int fd, uint32_t source)
 {
-    struct sigaction sa;
-
-    /* SIGCHLD - zbieranie zombie */
-    memset(&sa, 0, sizeof(sa));
-    sa.sa_handler = sigchld_handler;
-    sa.sa_flags   = SA_RESTART | SA_NOCLDSTOP;
-    sigemptyset(&sa.sa_mask);
-    if (sigaction(SIGCHLD, &sa, NULL) == -1)
-        handle_error("sigaction (SIGCHLD)");
-
-    /* SIGINT/SIGTERM - zamkniecie */
-    sa.sa_handler = sigint_handler;
-    sa.sa_flags   = 0;
-    if (sigaction(SIGINT, &sa, NULL) == -1)
-        handle_error("sigaction (SIGINT)");
-    if (sigaction(SIGTERM, &sa, NULL) == -1)
-        handle_error("sigaction (SIGTERM)");
-
-    /* SIGCONT - czyszczenie zombie po wznowieniu z Ctrl+Z */
-    sa.sa_handler = sigcont_handler;
-    sa.sa_flags   = SA_RESTART;
-    sigemptyset(&sa.sa_mask);
-    if (sigaction(SIGCONT, &sa, NULL) == -1)
-        handle_error("sigaction (SIGCONT)");
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = EPOLLIN;
+    ev.data.u32 = source;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+        handle_error("epoll_ctl (ADD)");
 }
 
 /* ================================================================
@@ -146,79 +186,62 @@ static void setup_signal_handlers(void)
  * ================================================================ */
 
 /**
- * Zbiera zakonczane procesy potomne i aktualizuje tablice PID.
- *
- * Uzywa kill(pid, 0) do skanowania tablicy PID zamiast polegac
- * wylacznie na waitpid() - handler SIGCHLD juz zbiera zombie inline,
- * wiec waitpid w petli glownej moze nie znalezc potomkow.
- * kill(pid, 0) + ESRCH niezawodnie wykrywa martwe procesy.
+ * Zbiera zakonczone procesy potomne i aktualizuje tablice PID.
  *
- * SIGCHLD jest blokowany podczas aktualizacji tablic aby uniknac
- * interferencji z handlerem sygnalu.
+ * SIGCHLD nie ma handlera (odbiera go signalfd), wiec waitpid(-1)
+ * widzi kazde zakonczenie - zwrocony PID jest oznaczany wprost w
+ * tablicy, bez skanowania wszystkich klientow przez kill(pid, 0).
  */
 static void reap_children(void)
 {
-    /* Zablokuj SIGCHLD podczas aktualizacji tablic PID */
-    sigset_t block_chld, oldset;
-    sigemptyset(&block_chld);
-    sigaddset(&block_chld, SIGCHLD);
-    sigprocmask(SIG_BLOCK, &block_chld, &oldset);
+    int reaped_count = 0;
+    pid_t pid;
 
-    /* Zbierz ewentualne zombie (safety net - handler tez zbiera) */
-    while (waitpid(-1, NULL, WNOHANG) > 0)
-        ;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        if (g_shm == NULL) continue;
 
-    if (g_shm == NULL) {
-        sigprocmask(SIG_SETMASK, &oldset, NULL);
-        return;
-    }
-
-    /* Sprawdz piekarza - czy proces jeszcze zyje */
-    if (g_shm->baker_pid > 0) {
-        if (kill(g_shm->baker_pid, 0) == -1 && errno == ESRCH) {
+        /* Piekarz */
+        if (pid == g_shm->baker_pid) {
             if (g_shm->simulation_running)
                 log_msg_color(C_RED, "UWAGA: Piekarz (PID:%d) zakonczyl prace nieoczekiwanie!",
-                              g_shm->baker_pid);
+                              pid);
             g_shm->baker_pid = 0;
+            continue;
         }
-    }
 
-    /* Sprawdz kasjerow */
-    for (int c = 0; c < 2; c++) {
-        if (g_shm->cashier_pids[c] > 0) {
-            if (kill(g_shm->cashier_pids[c], 0) == -1 && errno == ESRCH) {
+        /* Kasjerzy */
+        int found = 0;
+        for (int c = 0; c < 2; c++) {
+            if (pid == g_shm->cashier_pids[c]) {
                 if (g_shm->simulation_running)
                     log_msg_color(C_RED, "UWAGA: Kasjer %d (PID:%d) zakonczyl prace nieoczekiwanie!",
-                                  c + 1, g_shm->cashier_pids[c]);
+                                  c + 1, pid);
                 g_shm->cashier_pids[c] = 0;
                 g_shm->register_open[c] = 0;
                 g_shm->register_accepting[c] = 0;
+                found = 1;
             }
         }
-    }
+        if (found) continue;
 
-    /* Sprawdz klientow - skanuj tablice PID i usun martwe procesy */
-    int reaped_count = 0;
-    for (int i = 0; i < g_num_customers; i++) {
-        if (g_customer_pids[i] > 0) {
-            if (kill(g_customer_pids[i], 0) == -1 && errno == ESRCH) {
+        /* Klienci */
+        for (int i = 0; i < g_num_customers; i++) {
+            if (g_customer_pids[i] == pid) {
                 g_customer_pids[i] = 0;
                 reaped_count++;
+                break;
             }
         }
     }
 
     /* Zaktualizuj licznik aktywnych klientow hurtowo */
     if (reaped_count > 0) {
-        sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_lock(g_sem_id, g_shm);
         g_shm->active_customers -= reaped_count;
         if (g_shm->active_customers < 0)
             g_shm->active_customers = 0;
-        sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_unlock(g_sem_id, g_shm);
     }
-
-    /* Przywroc maske sygnalow */
-    sigprocmask(SIG_SETMASK, &oldset, NULL);
 }
 
 /* ================================================================
@@ -234,13 +257,74 @@ static void print_usage(const char *prog)
         "Uzycie: %s [opcje]\n"
         "Opcje:\n"
         "  -n N     Maks. klientow w sklepie (domyslnie: 10)\n"
-        "  -p P     Liczba produktow (domyslnie: 12, min: 11)\n"
+        "  -p P     Liczba produktow (domyslnie: 1, maks. %d; z -f:\n"
+        "           pierwsze P pozycji katalogu)\n"
+        "  -f PLIK  Katalog produktow: nazwa;cena;pojemnosc[;waga[;partia]]\n"
+        "           na linie (waga = popularnosc, partia = szt. w partii)\n"
         "  -s MS    Skala czasu: ms na minute symulacji (domyslnie: 100)\n"
         "  -o HH    Godzina otwarcia ciastkarni (domyslnie: 8)\n"
         "  -c HH    Godzina zamkniecia (domyslnie: 16)\n"
         "  -t SEC   Maks. czas symulacji w sekundach (0 = bez limitu)\n"
+        "  -L SPEC  Poziomy logowania: 'poziom' lub 'typ=poziom,...'\n"
+        "           poziomy: error|warn|info|debug|trace (domyslnie: info)\n"
+        "           typy: kierownik|piekarz|kasjer|klient\n"
+        "  -j REK   Dziennik zdarzen %s na REK rekordow (0 = wylaczony)\n"
+        "  -V RUNS  Czas wirtualny: RUNS przebiegow symulacji zdarzeniowej\n"
+        "           bez procesow i usleep (0 = tryb rzeczywisty)\n"
+        "  -F US    Koszt fork+exec klienta w trybie -V (domyslnie: 0)\n"
+        "  -K TRYB  Spoznione tykniecia zegara: catchup (nadrabiaj bez snu,\n"
+        "           domyslnie) lub skip (pomin - zegar przeskakuje)\n"
+        "  -I IPC   Backend kanalow: sysv (msgget + semafory, domyslnie)\n"
+        "           lub posix (mq_open na podajnik/kase + sem_open)\n"
+        "  -Q       sysv: osobna kolejka i straznik na kazdy podajnik\n"
+        "           (maks. %d produktow; domyslnie jedna kolejka, mtype = produkt)\n"
+        "  -r R     Kolejka na kase (sysv) i R kolejek paragonow (shard =\n"
+        "           PID %% R); 0 = wspolne kolejki (domyslnie: 0, maks. %d)\n"
+        "  -m OPCJE Segment SHM: huge (SHM_HUGETLB), prefault (strony\n"
+        "           wypelnione przy dolaczeniu), lock (SHM_LOCK), np. huge,lock\n"
+        "  -S SEED  Ziarno obciazenia: listy zakupow, partie i opoznienia\n"
+        "           piekarza, przebiegi -V (domyslnie: z zegara, w raporcie)\n"
         "  -h       Wyswietl pomoc\n",
-        prog);
+        prog, MAX_PRODUCTS, JOURNAL_FILE, MAX_CONV_QUEUES, MAX_RECEIPT_SHARDS);
+}
+
+/**
+ * Parsuje liste opcji segmentu SHM ("huge,prefault,lock").
+ * @return Maska SHM_OPT_* lub -1 przy nieznanej nazwie
+ */
+static int parse_shm_opts(const char *spec)
+{
+    static const struct { const char *name; int flag; } NAMES[] = {
+        { "huge", SHM_OPT_HUGE }, { "prefault", SHM_OPT_PREFAULT },
+        { "lock", SHM_OPT_LOCK },
+    };
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    int opts = 0;
+    for (char *save = NULL, *tok = strtok_r(buf, ",", &save); tok;
+         tok = strtok_r(NULL, ",", &save)) {
+        size_t i = 0;
+        while (i < sizeof(NAMES) / sizeof(NAMES[0]) && strcmp(tok, NAMES[i].name) != 0)
+            i++;
+        if (i == sizeof(NAMES) / sizeof(NAMES[0]))
+            return -1;
+        opts |= NAMES[i].flag;
+    }
+    return opts;
+}
+
+/**
+ * Opis opcji segmentu SHM do banera i raportu (bufor statyczny).
+ */
+static const char *shm_opts_str(int opts)
+{
+    static char buf[64];
+    snprintf(buf, sizeof(buf), "%s%s%s",
+             (opts & SHM_OPT_HUGE) ? "duze strony" : "zwykle strony",
+             (opts & SHM_OPT_PREFAULT) ? ", prefault" : "",
+             (opts & SHM_OPT_LOCK) ? ", SHM_LOCK" : "");
+    return buf;
 }
 
 /**
@@ -257,15 +341,21 @@ static int parse_args(int argc, char *argv[], SharedData *shm)
     shm->open_min       = 0;
     shm->close_hour     = 23;
     shm->close_min      = 0;
+    for (int t = 0; t < NUM_PROC_TYPES; t++)
+        shm->log_level[t] = LOG_LVL_INFO;
 
     int opt;
-    while ((opt = getopt(argc, argv, "n:p:s:o:c:t:h")) != -1) {
+    while ((opt = getopt(argc, argv, "n:p:f:s:o:c:t:L:j:V:F:K:I:Qr:m:S:h")) != -1) {
         switch (opt) {
             case 'n':
                 shm->max_customers = atoi(optarg);
                 break;
             case 'p':
                 shm->num_products = atoi(optarg);
+                g_products_set = 1;
+                break;
+            case 'f':
+                g_catalog_path = optarg;
                 break;
             case 's':
                 shm->time_scale_ms = atoi(optarg);
@@ -279,6 +369,68 @@ static int parse_args(int argc, char *argv[], SharedData *shm)
             case 't':
                 g_max_time = atoi(optarg);
                 break;
+            case 'j':
+                g_journal_cap = atol(optarg);
+                break;
+            case 'V':
+                g_virtual_runs = atoi(optarg);
+                break;
+            case 'F':
+                g_fork_us = atoi(optarg);
+                break;
+            case 'K':
+                if (strcmp(optarg, "catchup") == 0) {
+                    g_tick_skip = 0;
+                } else if (strcmp(optarg, "skip") == 0) {
+                    g_tick_skip = 1;
+                } else {
+                    fprintf(stderr, "%s[WALIDACJA]%s Tryb przekroczen (-K) musi byc "
+                            "'catchup' lub 'skip': '%s'.\n", C_RED, C_RESET, optarg);
+                    return -1;
+                }
+                break;
+            case 'I':
+                shm->ipc_backend = ipc_backend_parse(optarg);
+                if (shm->ipc_backend < 0) {
+                    fprintf(stderr, "%s[WALIDACJA]%s Backend IPC (-I) musi byc "
+                            "'sysv' lub 'posix': '%s'.\n", C_RED, C_RESET, optarg);
+                    return -1;
+                }
+                break;
+            case 'Q':
+                shm->conveyor_queues = 1;
+                break;
+            case 'r':
+                shm->queue_shards = atoi(optarg);
+                break;
+            case 'm':
+                shm->shm_opts = parse_shm_opts(optarg);
+                if (shm->shm_opts < 0) {
+                    fprintf(stderr, "%s[WALIDACJA]%s Opcje pamieci dzielonej (-m): "
+                            "lista z huge, prefault, lock: '%s'.\n",
+                            C_RED, C_RESET, optarg);
+                    return -1;
+                }
+                break;
+            case 'S': {
+                char *end;
+                errno = 0;
+                shm->seed = strtoull(optarg, &end, 10);
+                if (errno != 0 || end == optarg || *end != '\0' || optarg[0] == '-') {
+                    fprintf(stderr, "%s[WALIDACJA]%s Ziarno (-S): liczba 0..2^64-1, "
+                            "podano '%s'.\n", C_RED, C_RESET, optarg);
+                    return -1;
+                }
+                g_seed_set = 1;
+                break;
+            }
+            case 'L':
+                if (log_apply_spec(shm, optarg) != 0) {
+                    fprintf(stderr, "%s[WALIDACJA]%s Niepoprawne poziomy logowania "
+                            "(-L): '%s'.\n", C_RED, C_RESET, optarg);
+                    return -1;
+                }
+                break;
             case 'h':
                 print_usage(argv[0]);
                 exit(EXIT_SUCCESS);
@@ -288,6 +440,13 @@ static int parse_args(int argc, char *argv[], SharedData *shm)
         }
     }
 
+    /* Bez -S ziarno z zegara i PID - drukowane w raporcie, wiec przebieg
+     * mozna powtorzyc z -S */
+    if (!g_seed_set) {
+        uint64_t x = ((uint64_t)time(NULL) << 32) ^ (uint64_t)getpid();
+        shm->seed = rng_splitmix64(&x);
+    }
+
     /* Walidacja parametrow */
     if (validate_int_range(shm->max_customers, 2, MAX_ACTIVE_CUST,
             "max_klientow (-n)") != 0) return -1;
@@ -299,6 +458,8 @@ static int parse_args(int argc, char *argv[], SharedData *shm)
             "godzina_otwarcia (-o)") != 0) return -1;
     if (validate_int_range(shm->close_hour, 1, 24,
             "godzina_zamkniecia (-c)") != 0) return -1;
+    if (validate_int_range(shm->queue_shards, 0, MAX_RECEIPT_SHARDS,
+            "kolejki_paragonow (-r)") != 0) return -1;
 
     if (shm->close_hour <= shm->open_hour) {
         fprintf(stderr, "%s[WALIDACJA]%s Godzina zamkniecia (%d) musi byc "
@@ -307,6 +468,17 @@ static int parse_args(int argc, char *argv[], SharedData *shm)
         return -1;
     }
 
+    if (g_journal_cap < 0) {
+        fprintf(stderr, "%s[WALIDACJA]%s Pojemnosc dziennika (-j) musi byc >= 0.\n",
+                C_RED, C_RESET);
+        return -1;
+    }
+
+    if (validate_int_range(g_virtual_runs, 0, 1000000,
+            "przebiegi_wirtualne (-V)") != 0) return -1;
+    if (validate_int_range(g_fork_us, 0, 1000000,
+            "koszt_fork_us (-F)") != 0) return -1;
+
     if (g_max_time < 0) {
         fprintf(stderr, "%s[WALIDACJA]%s Czas symulacji (-t) musi byc >= 0.\n",
                 C_RED, C_RESET);
@@ -345,26 +517,63 @@ static void create_log_directory(void)
 }
 
 /**
- * Inicjalizuje pamiec dzielona domyslnymi produktami.
+ * Konfiguracja o ukladzie segmentu: naglowek z parse_args i katalog
+ * z pliku -f (przy -p - pierwsze P pozycji) albo domyslny P pozycji.
+ * @return Bufor shm_layout_size(P) (free) lub NULL przy bledzie
  */
-static void init_shared_data(SharedData *shm)
+static SharedData *build_config(const SharedData *args)
 {
-    /* Skopiuj definicje produktow */
-    int p = shm->num_products;
-    if (p > DEFAULT_NUM_PRODUCTS) p = DEFAULT_NUM_PRODUCTS;
+    ProductDef *catalog = calloc(MAX_PRODUCTS, sizeof(ProductDef));
+    if (catalog == NULL)
+        handle_error("calloc (katalog)");
+
+    int n = args->num_products;
+    if (g_catalog_path != NULL) {
+        n = catalog_load(g_catalog_path, catalog, MAX_PRODUCTS, stderr);
+        if (n < 0) {
+            free(catalog);
+            return NULL;
+        }
+        if (g_products_set) {
+            if (args->num_products > n) {
+                fprintf(stderr, "%s[WALIDACJA]%s produkty (-p) = %d, a katalog %s "
+                        "ma %d pozycji.\n", C_RED, C_RESET, args->num_products,
+                        g_catalog_path, n);
+                free(catalog);
+                return NULL;
+            }
+            n = args->num_products;
+        }
+    } else {
+        catalog_default(catalog, n);
+    }
 
-    for (int i = 0; i < p; i++) {
-        shm->products[i] = DEFAULT_PRODUCTS[i];
+    if (args->conveyor_queues && n > MAX_CONV_QUEUES) {
+        fprintf(stderr, "%s[WALIDACJA]%s -Q obsluguje do %d produktow (katalog: %d).\n",
+                C_RED, C_RESET, MAX_CONV_QUEUES, n);
+        free(catalog);
+        return NULL;
     }
-    /* Jesli P > 12, dodaj warianty istniejacych produktow */
-    for (int i = p; i < shm->num_products; i++) {
-        snprintf(shm->products[i].name, MAX_NAME_LEN,
-                 "%s Extra", DEFAULT_PRODUCTS[i % DEFAULT_NUM_PRODUCTS].name);
-        shm->products[i].price = DEFAULT_PRODUCTS[i % DEFAULT_NUM_PRODUCTS].price * 1.2;
-        shm->products[i].conveyor_capacity =
-            DEFAULT_PRODUCTS[i % DEFAULT_NUM_PRODUCTS].conveyor_capacity;
+
+    SharedData *cfg = catalog_build_config(args, catalog, n);
+    free(catalog);
+    if (cfg == NULL)
+        handle_error("calloc (konfiguracja)");
+    if (cfg->weight_total <= 0) {
+        fprintf(stderr, "%s[WALIDACJA]%s Pierwsze %d pozycji katalogu maja wagi = 0.\n",
+                C_RED, C_RESET, n);
+        free(cfg);
+        return NULL;
     }
+    return cfg;
+}
 
+/**
+ * Inicjalizuje stan poczatkowy w pamieci dzielonej (katalog jest juz
+ * skopiowany z konfiguracji).
+ */
+static void init_shared_data(SharedData *shm)
+{
     /* Stan poczatkowy */
     shm->manager_pid       = getpid();
     shm->simulation_running = 1;
@@ -377,6 +586,11 @@ static void init_shared_data(SharedData *shm)
     shm->total_customers_entered = 0;
     shm->customers_served        = 0;
     shm->customers_not_served    = 0;
+    shm->tick                    = 0;
+    shm->tick_waiters            = 0;
+
+    /* Piekarz: 2 watki produkcyjne (1 przy jednym produkcie) */
+    shm->baker_threads = (shm->num_products >= 2) ? 2 : 1;
 
     /* Kasy: obie otwarte od poczatku */
     shm->register_open[0]      = 1;
@@ -406,7 +620,7 @@ static void init_semaphore_values(int sem_id, SharedData *shm)
     /* Semafory podajnikow: wolne miejsca = pojemnosc Ki */
     for (int i = 0; i < shm->num_products; i++) {
         init_semaphore(sem_id, SEM_CONVEYOR_BASE + i,
-                       shm->products[i].conveyor_capacity);
+                       shm_products(shm)[i].conveyor_capacity);
     }
 }
 
@@ -429,6 +643,7 @@ static pid_t start_baker(void)
 
     if (pid == 0) {
         /* Proces potomny - piekarz */
+        restore_child_sigmask();
         close(g_baker_pipe[0]); /* Zamknij koniec do czytania */
 
         /* Przekierowanie stderr do pliku logu (demonstracja dup2) */
@@ -451,6 +666,12 @@ static pid_t start_baker(void)
 
     /* Proces macierzysty */
     close(g_baker_pipe[1]); /* Zamknij koniec do pisania */
+
+    /* Koniec do czytania: nieblokujacy (petla epoll) i niedziedziczony
+     * przez kasjerow i klientow */
+    int flags = fcntl(g_baker_pipe[0], F_GETFL, 0);
+    fcntl(g_baker_pipe[0], F_SETFL, flags | O_NONBLOCK);
+    fcntl(g_baker_pipe[0], F_SETFD, FD_CLOEXEC);
     return pid;
 }
 
@@ -465,6 +686,8 @@ static pid_t start_cashier(int register_id)
         handle_error("fork (cashier)");
 
     if (pid == 0) {
+        restore_child_sigmask();
+
         /* Przekierowanie stderr do pliku logu */
         char log_path[64];
         snprintf(log_path, sizeof(log_path), "logs/kasjer_%d.log", register_id);
@@ -491,14 +714,34 @@ static pid_t start_cashier(int register_id)
  */
 static pid_t start_customer(void)
 {
+    /* Numer porzadkowy przed fork() - licznik zwieksza rodzic po powrocie,
+     * a dziecko moze ruszyc dopiero po kolejnych spawnach */
+    int ordinal = g_shm->total_customers_entered + 1;
     pid_t pid = fork();
     if (pid == -1) {
-        handle_warning("fork (customer)");
+        if (errno != EAGAIN) {
+            handle_warning("fork (customer)");
+            return -1;
+        }
+        /* Limit zadan ciasniejszy niz w planie (inne procesy uzytkownika) -
+         * obniz limit klientow naraz do biezacej liczby, reszta poczeka
+         * na wyjscie obecnych */
+        if (g_shm->active_customers >= 2 && g_shm->active_customers < g_plan.max_active) {
+            log_warn("fork (klient): EAGAIN przy %d klientach - limit klientow "
+                     "naraz obnizony z %d", g_shm->active_customers, g_plan.max_active);
+            g_plan.max_active = g_shm->active_customers;
+        }
         return -1;
     }
 
     if (pid == 0) {
-        execl("./klient", "klient", KEY_FILE, (char *)NULL);
+        restore_child_sigmask();
+        /* Zapis w dziecku przed exec - znacznik czasu nie zalezy od tego,
+         * kiedy planista wznowi rodzica (mapowanie dziennika dziedziczone) */
+        JOURNAL(EV_CUST_SPAWN, getpid(), 0, ordinal, 0, 0);
+        char ord_str[16];
+        snprintf(ord_str, sizeof(ord_str), "%d", ordinal);
+        execl("./klient", "klient", KEY_FILE, ord_str, (char *)NULL);
         perror("execl (klient)");
         _exit(EXIT_FAILURE);
     }
@@ -528,10 +771,10 @@ static pid_t start_customer(void)
         }
     }
 
-    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_lock(g_sem_id, g_shm);
     g_shm->active_customers++;
     g_shm->total_customers_entered++;
-    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_unlock(g_sem_id, g_shm);
 
     return pid;
 }
@@ -543,17 +786,17 @@ static pid_t start_customer(void)
 /**
  * Aktualizuje stan kas na podstawie liczby klientow.
  *
- * Zasady:
+ * Zasady (prog = g_register_pct % N, domyslnie N/4, "set kasa"):
  * - Zawsze min. 1 kasa otwarta (kasa 0)
- * - Jesli klientow >= N/2, obie kasy otwarte
- * - Jesli klientow < N/2, kasa 1 konczy obsluge kolejki i zamyka sie
+ * - Jesli klientow >= prog, obie kasy otwarte
+ * - Jesli klientow < prog, kasa 1 konczy obsluge kolejki i zamyka sie
  */
 static void update_register_state(void)
 {
-    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_lock(g_sem_id, g_shm);
 
     int nc = g_shm->customers_in_shop;
-    int threshold = g_shm->max_customers / 4;
+    int threshold = g_shm->max_customers * g_register_pct / 100;
 
     if (threshold < 1) threshold = 1;
 
@@ -562,7 +805,7 @@ static void update_register_state(void)
         if (!g_shm->register_accepting[1]) {
             g_shm->register_accepting[1] = 1;
             g_shm->register_open[1]      = 1;
-            sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+            shm_unlock(g_sem_id, g_shm);
             log_msg("Otwieram kase nr 2 (klientow: %d >= %d)", nc, threshold);
             return;
         }
@@ -571,7 +814,7 @@ static void update_register_state(void)
         if (g_shm->register_accepting[1]) {
             g_shm->register_accepting[1] = 0;
             /* Kasa 1 dokoncza obsluge kolejki */
-            sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+            shm_unlock(g_sem_id, g_shm);
             log_msg("Zamykam kase nr 2 (klientow: %d < %d) - dokonczy kolejke",
                     nc, threshold);
             return;
@@ -582,33 +825,200 @@ static void update_register_state(void)
         }
     }
 
-    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_unlock(g_sem_id, g_shm);
 }
 
 /* ================================================================
  *  OBSLUGA FIFO POLECEN (lacze nazwane)
  * ================================================================ */
 
+static int g_cmd_accepted = 0;   /* Polecenia FIFO przyjete */
+static int g_cmd_rejected = 0;   /* Polecenia FIFO odrzucone */
+
+static void tick_rescale(int scale_ms);
+
 /**
- * Sprawdza FIFO polecen w trybie nieblokujacym.
- * Komendy: "inventory" / "inwentaryzacja" -> SIGUSR1
- *          "evacuate" / "ewakuacja"       -> SIGUSR2
+ * Potwierdza polecenie FIFO: linia w logu, zdarzenie EV_COMMAND
+ * w dzienniku i linia "OK ..." / "ERR ..." w FIFO_ACK_PATH, jesli
+ * ktos je czyta (open O_NONBLOCK bez czytelnika = ENXIO, pomijamy).
  *
- * @param fifo_fd Deskryptor FIFO (otwarty nieblokujaco)
+ * @param cmd      FifoCommand
+ * @param accepted 1 = wykonane, 0 = odrzucone
+ * @param old_val  Wartosc przed zmiana (dla dziennika)
+ * @param new_val  Wartosc po zmianie
  */
-static void check_fifo_commands(int fifo_fd)
+static void command_ack(int cmd, int accepted, int old_val, int new_val,
+                        const char *fmt, ...)
 {
-    if (fifo_fd < 0) return;
+    char msg[160];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    if (accepted) {
+        g_cmd_accepted++;
+        log_msg_color(C_MAGENTA, "[ACK] OK %s", msg);
+    } else {
+        g_cmd_rejected++;
+        log_warn("[ACK] ERR %s", msg);
+    }
+    JOURNAL(EV_COMMAND, getpid(), cmd, accepted, old_val, new_val);
+
+    int ack_fd = open(FIFO_ACK_PATH, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (ack_fd >= 0) {
+        char line[176];
+        int n = snprintf(line, sizeof(line), "%s %s\n", accepted ? "OK" : "ERR", msg);
+        if (write(ack_fd, line, n) == -1 && errno != EAGAIN)
+            handle_warning("write (FIFO potwierdzen)");
+        close(ack_fd);
+    }
+}
 
-    char buf[64];
-    ssize_t n = read(fifo_fd, buf, sizeof(buf) - 1);
-    if (n <= 0) return;
+/**
+ * Odbiera do want miejsc z SEM_SHOP_ENTRY (bez czekania - miejsca
+ * zajete przez klientow wracaja pozniej).
+ * @return Liczba odebranych miejsc
+ */
+static int entry_take(int want)
+{
+    int avail = g_ipc->admission_value();
+    int take  = (avail < want) ? avail : want;
+    if (take <= 0 || g_ipc->admission_adjust(-take) == -1)
+        return 0;
+    return take;
+}
+
+/**
+ * Zmiana N: wiekszy limit od razu dodaje miejsca do SEM_SHOP_ENTRY
+ * (najpierw splacajac dlug), mniejszy odbiera wolne miejsca, a reszte
+ * zapisuje jako dlug odbierany w kolejnych tyknieciach (repay_entry_debt).
+ */
+static void set_max_customers(int n)
+{
+    int delta = n - g_shm->max_customers;
+    g_shm->max_customers = n;
+
+    if (delta > 0) {
+        int repay = (g_entry_debt < delta) ? g_entry_debt : delta;
+        g_entry_debt -= repay;
+        delta        -= repay;
+        if (delta > 0)
+            g_ipc->admission_adjust(delta);
+    } else if (delta < 0) {
+        g_entry_debt += -delta - entry_take(-delta);
+    }
+}
 
-    buf[n] = '\0';
-    /* Usun biale znaki z konca */
-    while (n > 0 && (buf[n-1] == '\n' || buf[n-1] == '\r'))
-        buf[--n] = '\0';
+/* repay_entry_debt - co tykniecie: odbiera miejsca zwolnione po zmniejszeniu N */
+static void repay_entry_debt(void)
+{
+    if (g_entry_debt == 0) return;
+    g_entry_debt -= entry_take(g_entry_debt);
+    if (g_entry_debt == 0)
+        log_msg("Limit N=%d osiagniety (nadmiarowi klienci wyszli).",
+                g_shm->max_customers);
+}
 
+/**
+ * Parametry zmieniane poleceniem "set <nazwa> <wartosc>".
+ */
+static const struct {
+    const char *name;    /* Nazwa polska */
+    const char *alias;   /* Nazwa angielska */
+    int         cmd;     /* FifoCommand */
+    int         min, max;
+} SET_PARAMS[] = {
+    { "skala",     "scale",         CMD_SCALE,         10, 5000 },
+    { "n",         "max_customers", CMD_MAX_CUSTOMERS, 2,  MAX_ACTIVE_CUST },
+    { "przybycia", "arrivals",      CMD_ARRIVALS,      0,  MAX_CUSTOMERS_TOTAL },
+    { "kasa",      "register",      CMD_REGISTER_PCT,  1,  100 },
+    { "piekarze",  "bakers",        CMD_BAKERS,        1,  MAX_BAKER_THREADS },
+};
+#define NUM_SET_PARAMS ((int)(sizeof(SET_PARAMS) / sizeof(SET_PARAMS[0])))
+
+/**
+ * Wykonuje "set <nazwa> <wartosc>" (args = tekst po "set ").
+ * Procesy potomne czytaja skale, N i liczbe watkow piekarza z SHM,
+ * wiec zmiana dziala od ich nastepnego odczytu.
+ */
+static void handle_set_command(const char *args)
+{
+    char name[32];
+    int value, used = 0;
+    if (sscanf(args, "%31s %d %n", name, &value, &used) < 2 || args[used] != '\0') {
+        command_ack(CMD_UNKNOWN, 0, 0, 0, "set %s - oczekiwano: set <nazwa> <liczba>", args);
+        return;
+    }
+
+    int p = 0;
+    while (p < NUM_SET_PARAMS && strcmp(name, SET_PARAMS[p].name) != 0
+           && strcmp(name, SET_PARAMS[p].alias) != 0)
+        p++;
+    if (p == NUM_SET_PARAMS) {
+        command_ack(CMD_UNKNOWN, 0, 0, value, "set %s - nieznany parametr "
+                    "(skala, n, przybycia, kasa, piekarze)", name);
+        return;
+    }
+
+    int cmd = SET_PARAMS[p].cmd;
+    if (validate_int_range(value, SET_PARAMS[p].min, SET_PARAMS[p].max,
+                           SET_PARAMS[p].name) != 0) {
+        command_ack(cmd, 0, 0, value, "set %s %d - poza zakresem [%d, %d]",
+                    SET_PARAMS[p].name, value, SET_PARAMS[p].min, SET_PARAMS[p].max);
+        return;
+    }
+    if (cmd == CMD_MAX_CUSTOMERS && value > g_plan.max_active) {
+        command_ack(cmd, 0, 0, value, "set %s %d - ponad limit klientow naraz "
+                    "%d (%s)", SET_PARAMS[p].name, value, g_plan.max_active,
+                    g_plan.task_limit);
+        return;
+    }
+
+    int old = 0;
+    switch (cmd) {
+        case CMD_SCALE:
+            old = g_shm->time_scale_ms;
+            g_shm->time_scale_ms = value;
+            tick_rescale(value);
+            break;
+        case CMD_MAX_CUSTOMERS:
+            old = g_shm->max_customers;
+            set_max_customers(value);
+            break;
+        case CMD_ARRIVALS:
+            old = g_arrivals;
+            g_arrivals = value;
+            break;
+        case CMD_REGISTER_PCT:
+            old = g_register_pct;
+            g_register_pct = value;
+            update_register_state();
+            break;
+        case CMD_BAKERS:
+            old = g_shm->baker_threads;
+            g_shm->baker_threads = value;
+            break;
+    }
+
+    if (cmd == CMD_MAX_CUSTOMERS && g_entry_debt > 0)
+        command_ack(cmd, 1, old, value, "set %s %d (bylo %d; %d miejsc zajetych - "
+                    "limit po wyjsciu klientow)", SET_PARAMS[p].name, value, old,
+                    g_entry_debt);
+    else
+        command_ack(cmd, 1, old, value, "set %s %d (bylo %d)",
+                    SET_PARAMS[p].name, value, old);
+}
+
+/**
+ * Wykonuje jedno polecenie z FIFO i potwierdza je (command_ack).
+ * Komendy: "inventory" / "inwentaryzacja" -> SIGUSR1
+ *          "evacuate" / "ewakuacja"       -> SIGUSR2
+ *          "log <spec>"                   -> zmiana poziomow logowania
+ *          "set <nazwa> <wartosc>"        -> zmiana parametru (SET_PARAMS)
+ */
+static void handle_fifo_command(const char *buf)
+{
     if (strcmp(buf, "inventory") == 0 || strcmp(buf, "inwentaryzacja") == 0) {
         log_msg_color(C_RED, ">>> SYGNAL INWENTARYZACJI <<<");
         g_shm->inventory_mode = 1;
@@ -624,6 +1034,7 @@ static void check_fifo_commands(int fifo_fd)
             if (g_customer_pids[i] > 0)
                 kill(g_customer_pids[i], SIGUSR1);
         }
+        command_ack(CMD_INVENTORY, 1, 0, 1, "inwentaryzacja");
     }
     else if (strcmp(buf, "evacuate") == 0 || strcmp(buf, "ewakuacja") == 0) {
         log_msg_color(C_RED, ">>> SYGNAL EWAKUACJI <<<");
@@ -640,9 +1051,67 @@ static void check_fifo_commands(int fifo_fd)
             if (g_customer_pids[i] > 0)
                 kill(g_customer_pids[i], SIGUSR2);
         }
+        command_ack(CMD_EVACUATE, 1, 0, 1, "ewakuacja");
+    }
+    else if (strncmp(buf, "log ", 4) == 0) {
+        /* Procesy czytaja progi wprost z SHM - zmiana dziala natychmiast */
+        if (log_apply_spec(g_shm, buf + 4) == 0) {
+            command_ack(CMD_LOG, 1, 0, 0, "log kierownik=%s piekarz=%s "
+                        "kasjer=%s klient=%s",
+                        log_level_name(g_shm->log_level[PROC_MANAGER]),
+                        log_level_name(g_shm->log_level[PROC_BAKER]),
+                        log_level_name(g_shm->log_level[PROC_CASHIER]),
+                        log_level_name(g_shm->log_level[PROC_CUSTOMER]));
+        } else {
+            command_ack(CMD_LOG, 0, 0, 0, "log %s - niepoprawne poziomy logowania",
+                        buf + 4);
+        }
+    }
+    else if (strncmp(buf, "set ", 4) == 0) {
+        handle_set_command(buf + 4);
     }
     else {
-        log_msg("Nieznane polecenie FIFO: '%s'", buf);
+        command_ack(CMD_UNKNOWN, 0, 0, 0, "%s - nieznane polecenie", buf);
+    }
+}
+
+/**
+ * Czyta FIFO polecen do wyczerpania (deskryptor nieblokujacy, gotowy
+ * wg epoll) i wykonuje kazda pelna linie. Niepelna linia czeka w
+ * buforze na reszte; zbyt dluga jest odrzucana.
+ *
+ * @param fifo_fd Deskryptor FIFO (otwarty nieblokujaco)
+ */
+static void check_fifo_commands(int fifo_fd)
+{
+    static char line[128];
+    static size_t len = 0;
+    static int overflow = 0;    /* Linia przekroczyla bufor - odrzuc w calosci */
+
+    if (fifo_fd < 0) return;
+
+    char buf[256];
+    ssize_t n;
+    while ((n = read(fifo_fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            char ch = buf[i];
+            if (ch == '\n') {
+                while (len > 0 && line[len - 1] == '\r')
+                    len--;
+                line[len] = '\0';
+                if (overflow)
+                    command_ack(CMD_UNKNOWN, 0, 0, 0, "%.32s... - linia dluzsza niz %zu "
+                                "znakow, odrzucona", line, sizeof(line) - 1);
+                else if (len > 0)
+                    handle_fifo_command(line);
+                len = 0;
+                overflow = 0;
+            } else if (len < sizeof(line) - 1) {
+                line[len++] = ch;
+            } else {
+                overflow = 1;
+            }
+        }
     }
 }
 
@@ -651,23 +1120,227 @@ static void check_fifo_commands(int fifo_fd)
  * ================================================================ */
 
 /**
- * Czyta komunikaty produkcji z pipe piekarza (nieblokujaco).
- * Piekarz wysyla przez pipe informacje o kazdej partii.
+ * Agregat rekordow BakerRecord dla jednego produktu.
  */
-static void read_baker_pipe(void)
+typedef struct {
+    int      batches;        /* Partie */
+    int      planned;        /* Sztuk zaplanowanych */
+    int      placed;         /* Sztuk polozonych na podajniku */
+    int      dropped;        /* Sztuk pominietych - podajnik pelny */
+    int      stalls;         /* Partie przerwane pelnym podajnikiem (dropped > 0) */
+    uint64_t place_us;       /* Suma czasow ukladania partii */
+    uint32_t place_us_max;
+} ProductionFeed;
+
+static ProductionFeed g_feed[MAX_PRODUCTS];
+static uint32_t       g_feed_first_tick = 0; /* Tykniecie pierwszego rekordu */
+static uint32_t       g_feed_last_tick  = 0; /* Tykniecie ostatniego rekordu */
+static int            g_feed_records    = 0;
+static int            g_feed_invalid    = 0; /* Rekordy z blednym kind/product_id */
+static int            g_feed_done       = 0; /* Odebrano BAKE_REC_DONE */
+
+/* feed_record - dolicza rekord piekarza do agregatu per produkt */
+static void feed_record(const BakerRecord *rec)
 {
-    if (g_baker_pipe[0] < 0) return;
+    uint32_t now_tick = __atomic_load_n(&g_shm->tick, __ATOMIC_RELAXED);
 
-    char buf[256];
-    /* Ustaw pipe jako nieblokujacy */
-    int flags = fcntl(g_baker_pipe[0], F_GETFL, 0);
-    fcntl(g_baker_pipe[0], F_SETFL, flags | O_NONBLOCK);
+    if (rec->kind == BAKE_REC_DONE) {
+        g_feed_done = 1;
+        return;
+    }
+    if (rec->kind != BAKE_REC_BATCH || rec->product_id >= g_shm->num_products) {
+        g_feed_invalid++;
+        return;
+    }
 
+    if (g_feed_records++ == 0)
+        g_feed_first_tick = now_tick;
+    g_feed_last_tick = now_tick;
+
+    ProductionFeed *f = &g_feed[rec->product_id];
+    f->batches++;
+    f->planned  += rec->quantity;
+    f->placed   += rec->placed;
+    f->dropped  += rec->dropped;
+    if (rec->dropped > 0)
+        f->stalls++;
+    f->place_us += rec->place_us;
+    if (rec->place_us > f->place_us_max)
+        f->place_us_max = rec->place_us;
+}
+
+/**
+ * Czyta rekordy produkcji (BakerRecord) z pipe piekarza (nieblokujaco).
+ * Niepelny rekord z konca odczytu czeka w buforze na reszte.
+ * @param epoll_fd Petla zdarzen (przy EOF pipe jest wyrejestrowany), -1 = brak
+ */
+static void read_baker_pipe(int epoll_fd)
+{
+    if (g_baker_pipe[0] < 0) return;
+
+    static unsigned char buf[64 * sizeof(BakerRecord)];
+    static size_t        have = 0;
     ssize_t n;
-    while ((n = read(g_baker_pipe[0], buf, sizeof(buf) - 1)) > 0) {
-        buf[n] = '\0';
-        /* Komunikaty piekarza o produkcji - logujemy */
+    while ((n = read(g_baker_pipe[0], buf + have, sizeof(buf) - have)) > 0) {
+        have += (size_t)n;
+        size_t off = 0;
+        for (; off + sizeof(BakerRecord) <= have; off += sizeof(BakerRecord)) {
+            BakerRecord rec;
+            memcpy(&rec, buf + off, sizeof(rec));
+            feed_record(&rec);
+        }
+        memmove(buf, buf + off, have - off);
+        have -= off;
+    }
+
+    /* EOF - piekarz zamknal pipe; usun z epoll (koniec czytania
+     * zamykamy jawnie, inaczej epoll zglaszalby EPOLLHUP bez konca) */
+    if (n == 0) {
+        if (epoll_fd >= 0)
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, g_baker_pipe[0], NULL);
+        close(g_baker_pipe[0]);
+        g_baker_pipe[0] = -1;
+    }
+}
+
+/**
+ * Probkuje stan podajnikow i kolejek do dziennika (co minute symulacji,
+ * tylko przy wlaczonym -j). Zapelnienie = pojemnosc - wartosc semafora
+ * SEM_CONVEYOR_BASE+i. Dane dla torow licznikow w eksporcie trace.
+ */
+static void sample_journal_counters(void)
+{
+    for (int i = 0; i < g_shm->num_products; i++) {
+        int cap = shm_products(g_shm)[i].conveyor_capacity;
+        int free_slots = sem_getval(g_sem_id, SEM_CONVEYOR_BASE + i);
+        if (free_slots < 0) continue;
+        JOURNAL(EV_SAMPLE_CONVEYOR, getpid(), i, cap - free_slots, cap, 0);
     }
+    JOURNAL(EV_SAMPLE_QUEUES, getpid(), 0, g_shm->register_queue_len[0],
+            g_shm->register_queue_len[1], g_shm->customers_in_shop);
+}
+
+/* ================================================================
+ *  ZEGAR SYMULACJI (HARMONOGRAM TYKNIEC)
+ * ================================================================ */
+
+/**
+ * Stan harmonogramu tykniec kierownika.
+ *
+ * Terminy leza na stalej siatce start + k * okres (CLOCK_MONOTONIC),
+ * a timerfd jest uzbrajany na kolejny termin bezwzgledny
+ * (TFD_TIMER_ABSTIME) - czas pracy tykniecia (spawn klientow,
+ * reap_children, I/O raportu) nie wydluza minuty symulacji. Gdy praca
+ * przekroczy okres, tykniecie jest przekroczeniem (overrun): w trybie
+ * domyslnym zalegle tykniecia wykonywane sa od razu (termin w
+ * przeszlosci - timerfd gotowy natychmiast), a w trybie -K skip sa
+ * pomijane - zegar symulacji przeskakuje o zalegle minuty naraz.
+ */
+typedef struct {
+    uint64_t    period_ns;     /* Okres tykniecia = time_scale_ms */
+    uint64_t    start_ns;      /* Poczatek siatki terminow */
+    uint64_t    deadline_ns;   /* Bezwzgledny termin nastepnego tykniecia */
+    uint64_t    ticks;         /* Wykonane tykniecia (przebiegi petli) */
+    uint64_t    minutes;       /* Minuty symulacji (tykniecia + pominiete) */
+    uint64_t    overruns;      /* Tykniecia, ktorych praca przekroczyla termin */
+    uint64_t    skipped;       /* Tykniecia pominiete (-K skip) */
+    int         late;          /* Biezacy termin minal przed uzbrojeniem */
+    int         pending_skip;  /* Minuty pominiete przy uzbrojeniu (-K skip) */
+    int64_t     drift_ns;      /* Zegar scienny - zegar symulacji (ostatni pomiar) */
+    int64_t     drift_max_ns;  /* Maksymalny dryf */
+    LatencyHist jitter;        /* Spoznienie wybudzenia po spaniu (us) */
+} TickClock;
+
+static TickClock g_tick;
+
+/* tick_init - ustawia siatke terminow; pierwsze tykniecie od razu */
+static void tick_init(TickClock *tc, int scale_ms)
+{
+    memset(tc, 0, sizeof(*tc));
+    tc->period_ns   = (uint64_t)scale_ms * 1000000ULL;
+    tc->start_ns    = hist_now_ns();
+    tc->deadline_ns = tc->start_ns;
+}
+
+/* tick_settime - uzbraja timerfd na tc->deadline_ns (czas bezwzgledny) */
+static void tick_settime(const TickClock *tc, int timer_fd)
+{
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec  = (time_t)(tc->deadline_ns / 1000000000ULL);
+    its.it_value.tv_nsec = (long)(tc->deadline_ns % 1000000000ULL);
+    if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+        its.it_value.tv_nsec = 1;  /* Zero rozbraja timer */
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1)
+        handle_error("timerfd_settime (tick)");
+}
+
+/**
+ * Po pracy tykniecia: uzbraja timerfd na biezacy termin. Termin, ktory
+ * juz minal, to przekroczenie - w trybie skip termin przesuwany jest
+ * o pelne zalegle okresy (doliczane przy nastepnym tick_fire()).
+ */
+static void tick_arm(TickClock *tc, int timer_fd)
+{
+    uint64_t now = hist_now_ns();
+
+    tc->late = (now >= tc->deadline_ns && tc->ticks > 0);
+    if (tc->late) {
+        tc->overruns++;
+        if (g_tick_skip) {
+            uint64_t behind = (now - tc->deadline_ns) / tc->period_ns;
+            tc->skipped     += behind;
+            tc->deadline_ns += behind * tc->period_ns;
+            tc->pending_skip = (int)behind;
+        }
+    }
+
+    tick_settime(tc, timer_fd);
+}
+
+/**
+ * Zmiana skali w trakcie symulacji ("set skala"): nastepny termin =
+ * ostatnie tykniecie + nowy okres (nie wczesniej niz teraz), dalej
+ * siatka biegnie z nowym okresem. Zmiana nie jest przekroczeniem.
+ */
+static void tick_set_period(TickClock *tc, int timer_fd, int scale_ms)
+{
+    uint64_t now  = hist_now_ns();
+    uint64_t last = tc->deadline_ns - tc->period_ns;
+
+    tc->period_ns   = (uint64_t)scale_ms * 1000000ULL;
+    tc->deadline_ns = last + tc->period_ns;
+    if (tc->deadline_ns < now)
+        tc->deadline_ns = now;
+    tick_settime(tc, timer_fd);
+}
+
+/**
+ * timerfd gotowy: statystyki wybudzenia i przesuniecie siatki.
+ * Zwraca liczbe minut symulacji do doliczenia (1, a w trybie skip
+ * 1 + liczba pominietych terminow).
+ */
+static int tick_fire(TickClock *tc, int timer_fd)
+{
+    uint64_t expirations;
+    if (read(timer_fd, &expirations, sizeof(expirations)) == -1
+        && errno != EAGAIN)
+        handle_warning("read (timerfd)");
+
+    uint64_t now = hist_now_ns();
+    int minutes = 1 + tc->pending_skip;
+    tc->pending_skip = 0;
+
+    if (!tc->late && now >= tc->deadline_ns)
+        hist_record(&tc->jitter, (now - tc->deadline_ns) / 1000);
+
+    tc->ticks++;
+    tc->minutes += minutes;
+    tc->drift_ns = (int64_t)(now - tc->deadline_ns);
+    if (tc->drift_ns > tc->drift_max_ns)
+        tc->drift_max_ns = tc->drift_ns;
+    tc->deadline_ns += tc->period_ns;
+    return minutes;
 }
 
 /* ================================================================
@@ -683,6 +1356,15 @@ static void generate_report(void)
 {
     log_msg_color(C_BOLD, "=== GENEROWANIE RAPORTU KONCOWEGO ===");
 
+    /* Spojna migawka statystyk (seqlock) - bez SEM_SHM_MUTEX */
+    SharedData *snap = shm_snapshot_new(g_shm);
+    if (snap == NULL) {
+        handle_warning("malloc (migawka raportu)");
+        return;
+    }
+    shm_read_state(g_shm, snap);
+    const SharedData *st = snap;
+
     /* Pobierz aktualna date za pomoca popen() */
     char timestamp[64] = "brak daty";
     FILE *date_fp = popen("date '+%Y-%m-%d %H:%M:%S'", "r");
@@ -698,111 +1380,192 @@ static void generate_report(void)
     int report_fd = open(REPORT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
     if (report_fd == -1) {
         handle_warning("open (report file)");
+        free(snap);
         return;
     }
 
-    /* Buduj raport w buforze */
-    char buf[4096];
+    /* Buduj raport w buforze (sekcje per produkt: do ~400 B na pozycje) */
+    size_t cap = 16384 + (size_t)g_shm->num_products * 512;
+    char *buf = malloc(cap);
+    if (buf == NULL) {
+        handle_warning("malloc (bufor raportu)");
+        close(report_fd);
+        free(snap);
+        return;
+    }
     int offset = 0;
 
-    offset += snprintf(buf + offset, sizeof(buf) - offset,
+    offset += snprintf(buf + offset, cap - offset,
         "============================================\n"
         "  RAPORT CIASTKARNI - SYMULACJA\n"
         "  Data: %s\n"
         "============================================\n\n", timestamp);
 
-    offset += snprintf(buf + offset, sizeof(buf) - offset,
+    uint64_t attaches = g_shm->hist[HIST_SHM_TOUCH].count;
+    offset += snprintf(buf + offset, cap - offset,
         "--- KONFIGURACJA ---\n"
-        "Produktow: %d\n"
+        "Produktow: %d (katalog: %s, suma wag: %d)\n"
+        "Ziarno (-S): %llu\n"
         "Maks. klientow w sklepie: %d\n"
         "Godziny: %02d:%02d - %02d:%02d\n"
-        "Skala czasu: %d ms/min\n\n",
-        g_shm->num_products, g_shm->max_customers,
+        "Skala czasu: %d ms/min\n"
+        "Watki piekarza: %d, prog kasy 2: %d%% N\n"
+        "Backend IPC: %s%s\n"
+        "Kolejki kas/paragonow (-r): %s, %d\n"
+        "Klienci naraz: %d (%s), semafory: %d/%ld, kolejki: %d\n"
+        "Pamiec dzielona: %llu B, %s, pierwszy dotyk: %.1f faultow/proces\n"
+        "Polecenia FIFO: %d przyjetych, %d odrzuconych\n\n",
+        g_shm->num_products, g_catalog_path ? g_catalog_path : "domyslny",
+        g_shm->weight_total, (unsigned long long)g_shm->seed, g_shm->max_customers,
         g_shm->open_hour, g_shm->open_min,
         g_shm->close_hour, g_shm->close_min,
-        g_shm->time_scale_ms);
-
-    offset += snprintf(buf + offset, sizeof(buf) - offset,
+        g_shm->time_scale_ms, g_shm->baker_threads, g_register_pct,
+        ipc_backend_name(g_shm->ipc_backend),
+        (g_shm->ipc_backend == IPC_BACKEND_SYSV && g_shm->conveyor_queues)
+            ? " (kolejka na podajnik, -Q)" : "",
+        g_shm->queue_shards > 0 ? "na kase" : "wspolna",
+        g_shm->queue_shards > 0 ? g_shm->queue_shards : 1,
+        g_plan.max_active, g_plan.task_limit, g_plan.num_sems, g_limits.sem_msl,
+        g_plan.num_queues,
+        (unsigned long long)g_shm->shm_size, shm_opts_str(g_shm->shm_active),
+        attaches ? (double)g_shm->shm_touch_faults / attaches : 0.0,
+        g_cmd_accepted, g_cmd_rejected);
+
+    offset += snprintf(buf + offset, cap - offset,
         "--- STATYSTYKI OGOLNE ---\n"
         "Laczna liczba klientow: %d\n"
         "Obsluzonych (paragon):  %d\n"
         "Nieobsluzonych:         %d\n"
         "Tryb inwentaryzacji: %s\n"
         "Ewakuacja: %s\n\n",
-        g_shm->total_customers_entered,
-        g_shm->customers_served,
-        g_shm->customers_not_served,
+        st->total_customers_entered,
+        st->customers_served,
+        st->customers_not_served,
         g_shm->inventory_mode ? "TAK" : "NIE",
         g_shm->evacuation_mode ? "TAK" : "NIE");
 
     /* Produkcja piekarza */
-    offset += snprintf(buf + offset, sizeof(buf) - offset,
+    offset += snprintf(buf + offset, cap - offset,
         "--- PRODUKCJA PIEKARZA ---\n");
     int total_produced = 0;
     for (int i = 0; i < g_shm->num_products; i++) {
-        offset += snprintf(buf + offset, sizeof(buf) - offset,
+        offset += snprintf(buf + offset, cap - offset,
             "  %-20s: %d szt.\n",
-            g_shm->products[i].name, g_shm->baker_produced[i]);
-        total_produced += g_shm->baker_produced[i];
+            shm_products(g_shm)[i].name, shm_stats(st)[i].baker_produced);
+        total_produced += shm_stats(st)[i].baker_produced;
     }
-    offset += snprintf(buf + offset, sizeof(buf) - offset,
+    offset += snprintf(buf + offset, cap - offset,
         "  RAZEM: %d szt.\n\n", total_produced);
 
+    /* Wydajnosc produkcji z rekordow pipe piekarza */
+    {
+        uint32_t minutes = g_feed_records > 0
+                         ? g_feed_last_tick - g_feed_first_tick + 1 : 0;
+        offset += snprintf(buf + offset, cap - offset,
+            "--- WYDAJNOSC PRODUKCJI (pipe piekarza) ---\n"
+            "Rekordy: %d (bledne: %d), minut produkcji: %u, koniec pracy: %s\n"
+            "  %-20s %7s %9s %9s %9s %10s\n",
+            g_feed_records, g_feed_invalid, minutes,
+            g_feed_done ? "TAK" : "NIE",
+            "produkt", "partie", "szt./h", "odrzuc.%", "przestoje", "uklad. ms");
+        for (int i = 0; i < g_shm->num_products; i++) {
+            const ProductionFeed *f = &g_feed[i];
+            double rate = minutes > 0 ? f->placed * 60.0 / minutes : 0.0;
+            double drop = f->planned > 0 ? 100.0 * f->dropped / f->planned : 0.0;
+            double avg  = f->batches > 0 ? f->place_us / 1000.0 / f->batches : 0.0;
+            offset += snprintf(buf + offset, cap - offset,
+                "  %-20s %7d %9.1f %9.1f %9d %10.2f\n",
+                shm_products(g_shm)[i].name, f->batches, rate, drop, f->stalls, avg);
+        }
+        offset += snprintf(buf + offset, cap - offset, "\n");
+    }
+
     /* Sprzedaz na kasach */
     for (int r = 0; r < 2; r++) {
-        offset += snprintf(buf + offset, sizeof(buf) - offset,
+        offset += snprintf(buf + offset, cap - offset,
             "--- KASA NR %d - PODSUMOWANIE ---\n", r + 1);
         int total_sold = 0;
         for (int i = 0; i < g_shm->num_products; i++) {
-            if (g_shm->register_sales[r][i] > 0) {
-                offset += snprintf(buf + offset, sizeof(buf) - offset,
+            if (shm_stats(st)[i].register_sales[r] > 0) {
+                offset += snprintf(buf + offset, cap - offset,
                     "  %-20s: %d szt. (%.2f PLN)\n",
-                    g_shm->products[i].name,
-                    g_shm->register_sales[r][i],
-                    g_shm->register_sales[r][i] * g_shm->products[i].price);
-                total_sold += g_shm->register_sales[r][i];
+                    shm_products(g_shm)[i].name,
+                    shm_stats(st)[i].register_sales[r],
+                    (int64_t)shm_stats(st)[i].register_sales[r]
+                        * shm_products(g_shm)[i].price_gr / 100.0);
+                total_sold += shm_stats(st)[i].register_sales[r];
             }
         }
-        offset += snprintf(buf + offset, sizeof(buf) - offset,
+        offset += snprintf(buf + offset, cap - offset,
             "  RAZEM: %d szt., PRZYCHOD: %.2f PLN\n\n",
-            total_sold, g_shm->register_revenue[r]);
+            total_sold, st->register_revenue_gr[r] / 100.0);
     }
 
     /* Stan podajnikow (ile zostalo na podajnikach) */
-    offset += snprintf(buf + offset, sizeof(buf) - offset,
+    offset += snprintf(buf + offset, cap - offset,
         "--- STAN PODAJNIKOW (KIEROWNIK) ---\n");
     int total_remaining = 0;
     for (int i = 0; i < g_shm->num_products; i++) {
-        int capacity = g_shm->products[i].conveyor_capacity;
+        int capacity = shm_products(g_shm)[i].conveyor_capacity;
         int free_space = sem_getval(g_sem_id, SEM_CONVEYOR_BASE + i);
         int on_conveyor = capacity - free_space;
         if (on_conveyor < 0) on_conveyor = 0;
-        offset += snprintf(buf + offset, sizeof(buf) - offset,
+        offset += snprintf(buf + offset, cap - offset,
             "  %-20s: %d szt. (pojemnosc: %d)\n",
-            g_shm->products[i].name, on_conveyor, capacity);
+            shm_products(g_shm)[i].name, on_conveyor, capacity);
         total_remaining += on_conveyor;
     }
-    offset += snprintf(buf + offset, sizeof(buf) - offset,
+    offset += snprintf(buf + offset, cap - offset,
         "  RAZEM na podajnikach: %d szt.\n\n", total_remaining);
 
+    /* Histogramy opoznien faz wizyty (scalone przez klientow i kasjerow) */
+    offset += snprintf(buf + offset, cap - offset,
+        "--- OPOZNIENIA (ms) ---\n");
+    for (int h = 0; h < HIST_COUNT; h++) {
+        char line[160];
+        hist_format(line, sizeof(line), &g_shm->hist[h]);
+        offset += snprintf(buf + offset, cap - offset,
+            "  %-15s: %s\n", hist_name(h), line);
+    }
+    offset += snprintf(buf + offset, cap - offset, "\n");
+
+    /* Harmonogram tykniec kierownika */
+    {
+        char line[160];
+        hist_format(line, sizeof(line), &g_tick.jitter);
+        offset += snprintf(buf + offset, cap - offset,
+            "--- ZEGAR SYMULACJI ---\n"
+            "Tryb przekroczen: %s\n"
+            "Tykniecia: %llu (minut symulacji: %llu, pominietych: %llu)\n"
+            "Przekroczenia okresu: %llu\n"
+            "Jitter wybudzenia (ms): %s\n"
+            "Dryf zegara: %.1f ms (maks. %.1f ms)\n\n",
+            g_tick_skip ? "skip (pomijanie)" : "catchup (nadrabianie)",
+            (unsigned long long)g_tick.ticks,
+            (unsigned long long)g_tick.minutes,
+            (unsigned long long)g_tick.skipped,
+            (unsigned long long)g_tick.overruns, line,
+            g_tick.drift_ns / 1e6, g_tick.drift_max_ns / 1e6);
+    }
+
     /* Kosz ewakuacyjny */
     if (g_shm->evacuation_mode) {
-        offset += snprintf(buf + offset, sizeof(buf) - offset,
+        offset += snprintf(buf + offset, cap - offset,
             "--- KOSZ EWAKUACYJNY ---\n");
         int total_basket = 0;
         for (int i = 0; i < g_shm->num_products; i++) {
-            if (g_shm->basket_items[i] > 0) {
-                offset += snprintf(buf + offset, sizeof(buf) - offset,
+            if (shm_stats(st)[i].basket_items > 0) {
+                offset += snprintf(buf + offset, cap - offset,
                     "  %-20s: %d szt.\n",
-                    g_shm->products[i].name, g_shm->basket_items[i]);
-                total_basket += g_shm->basket_items[i];
+                    shm_products(g_shm)[i].name, shm_stats(st)[i].basket_items);
+                total_basket += shm_stats(st)[i].basket_items;
             }
         }
-        offset += snprintf(buf + offset, sizeof(buf) - offset,
+        offset += snprintf(buf + offset, cap - offset,
             "  RAZEM w koszu: %d szt.\n\n", total_basket);
     }
 
-    offset += snprintf(buf + offset, sizeof(buf) - offset,
+    offset += snprintf(buf + offset, cap - offset,
         "============================================\n"
         "  KONIEC RAPORTU\n"
         "============================================\n");
@@ -814,6 +1577,8 @@ static void generate_report(void)
     /* Wyswietl raport takze na konsoli */
     printf("\n%s%s%s\n", C_BOLD, buf, C_RESET);
 
+    free(buf);
+    free(snap);
     log_msg("Raport zapisany do: %s", REPORT_FILE);
 }
 
@@ -829,17 +1594,30 @@ static void print_banner(SharedData *shm)
     printf("  ║        Systemy Operacyjne - Projekt           ║\n");
     printf("  ╚══════════════════════════════════════════════╝\n");
     printf("%s\n", C_RESET);
-    printf("  Produktow:   %d\n", shm->num_products);
+    printf("  Produktow:   %d (katalog: %s)\n", shm->num_products,
+           g_catalog_path ? g_catalog_path : "domyslny");
+    printf("  Ziarno (-S): %llu\n", (unsigned long long)shm->seed);
     printf("  Maks. klientow:  %d\n", shm->max_customers);
     printf("  Godziny:     %02d:%02d - %02d:%02d\n",
            shm->open_hour, shm->open_min,
            shm->close_hour, shm->close_min);
     printf("  Skala czasu: %d ms/min symulacji\n", shm->time_scale_ms);
+    printf("  Backend IPC: %s%s\n", ipc_backend_name(shm->ipc_backend),
+           shm->conveyor_queues ? " (kolejka na podajnik)" : "");
+    if (shm->queue_shards > 0)
+        printf("  Kolejki:     na kase, paragony w %d kolejkach\n",
+               shm->queue_shards);
+    printf("  Klienci naraz: %d (limit: %s)\n", g_plan.max_active, g_plan.task_limit);
+    printf("  Segment SHM: %llu B, %s\n", (unsigned long long)shm->shm_size,
+           shm_opts_str(shm->shm_active));
     if (g_max_time > 0)
         printf("  Limit czasu: %d sekund\n", g_max_time);
     printf("  FIFO polecen: %s\n", FIFO_CMD_PATH);
     printf("    Wyslij: echo 'inwentaryzacja' > %s\n", FIFO_CMD_PATH);
-    printf("            echo 'ewakuacja' > %s\n\n", FIFO_CMD_PATH);
+    printf("            echo 'ewakuacja' > %s\n", FIFO_CMD_PATH);
+    printf("            echo 'log klient=debug' > %s\n", FIFO_CMD_PATH);
+    printf("            echo 'set skala 50' > %s\n", FIFO_CMD_PATH);
+    printf("  Potwierdzenia: cat %s\n\n", FIFO_ACK_PATH);
 }
 
 /* ================================================================
@@ -856,6 +1634,7 @@ static void shutdown_simulation(void)
     g_shm->simulation_running = 0;
     g_shm->shop_open          = 0;
     g_shm->bakery_open        = 0;
+    tick_wake_all(g_shm);   /* Czekajacy na tykniecie widza koniec symulacji */
 
     /* Czekaj az klienci opuszcza sklep (z limitem czasu) */
     int wait_cycles = 0;
@@ -928,18 +1707,221 @@ static void shutdown_simulation(void)
     while (waitpid(-1, NULL, WNOHANG) > 0)
         ;
 
+    /* Ostatnie rekordy piekarza (az do BAKE_REC_DONE i EOF) */
+    read_baker_pipe(-1);
+
     log_msg("Wszystkie procesy zakonczane.");
 }
 
+/* tick_rescale - nowa skala czasu z polecenia "set skala" */
+static void tick_rescale(int scale_ms)
+{
+    if (g_timer_fd >= 0)
+        tick_set_period(&g_tick, g_timer_fd, scale_ms);
+}
+
+/* ================================================================
+ *  TYKNIECIE ZEGARA (praca jednej minuty symulacji)
+ * ================================================================ */
+
+/**
+ * Praca kierownika w jednym tyknieciu timerfd: zegar, otwarcie i
+ * zamkniecie sklepu, spawn klientow, auto-zamkniecie, kasy, probki.
+ * @param tick_minutes Minuty do doliczenia (>1 tylko w trybie -K skip)
+ * @return 1 gdy symulacja sie zakonczyla (raport wygenerowany), 0 wpp.
+ */
+static int simulation_tick(int tick_minutes)
+{
+    /* --- Obsluga ewakuacji --- */
+    if (g_shm->evacuation_mode) {
+        log_msg_color(C_RED, "EWAKUACJA W TOKU - zamykanie...");
+        shutdown_simulation();
+        generate_report();
+        return 1;
+    }
+
+    /* --- Postep zegara symulacji (seqlock: godzina i minuta razem) --- */
+    seq_write_begin(&g_shm->clock_seq);
+    g_shm->sim_min += tick_minutes;
+    while (g_shm->sim_min >= 60) {
+        g_shm->sim_min -= 60;
+        g_shm->sim_hour++;
+    }
+    seq_write_end(&g_shm->clock_seq);
+    tick_publish(g_shm, (uint32_t)tick_minutes);
+
+    /* --- Otwarcie sklepu (Tp + 30 min) --- */
+    int shop_open_hour = g_shm->open_hour;
+    int shop_open_min  = g_shm->open_min + 30;
+    if (shop_open_min >= 60) {
+        shop_open_hour++;
+        shop_open_min -= 60;
+    }
+    if (!g_shm->shop_open && !g_shm->evacuation_mode &&
+        (g_shm->sim_hour > shop_open_hour ||
+         (g_shm->sim_hour == shop_open_hour && g_shm->sim_min >= shop_open_min))) {
+        g_shm->shop_open = 1;
+        log_msg_color(C_GREEN, "Sklep otwarty! Godzina: %02d:%02d",
+                      g_shm->sim_hour, g_shm->sim_min);
+    }
+
+    /* --- Zamkniecie o godzinie Tk --- */
+    if (g_shm->sim_hour >= g_shm->close_hour &&
+        g_shm->sim_min >= g_shm->close_min) {
+        /* Jesli klienci wciaz aktywni - czekaj na nich (bez nowych) */
+        g_arrivals_closed = 1;
+        if (g_shm->total_customers_entered > 0
+            && g_shm->active_customers > 0) {
+            static int close_delay_logged = 0;
+            if (!close_delay_logged) {
+                close_delay_logged = 1;
+                log_msg_color(C_YELLOW,
+                    "Godzina zamkniecia %02d:%02d - czekam na %d aktywnych klientow.",
+                    g_shm->close_hour, g_shm->close_min,
+                    g_shm->active_customers);
+            }
+        } else {
+            log_msg_color(C_RED, "Godzina zamkniecia: %02d:%02d",
+                          g_shm->sim_hour, g_shm->sim_min);
+            shutdown_simulation();
+            generate_report();
+            return 1;
+        }
+    }
+
+    /* --- Wall-clock timeout (-t) --- */
+    if (g_max_time > 0) {
+        struct timespec wall_now;
+        clock_gettime(CLOCK_MONOTONIC, &wall_now);
+        int elapsed = (int)(wall_now.tv_sec - g_wall_start.tv_sec);
+        if (elapsed >= g_max_time) {
+            /* Jesli klienci wciaz aktywni - nie zamykaj (bez nowych) */
+            g_arrivals_closed = 1;
+            if (g_shm->total_customers_entered > 0
+                && g_shm->active_customers > 0) {
+                static int timeout_delay_logged = 0;
+                if (!timeout_delay_logged) {
+                    timeout_delay_logged = 1;
+                    log_msg_color(C_YELLOW,
+                        "Timeout %d s - czekam na %d aktywnych klientow.",
+                        g_max_time, g_shm->active_customers);
+                }
+            } else {
+                log_msg_color(C_RED, "Timeout %d s - zamykanie symulacji.",
+                              g_max_time);
+                shutdown_simulation();
+                generate_report();
+                return 1;
+            }
+        }
+    }
+
+    /* --- Generowanie klientow (naraz przy otwarciu; "set przybycia" = K na tykniecie) --- */
+    if (g_shm->shop_open && !g_shm->evacuation_mode && !g_arrivals_closed
+        && g_shm->total_customers_entered < MAX_CUSTOMERS_TOTAL) {
+        int to_spawn = MAX_CUSTOMERS_TOTAL - g_shm->total_customers_entered;
+        if (g_arrivals > 0 && to_spawn > g_arrivals)
+            to_spawn = g_arrivals;
+        if (g_arrivals == 0)
+            log_msg("Spawnowanie %d klientow do kolejki...", to_spawn);
+        int spawned = 0;
+        for (int b = 0; b < to_spawn; b++) {
+            if (g_shm->active_customers >= g_plan.max_active || g_sigint_received)
+                break;
+            if (start_customer() == -1)
+                break;
+            spawned++;
+            /* Spawn to jedno dlugie tykniecie - petla epoll stoi, wiec
+             * sygnaly (SIGINT, zombie np. zabitego piekarza) odbieramy
+             * po drodze */
+            if ((spawned & 63) == 0)
+                handle_signals(g_signal_fd);
+        }
+        if (g_arrivals == 0)
+            log_msg("Utworzono %d procesow klientow (lacznie: %d). "
+                    "Czekaja w kolejce na wejscie do sklepu.",
+                    spawned, g_shm->total_customers_entered);
+    }
+
+    /* --- Auto-zamkniecie po 5000 klientow --- */
+    if (g_shm->total_customers_entered >= MAX_CUSTOMERS_TOTAL) {
+        if (g_shm->active_customers == 0) {
+            log_msg_color(C_GREEN, "Obsluzono %d klientow - zamykanie symulacji.",
+                          g_shm->total_customers_entered);
+            shutdown_simulation();
+            generate_report();
+            return 1;
+        }
+        /* Jesli zostalo kilku klientow i czekamy zbyt dlugo - wymus zamkniecie */
+        /* Brak postepu mierzony czasem sciennym na siatce tykniec -
+         * seria nadrabianych lub pominietych tykniec po spawnie nie
+         * moze sama wyczerpac limitu (klienci nie mieli kiedy wyjsc) */
+        static uint64_t idle_since_ns = 0;
+        static int last_active = -1;
+        uint64_t now_ns = hist_now_ns();
+        if (last_active < 0) {
+            last_active   = g_shm->active_customers;
+            idle_since_ns = now_ns;
+        }
+        if (g_shm->active_customers < last_active) {
+            /* Jest postep - klienci wchodza/wychodza, resetuj timer */
+            idle_since_ns = now_ns;
+            last_active = g_shm->active_customers;
+        }
+        if (now_ns - idle_since_ns > 600 * g_tick.period_ns) { /* 600 min symulacji BEZ postepow */
+            log_msg_color(C_YELLOW,
+                "Timeout: %d aktywnych klientow nie konczy zakupow - wymuszam zamkniecie.",
+                g_shm->active_customers);
+            shutdown_simulation();
+            generate_report();
+            return 1;
+        }
+    }
+
+    /* --- Zarzadzanie kasami --- */
+    update_register_state();
+    repay_entry_debt();
+
+    /* --- Probki licznikow do dziennika --- */
+    if (g_journal_records != NULL)
+        sample_journal_counters();
+
+    return 0;
+}
+
 /* ================================================================
  *  GLOWNA PETLA SYMULACJI
  * ================================================================ */
 
 int main(int argc, char *argv[])
 {
-    srand(time(NULL) ^ getpid());
+    /* --- 1. Parsowanie argumentow (do kopii - opcje -m sa potrzebne
+     *        przed shmget, a -h i bledy nie dotykaja IPC) --- */
+    static SharedData args;
+    if (parse_args(argc, argv, &args) != 0)
+        return EXIT_FAILURE;
 
-    /* --- 1. Usun zastarale zasoby IPC z poprzednich uruchomien --- */
+    /* --- 1a. Katalog produktow (-f): od P zalezy rozmiar segmentu
+     *         i zbioru semaforow --- */
+    SharedData *cfg = build_config(&args);
+    if (cfg == NULL)
+        return EXIT_FAILURE;
+    size_t layout = shm_layout_size(cfg->num_products);
+
+    /* --- 1b. Tryb czasu wirtualnego (-V): bez procesow i IPC --- */
+    if (g_virtual_runs > 0) {
+        init_shared_data(cfg);
+        DesOptions opt = {
+            .runs    = g_virtual_runs,
+            .seed    = cfg->seed,
+            .fork_us = g_fork_us,
+        };
+        int rc = des_simulate(cfg, &opt, stdout);
+        free(cfg);
+        return rc;
+    }
+
+    /* --- 1c. Usun zastarale zasoby IPC z poprzednich uruchomien --- */
     if (access(KEY_FILE, F_OK) == 0) {
         cleanup_all_ipc(KEY_FILE, MAX_PRODUCTS);
     }
@@ -948,19 +1930,29 @@ int main(int argc, char *argv[])
     create_key_file();
     create_log_directory();
 
-    /* --- 2. Tworzenie pamieci dzielonej --- */
-    create_shared_memory(KEY_FILE);
+    /* --- 3. Tworzenie pamieci dzielonej (-m: duze strony, SHM_LOCK;
+     *        rozmiar z katalogu) --- */
+    int shm_active;
+    size_t shm_size;
+    int shm_id = create_shared_memory(KEY_FILE, cfg->shm_opts, layout,
+                                      &shm_active, &shm_size);
     g_shm = attach_shared_memory(KEY_FILE);
+    memcpy(g_shm, cfg, layout);
+    free(cfg);
+    g_shm->shm_active = shm_active;
+    g_shm->shm_size   = shm_size;
+
+    /* --- 4. Inicjalizacja danych w pamieci dzielonej --- */
+    init_shared_data(g_shm);
 
-    /* --- 3. Parsowanie argumentow (zapisuje do shm) --- */
-    if (parse_args(argc, argv, g_shm) != 0) {
+    /* --- 4b. Limity jadra i plan pojemnosci (przed semget/msgget) --- */
+    kernel_limits_read(&g_limits);
+    if (capacity_plan(&g_limits, g_shm, &g_plan, stderr) != 0) {
         detach_shared_memory(g_shm);
         cleanup_all_ipc(KEY_FILE, DEFAULT_NUM_PRODUCTS);
         return EXIT_FAILURE;
     }
-
-    /* --- 4. Inicjalizacja danych w pamieci dzielonej --- */
-    init_shared_data(g_shm);
+    g_shm->max_customers = g_plan.max_customers;
 
     /* --- 5. Tworzenie semaforow --- */
     int P = g_shm->num_products;
@@ -968,21 +1960,27 @@ int main(int argc, char *argv[])
     g_sem_id = create_semaphores(KEY_FILE, num_sems);
     init_semaphore_values(g_sem_id, g_shm);
 
-    /* --- 6. Tworzenie kolejek komunikatow --- */
-    int mq_conv   = create_message_queue(KEY_FILE, PROJ_MQ_CONV);
-    int mq_chkout = create_message_queue(KEY_FILE, PROJ_MQ_CHKOUT);
-    int mq_rcpt   = create_message_queue(KEY_FILE, PROJ_MQ_RCPT);
-
-    /* --- 6a. Inicjalizacja semaforow-straznikow kolejek --- */
-    init_semaphore(g_sem_id, SEM_GUARD_CONV(P),
-                   calc_queue_guard_init(mq_conv,   sizeof(struct conveyor_msg)));
-    init_semaphore(g_sem_id, SEM_GUARD_CHKOUT(P),
-                   calc_queue_guard_init(mq_chkout, sizeof(struct checkout_msg)));
-    init_semaphore(g_sem_id, SEM_GUARD_RCPT(P),
-                   calc_queue_guard_init(mq_rcpt,   sizeof(struct receipt_msg)));
+    /* --- 6. Kanaly komunikatow i wejscie do sklepu (backend -I) --- */
+    g_ipc = ipc_backend_get(g_shm->ipc_backend);
+    g_ipc->create(g_shm, KEY_FILE, g_sem_id);
+
+    /* --- 6a. Blok startowy: potomkowie dolaczaja po ID, bez ftok() ---
+     * CIASTKARNIA_IPC_ATTACH=ftok zostawia stara sciezke (pomiar startu) */
+    const char *attach_mode = getenv(ENV_IPC_ATTACH);
+    if (attach_mode == NULL || strcmp(attach_mode, "ftok") != 0) {
+        char id_str[16];
+        snprintf(id_str, sizeof(id_str), "%d", shm_id);
+        g_shm->boot.shm_id = shm_id;
+        g_shm->boot.ready  = 1;
+        if (setenv(ENV_SHM_ID, id_str, 1) == -1)
+            handle_warning("setenv (" ENV_SHM_ID ")");
+    } else {
+        unsetenv(ENV_SHM_ID);
+    }
 
-    /* --- 7. Tworzenie FIFO polecen (lacze nazwane) --- */
+    /* --- 7. Tworzenie FIFO polecen i potwierdzen (lacza nazwane) --- */
     create_fifo(FIFO_CMD_PATH);
+    create_fifo(FIFO_ACK_PATH);
 
     /* --- 8. Wyczysc plik logow z poprzedniego uruchomienia --- */
     {
@@ -990,14 +1988,16 @@ int main(int argc, char *argv[])
         if (f) fclose(f);
     }
 
-    /* --- 9. Logger --- */
+    /* --- 9. Logger i dziennik zdarzen --- */
     logger_init(g_shm, PROC_MANAGER, 0);
+    if (journal_create(g_shm, JOURNAL_FILE, (uint64_t)g_journal_cap) != 0)
+        log_warn("Dziennik zdarzen wylaczony (blad tworzenia %s)", JOURNAL_FILE);
 
     /* --- 9. Baner startowy --- */
     print_banner(g_shm);
 
-    /* --- 10. Signal handlers + atexit safety net --- */
-    setup_signal_handlers();
+    /* --- 10. signalfd + atexit safety net --- */
+    g_signal_fd = setup_signalfd();
     atexit(atexit_cleanup);
 
     /* --- 11. Uruchomienie procesow --- */
@@ -1015,183 +2015,87 @@ int main(int argc, char *argv[])
     log_msg("Ciastkarnia otwarta! Godzina: %02d:%02d",
             g_shm->sim_hour, g_shm->sim_min);
 
-    /* --- 13. Otworz FIFO do czytania (nieblokujaco) --- */
-    int fifo_fd = open(FIFO_CMD_PATH, O_RDONLY | O_NONBLOCK);
+    /* --- 13. Otworz FIFO do czytania (nieblokujaco) ---
+     * Wlasny, nieuzywany koniec do pisania: bez niego po zamknieciu
+     * ostatniego pisarza (echo) FIFO zglaszaloby EPOLLHUP bez przerwy. */
+    int fifo_fd = open(FIFO_CMD_PATH, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
     if (fifo_fd == -1)
         handle_warning("open (FIFO)");
-
-    /* Ustaw pipe piekarza jako nieblokujacy */
-    if (g_baker_pipe[0] >= 0) {
-        int flags = fcntl(g_baker_pipe[0], F_GETFL, 0);
-        fcntl(g_baker_pipe[0], F_SETFL, flags | O_NONBLOCK);
+    int fifo_keep_fd = -1;
+    if (fifo_fd >= 0) {
+        fifo_keep_fd = open(FIFO_CMD_PATH, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fifo_keep_fd == -1)
+            handle_warning("open (FIFO, pisarz)");
     }
 
     /* ============================================================
-     * GLOWNA PETLA SYMULACJI
-     * Kazda iteracja = 1 minuta czasu symulacji
+     * GLOWNA PETLA SYMULACJI - epoll
+     * Zrodla: signalfd (SIGCHLD/SIGINT/SIGTERM/SIGCONT), timerfd
+     * (tykniecie = 1 minuta symulacji), FIFO polecen, pipe piekarza.
+     * Polecenia i zakonczenia potomkow obslugiwane sa od razu, a nie
+     * przy najblizszym tyknieciu; bez zdarzen proces spi w epoll_wait.
      * ============================================================ */
-    int customer_spawn_timer = 0;   /* Odliczanie do nastepnego klienta */
-    int next_spawn_interval  = 3 + rand() % 8;  /* 3-10 min symulacji */
 
     /* Zegar scienny (wall-clock) do obslugi -t timeout */
-    struct timespec wall_start;
-    clock_gettime(CLOCK_MONOTONIC, &wall_start);
-
-    while (g_shm->simulation_running && !g_sigint_received) {
-
-        /* --- Obsluga SIGCONT (wznowienie po Ctrl+Z) --- */
-        if (g_sigcont_received) {
-            g_sigcont_received = 0;
-            log_msg("Wznowiono po zatrzymaniu (SIGCONT) - czyszczenie zombie...");
-            reap_children();
-        }
-
-        /* --- Obsluga SIGCHLD --- */
-        if (g_sigchld_received) {
-            g_sigchld_received = 0;
-            reap_children();
-        }
-
-        /* --- Obsluga ewakuacji --- */
-        if (g_shm->evacuation_mode) {
-            log_msg_color(C_RED, "EWAKUACJA W TOKU - zamykanie...");
-            shutdown_simulation();
-            generate_report();
-            break;
-        }
-
-        /* --- Postep zegara symulacji --- */
-        g_shm->sim_min++;
-        if (g_shm->sim_min >= 60) {
-            g_shm->sim_min = 0;
-            g_shm->sim_hour++;
+    clock_gettime(CLOCK_MONOTONIC, &g_wall_start);
+
+    g_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (g_timer_fd == -1)
+        handle_error("timerfd_create");
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+        handle_error("epoll_create1");
+    epoll_add(epoll_fd, g_signal_fd, SRC_SIGNAL);
+    epoll_add(epoll_fd, g_timer_fd, SRC_TICK);
+    if (fifo_fd >= 0)
+        epoll_add(epoll_fd, fifo_fd, SRC_FIFO);
+    if (g_baker_pipe[0] >= 0)
+        epoll_add(epoll_fd, g_baker_pipe[0], SRC_BAKER_PIPE);
+
+    /* Harmonogram tykniec: stala siatka terminow od tej chwili */
+    tick_init(&g_tick, g_shm->time_scale_ms);
+    tick_arm(&g_tick, g_timer_fd);
+
+    int finished = 0;
+    while (!finished && g_shm->simulation_running && !g_sigint_received) {
+        struct epoll_event events[EPOLL_MAX_EVENTS];
+        int n = epoll_wait(epoll_fd, events, EPOLL_MAX_EVENTS, -1);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            handle_error("epoll_wait");
         }
 
-        /* --- Otwarcie sklepu (Tp + 30 min) --- */
-        int shop_open_hour = g_shm->open_hour;
-        int shop_open_min  = g_shm->open_min + 30;
-        if (shop_open_min >= 60) {
-            shop_open_hour++;
-            shop_open_min -= 60;
-        }
-        if (!g_shm->shop_open && !g_shm->evacuation_mode &&
-            (g_shm->sim_hour > shop_open_hour ||
-             (g_shm->sim_hour == shop_open_hour && g_shm->sim_min >= shop_open_min))) {
-            g_shm->shop_open = 1;
-            log_msg_color(C_GREEN, "Sklep otwarty! Godzina: %02d:%02d",
-                          g_shm->sim_hour, g_shm->sim_min);
-        }
-
-        /* --- Zamkniecie o godzinie Tk --- */
-        if (g_shm->sim_hour >= g_shm->close_hour &&
-            g_shm->sim_min >= g_shm->close_min) {
-            /* Jesli klienci wciaz aktywni - czekaj na nich */
-            if (g_shm->total_customers_entered > 0
-                && g_shm->active_customers > 0) {
-                static int close_delay_logged = 0;
-                if (!close_delay_logged) {
-                    close_delay_logged = 1;
-                    log_msg_color(C_YELLOW,
-                        "Godzina zamkniecia %02d:%02d - czekam na %d aktywnych klientow.",
-                        g_shm->close_hour, g_shm->close_min,
-                        g_shm->active_customers);
-                }
-            } else {
-                log_msg_color(C_RED, "Godzina zamkniecia: %02d:%02d",
-                              g_shm->sim_hour, g_shm->sim_min);
-                shutdown_simulation();
-                generate_report();
-                break;
-            }
-        }
-
-        /* --- Wall-clock timeout (-t) --- */
-        if (g_max_time > 0) {
-            struct timespec wall_now;
-            clock_gettime(CLOCK_MONOTONIC, &wall_now);
-            int elapsed = (int)(wall_now.tv_sec - wall_start.tv_sec);
-            if (elapsed >= g_max_time) {
-                /* Jesli klienci wciaz aktywni - nie zamykaj */
-                if (g_shm->total_customers_entered > 0
-                    && g_shm->active_customers > 0) {
-                    static int timeout_delay_logged = 0;
-                    if (!timeout_delay_logged) {
-                        timeout_delay_logged = 1;
-                        log_msg_color(C_YELLOW,
-                            "Timeout %d s - czekam na %d aktywnych klientow.",
-                            g_max_time, g_shm->active_customers);
-                    }
-                } else {
-                    log_msg_color(C_RED, "Timeout %d s - zamykanie symulacji.",
-                                  g_max_time);
-                    shutdown_simulation();
-                    generate_report();
+        for (int i = 0; i < n && !finished; i++) {
+            switch (events[i].data.u32) {
+                case SRC_SIGNAL:
+                    handle_signals(g_signal_fd);
                     break;
-                }
-            }
-        }
-
-        /* --- Generowanie klientow (wszystkich naraz przy otwarciu) --- */
-        if (g_shm->shop_open && !g_shm->evacuation_mode
-            && g_shm->total_customers_entered < MAX_CUSTOMERS_TOTAL) {
-            int to_spawn = MAX_CUSTOMERS_TOTAL - g_shm->total_customers_entered;
-            log_msg("Spawnowanie %d klientow do kolejki...", to_spawn);
-            int spawned = 0;
-            for (int b = 0; b < to_spawn; b++) {
-                if (g_shm->active_customers >= MAX_ACTIVE_CUST)
+                case SRC_FIFO:
+                    check_fifo_commands(fifo_fd);
+                    break;
+                case SRC_BAKER_PIPE:
+                    read_baker_pipe(epoll_fd);
+                    break;
+                case SRC_TICK:
+                    finished = simulation_tick(tick_fire(&g_tick, g_timer_fd));
+                    if (!finished)
+                        tick_arm(&g_tick, g_timer_fd);
                     break;
-                start_customer();
-                spawned++;
             }
-            log_msg("Utworzono %d procesow klientow (lacznie: %d). "
-                    "Czekaja w kolejce na wejscie do sklepu.",
-                    spawned, g_shm->total_customers_entered);
         }
 
-        /* --- Auto-zamkniecie po 5000 klientow --- */
-        if (g_shm->total_customers_entered >= MAX_CUSTOMERS_TOTAL) {
-            if (g_shm->active_customers == 0) {
-                log_msg_color(C_GREEN, "Obsluzono %d klientow - zamykanie symulacji.",
-                              g_shm->total_customers_entered);
-                shutdown_simulation();
-                generate_report();
-                break;
-            }
-            /* Jesli zostalo kilku klientow i czekamy zbyt dlugo - wymus zamkniecie */
-            static int idle_ticks = 0;
-            static int last_active = -1;
-            if (last_active < 0) last_active = g_shm->active_customers;
-            if (g_shm->active_customers < last_active) {
-                /* Jest postep - klienci wchodza/wychodza, resetuj timer */
-                idle_ticks = 0;
-                last_active = g_shm->active_customers;
-            }
-            idle_ticks++;
-            if (idle_ticks > 600) { /* 600 min symulacji BEZ postepow */
-                log_msg_color(C_YELLOW,
-                    "Timeout: %d aktywnych klientow nie konczy zakupow - wymuszam zamkniecie.",
-                    g_shm->active_customers);
-                shutdown_simulation();
-                generate_report();
-                break;
-            }
+        /* --- Ewakuacja z FIFO - od razu, nie przy nastepnym tyknieciu --- */
+        if (!finished && !g_sigint_received && g_shm->evacuation_mode) {
+            log_msg_color(C_RED, "EWAKUACJA W TOKU - zamykanie...");
+            shutdown_simulation();
+            generate_report();
+            finished = 1;
         }
-
-        /* --- Zarzadzanie kasami --- */
-        update_register_state();
-
-        /* --- Odczyt polecen z FIFO --- */
-        check_fifo_commands(fifo_fd);
-
-        /* --- Odczyt z pipe piekarza --- */
-        read_baker_pipe();
-
-        /* --- Czekaj 1 minute symulacji --- */
-        msleep_safe(g_shm->time_scale_ms);
     }
 
     /* --- Obsluga SIGINT --- */
-    if (g_sigint_received) {
+    if (g_sigint_received && !finished) {
         log_msg("Otrzymano SIGINT - zamykanie...");
         shutdown_simulation();
         generate_report();
@@ -1202,7 +2106,17 @@ int main(int argc, char *argv[])
     log_msg_color(C_GREEN, "Symulacja zakonczona pomyslnie.");
 
     if (fifo_fd >= 0) close(fifo_fd);
+    if (fifo_keep_fd >= 0) close(fifo_keep_fd);
     if (g_baker_pipe[0] >= 0) close(g_baker_pipe[0]);
+    close(epoll_fd);
+    close(g_timer_fd);
+    close(g_signal_fd);
+    if (g_shm->journal_capacity > 0) {
+        log_msg("Dziennik zdarzen: %s (%llu zdarzen, odrzuconych: %llu)",
+                JOURNAL_FILE, (unsigned long long)g_shm->journal_next,
+                (unsigned long long)g_shm->journal_dropped);
+    }
+    journal_close(1);
     detach_shared_memory(g_shm);
     g_shm = NULL;
     logger_init(NULL, PROC_MANAGER, 0);
@@ -6,19 +6,24 @@
  * pobiera produkty z podajnikow (kolejka komunikatow w trybie FIFO),
  * nastepnie udaje sie do kasy i otrzymuje paragon.
  *
- * Komunikacja:
- * - Podajniki: kolejka komunikatow (msgrcv z mtype = product_id + 1)
- * - Checkout: kolejka komunikatow (msgsnd z mtype = register_id + 1)
+ * Komunikacja (kanaly przez backend IPC, ipc_channel.h):
+ * - Podajniki: kolejka komunikatow (mtype = product_id + 1 / mq podajnika)
+ * - Checkout: kolejka komunikatow (mtype = register_id + 1 / mq kasy)
  * - Paragon: kolejka komunikatow (msgrcv z mtype = getpid())
  * - Stan: pamiec dzielona
- * - Wejscie do sklepu: semafor zliczajacy (SEM_SHOP_ENTRY)
+ * - Wejscie do sklepu: semafor zliczajacy (SEM_SHOP_ENTRY / sem_open)
  * - Sygnaly: SIGUSR2 (ewakuacja), SIGTERM
  */
 
 #include "common.h"
 #include "error_handler.h"
 #include "ipc_utils.h"
+#include "ipc_channel.h"
 #include "logger.h"
+#include "journal.h"
+#include "histogram.h"
+#include "catalog.h"
+#include "rng.h"
 
 /* ================================================================
  *  ZMIENNE GLOBALNE PROCESU
@@ -26,11 +31,14 @@
 
 static SharedData *g_shm          = NULL;
 static int         g_sem_id       = -1;
-static int         g_mq_conveyor  = -1;
-static int         g_mq_checkout  = -1;
-static int         g_mq_receipt   = -1;
+static const IpcBackend *g_ipc    = NULL;  /* Kanaly IPC (SharedData.ipc_backend) */
 static int         g_in_shop      = 0;   /* 1 jesli klient jest w sklepie */
-static int         g_cart[MAX_PRODUCTS]; /* Koszyk - ile szt. kazdego produktu */
+static BasketLine  g_cart[MAX_BASKET_LINES]; /* Koszyk - pobrane sztuki (linie) */
+static int         g_cart_lines   = 0;
+static CustomerExit g_exit_reason = EXIT_SERVED; /* Powod wyjscia (dziennik) */
+static LatencyHist g_hist[HIST_COUNT]; /* Lokalne histogramy, scalane przy wyjsciu */
+static uint64_t    g_start_ns     = 0;   /* Start procesu (HIST_VISIT) */
+static Rng         g_rng;                /* Strumien klienta nr k (RNG_STREAM_CUSTOMER) */
 
 static volatile sig_atomic_t g_evacuation = 0;
 static volatile sig_atomic_t g_terminate  = 0;
@@ -86,16 +94,32 @@ static void leave_shop(void)
 {
     if (!g_in_shop) return;
 
-    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_lock(g_sem_id, g_shm);
     if (g_shm->customers_in_shop > 0)
         g_shm->customers_in_shop--;
-    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_unlock(g_sem_id, g_shm);
 
     /* Zwolnij miejsce w sklepie (semafor zliczajacy) */
-    sem_signal_undo(g_sem_id, SEM_SHOP_ENTRY);
+    g_ipc->admission_release();
 
     g_in_shop = 0;
-    log_msg("Opuscil sklep.");
+    log_debug("Opuscil sklep.");
+}
+
+/**
+ * Konczy wizyte: scalenie histogramow, zapis wyjscia do dziennika
+ * i odlaczenie SHM.
+ * @return Kod wyjscia procesu
+ */
+static int finish_visit(CustomerExit reason)
+{
+    hist_record_since(&g_hist[HIST_VISIT], g_start_ns, hist_now_ns());
+    for (int h = 0; h < HIST_COUNT; h++)
+        hist_merge(&g_shm->hist[h], &g_hist[h]);
+
+    JOURNAL(EV_CUST_EXIT, getpid(), 0, reason, 0, 0);
+    detach_shared_memory(g_shm);
+    return EXIT_SUCCESS;
 }
 
 /**
@@ -107,14 +131,11 @@ static void handle_evacuation(void)
     log_msg_color(C_RED, "EWAKUACJA! Odkladam produkty do kosza i wychodzę!");
 
     /* Odloz produkty z koszyka do kosza ewakuacyjnego */
-    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
-    for (int i = 0; i < g_shm->num_products; i++) {
-        if (g_cart[i] > 0) {
-            g_shm->basket_items[i] += g_cart[i];
-            g_cart[i] = 0;
-        }
-    }
-    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_lock(g_sem_id, g_shm);
+    for (int k = 0; k < g_cart_lines; k++)
+        shm_stats(g_shm)[g_cart[k].product_id].basket_items += g_cart[k].qty;
+    g_cart_lines = 0;
+    shm_unlock(g_sem_id, g_shm);
 
     leave_shop();
 }
@@ -125,31 +146,34 @@ static void handle_evacuation(void)
 
 /**
  * Generuje losowa liste zakupow.
- * Klient wybiera min. 2 rozne produkty.
- * @param shopping_list  Tablica [MAX_PRODUCTS] - ilosc kazdego produktu
+ * Produkty losowane wedlug wag popularnosci z katalogu (catalog_pick).
+ * @param list  [out] Linie listy (produkt, ile chce)
+ * @return Liczba linii
  */
-static void generate_shopping_list(int *shopping_list)
+static int generate_shopping_list(BasketLine *list)
 {
     int np = g_shm->num_products;
-    memset(shopping_list, 0, sizeof(int) * MAX_PRODUCTS);
+    const ProductDef *products = shm_products(g_shm);
 
     /* Wybierz min. 2, max. 5 roznych produktow */
     int num_types =1;
     if (num_types > np) num_types = np;
 
-    /* Losuj rozne produkty */
-    int chosen[MAX_PRODUCTS];
-    memset(chosen, 0, sizeof(chosen));
+    /* Losuj rozne produkty (ograniczona liczba prob - produkty z waga 0
+     * nie sa losowane) */
     int count = 0;
-
-    while (count < num_types) {
-        int prod = rand() % np;
-        if (!chosen[prod]) {
-            chosen[prod] = 1;
-            shopping_list[prod] = 1 + rand() % 3;  /* 1-3 sztuki */
+    for (int tries = 0; count < num_types && tries < 16 * num_types; tries++) {
+        int prod = catalog_pick(products, np, rng_below(&g_rng, g_shm->weight_total));
+        int dup = 0;
+        for (int k = 0; k < count; k++)
+            dup |= (list[k].product_id == prod);
+        if (!dup) {
+            list[count].product_id = (uint16_t)prod;
+            list[count].qty        = (uint16_t)rng_cust_qty(&g_rng);
             count++;
         }
     }
+    return count;
 }
 
 /* ================================================================
@@ -161,19 +185,19 @@ static void generate_shopping_list(int *shopping_list)
  * Produkty sa pobierane w kolejnosci FIFO z kazdego podajnika.
  * Jesli produkt niedostepny (podajnik pusty), klient go nie kupuje.
  *
- * @param shopping_list  Lista zakupow (ile chce)
+ * @param list   Lista zakupow (ile chce)
+ * @param lines  Liczba linii listy
  */
-static void do_shopping(int *shopping_list)
+static void do_shopping(const BasketLine *list, int lines)
 {
-    memset(g_cart, 0, sizeof(g_cart));
+    g_cart_lines = 0;
 
-    for (int i = 0; i < g_shm->num_products; i++) {
+    for (int k = 0; k < lines; k++) {
         if (g_evacuation || g_terminate) return;
 
-        if (shopping_list[i] <= 0) continue;
-
-        int wanted = shopping_list[i];
-        int got = 0;
+        int i      = list[k].product_id;
+        int wanted = list[k].qty;
+        int got    = 0;
 
         for (int q = 0; q < wanted; q++) {
             if (g_evacuation || g_terminate) return;
@@ -182,23 +206,23 @@ static void do_shopping(int *shopping_list)
             struct conveyor_msg cmsg;
             int retries = 0;
             int max_retries = 500;  /* max prob na 1 sztuke */
-            ssize_t ret = -1;
+            int ret = -1;
+            uint64_t wait_from = hist_now_ns();
 
             while (retries < max_retries) {
                 if (g_evacuation || g_terminate) return;
 
-                ret = msgrcv_guarded(g_mq_conveyor, &cmsg,
-                                     sizeof(cmsg) - sizeof(long),
-                                     i + 1, IPC_NOWAIT,
-                                     g_sem_id, SEM_GUARD_CONV(g_shm->num_products));
+                ret = g_ipc->conveyor_take(i, &cmsg);
 
-                if (ret >= 0) break;  /* Sukces */
+                if (ret == 0) break;  /* Sukces */
 
                 if (errno == ENOMSG) {
                     retries++;
+                    log_trace("Podajnik '%s' pusty - proba %d/%d",
+                              shm_products(g_shm)[i].name, retries, max_retries);
                     if (retries < max_retries) {
-                        /* Czekaj ~1 min symulacji na dostawe */
-                        usleep(g_shm->time_scale_ms * 1000);
+                        /* Czekaj do nastepnego tykniecia zegara (dostawa) */
+                        wait_until_tick(g_shm, sim_tick_now(g_shm) + 1);
                     }
                     continue;
                 }
@@ -209,25 +233,29 @@ static void do_shopping(int *shopping_list)
 
             if (ret == -1) {
                 /* Produkt niedostepny po wszystkich probach */
+                JOURNAL(EV_CUST_PICK, getpid(), 0, i, 0, retries);
                 break;
             }
 
             /* Pobralismy produkt - zwolnij miejsce na podajniku */
             sem_signal_op(g_sem_id, SEM_CONVEYOR_BASE + i);
             got++;
+            hist_record_since(&g_hist[HIST_CONVEYOR_WAIT], wait_from, hist_now_ns());
+            JOURNAL(EV_CUST_PICK, getpid(), 0, i, 1, retries);
 
             /* Symulacja czasu pobierania: 0.5 min symulacji */
             usleep(g_shm->time_scale_ms * 500);
         }
 
-        g_cart[i] = got;
-
         if (got > 0) {
-            log_msg("Pobrano %d/%d szt. '%s' z podajnika",
-                    got, wanted, g_shm->products[i].name);
+            g_cart[g_cart_lines].product_id = (uint16_t)i;
+            g_cart[g_cart_lines].qty        = (uint16_t)got;
+            g_cart_lines++;
+            log_debug("Pobrano %d/%d szt. '%s' z podajnika",
+                    got, wanted, shm_products(g_shm)[i].name);
         } else if (wanted > 0) {
-            log_msg("Produkt '%s' niedostepny (podajnik pusty)",
-                    g_shm->products[i].name);
+            log_debug("Produkt '%s' niedostepny (podajnik pusty)",
+                    shm_products(g_shm)[i].name);
         }
     }
 }
@@ -246,19 +274,20 @@ static int do_checkout(void)
 {
     /* Sprawdz czy mamy cokolwiek w koszyku */
     int total_items = 0;
-    for (int i = 0; i < g_shm->num_products; i++)
-        total_items += g_cart[i];
+    for (int k = 0; k < g_cart_lines; k++)
+        total_items += g_cart[k].qty;
 
     if (total_items == 0) {
-        sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_lock(g_sem_id, g_shm);
         g_shm->customers_not_served++;
-        sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_unlock(g_sem_id, g_shm);
         log_msg("Koszyk pusty - opuszczam sklep bez zakupow.");
+        g_exit_reason = EXIT_EMPTY_CART;
         return 0;
     }
 
     /* Wybierz kase z najkrotsza kolejka */
-    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_lock(g_sem_id, g_shm);
 
     int chosen_register = 0;
     if (g_shm->register_accepting[1] && g_shm->register_open[1]) {
@@ -268,9 +297,9 @@ static int do_checkout(void)
     }
     g_shm->register_queue_len[chosen_register]++;
 
-    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_unlock(g_sem_id, g_shm);
 
-    log_msg("Ustawiam sie w kolejce do kasy nr %d (dlugosc: %d)",
+    log_debug("Ustawiam sie w kolejce do kasy nr %d (dlugosc: %d)",
             chosen_register + 1,
             g_shm->register_queue_len[chosen_register]);
 
@@ -278,10 +307,14 @@ static int do_checkout(void)
     struct checkout_msg cmsg;
     cmsg.mtype = chosen_register + 1;
     cmsg.customer_pid = getpid();
-    memcpy(cmsg.items, g_cart, sizeof(g_cart));
+    cmsg.num_lines = g_cart_lines;
+    memcpy(cmsg.lines, g_cart, g_cart_lines * sizeof(BasketLine));
+    cmsg.sent_ns = hist_now_ns();
 
-    if (msgsnd_guarded(g_mq_checkout, &cmsg, sizeof(cmsg) - sizeof(long),
-                       g_sem_id, SEM_GUARD_CHKOUT(g_shm->num_products)) == -1) {
+    JOURNAL(EV_CUST_CHECKOUT, getpid(), 0, chosen_register, total_items, 0);
+    g_exit_reason = EXIT_NO_RECEIPT; /* Do czasu odebrania paragonu */
+
+    if (g_ipc->checkout_send(&cmsg) == -1) {
         if (errno == EINTR || errno == EIDRM || errno == EINVAL) return -1;
         handle_warning("msgsnd (checkout)");
         return -1;
@@ -295,17 +328,17 @@ static int do_checkout(void)
 
     while (!g_evacuation && !g_terminate && wait_cycles < max_wait) {
         /* Odbiór bez strażnika - kasjer wysyła z IPC_NOWAIT (plain msgsnd) */
-        ssize_t ret = msgrcv(g_mq_receipt, &rmsg,
-                             sizeof(rmsg) - sizeof(long),
-                             (long)getpid(), IPC_NOWAIT);
-
-        if (ret >= 0) {
+        if (g_ipc->receipt_take(getpid(), &rmsg) == 0) {
             /* Otrzymano paragon! */
-            sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+            hist_record_since(&g_hist[HIST_RECEIPT], rmsg.sent_ns, hist_now_ns());
+            shm_lock(g_sem_id, g_shm);
             g_shm->customers_served++;
-            sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+            shm_unlock(g_sem_id, g_shm);
+            JOURNAL(EV_CUST_RECEIPT, getpid(), 0,
+                    (int)rmsg.total_gr, total_items, 0);
             log_msg_color(C_GREEN,
-                "Paragon: %d produktow, RAZEM: %.2f PLN", total_items, rmsg.total);
+                "Paragon: %d produktow, RAZEM: %.2f PLN", total_items, rmsg.total_gr / 100.0);
+            g_exit_reason = EXIT_SERVED;
             return 0;
         }
 
@@ -326,23 +359,25 @@ static int do_checkout(void)
     /* Ostatnia proba odebrania paragonu - mogl dojsc w ostatniej chwili */
     {
         struct receipt_msg drain;
-        ssize_t dret = msgrcv(g_mq_receipt, &drain,
-                              sizeof(drain) - sizeof(long),
-                              (long)getpid(), IPC_NOWAIT);
-        if (dret >= 0) {
-            sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        if (g_ipc->receipt_take(getpid(), &drain) == 0) {
+            hist_record_since(&g_hist[HIST_RECEIPT], drain.sent_ns, hist_now_ns());
+            shm_lock(g_sem_id, g_shm);
             g_shm->customers_served++;
-            sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+            shm_unlock(g_sem_id, g_shm);
+            JOURNAL(EV_CUST_RECEIPT, getpid(), 0,
+                    (int)drain.total_gr, total_items, 0);
             log_msg_color(C_GREEN,
-                "Paragon: %d produktow, RAZEM: %.2f PLN", total_items, drain.total);
+                "Paragon: %d produktow, RAZEM: %.2f PLN", total_items, drain.total_gr / 100.0);
+            g_exit_reason = EXIT_SERVED;
             return 0;
         }
     }
 
-    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_lock(g_sem_id, g_shm);
     g_shm->customers_not_served++;
-    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
-    log_msg("Timeout czekania na paragon - opuszczam sklep.");
+    shm_unlock(g_sem_id, g_shm);
+    log_warn("Timeout czekania na paragon - opuszczam sklep.");
+    g_exit_reason = EXIT_NO_RECEIPT;
     return -1;
 }
 
@@ -354,111 +389,112 @@ int main(int argc, char *argv[])
 {
     /* --- Parsowanie argumentow --- */
     if (argc < 2) {
-        fprintf(stderr, "Uzycie: klient <keyfile>\n");
+        fprintf(stderr, "Uzycie: klient <keyfile> [numer_klienta]\n");
         return EXIT_FAILURE;
     }
 
     const char *keyfile = argv[1];
-
-    srand(time(NULL) ^ getpid());
+    g_start_ns = hist_now_ns();
 
     /* --- Dolaczenie do zasobow IPC --- */
-    g_shm = attach_shared_memory(keyfile);
+    g_shm = attach_child_ipc(keyfile, &g_sem_id);
 
-    int num_sems = TOTAL_SEMS(g_shm->num_products);
-    g_sem_id = get_semaphores(keyfile, num_sems);
+    /* Strumien losowania wg numeru porzadkowego (nie PID) - ten sam -S
+     * daje klientowi nr k te sama liste zakupow */
+    long ordinal = (argc >= 3) ? atol(argv[2]) : (long)getpid();
+    rng_seed(&g_rng, g_shm->seed, RNG_STREAM_CUSTOMER, (uint64_t)ordinal);
 
-    g_mq_conveyor = get_message_queue(keyfile, PROJ_MQ_CONV);
-    g_mq_checkout = get_message_queue(keyfile, PROJ_MQ_CHKOUT);
-    g_mq_receipt  = get_message_queue(keyfile, PROJ_MQ_RCPT);
+    g_ipc = ipc_backend_get(g_shm->ipc_backend);
+    g_ipc->attach(g_shm, keyfile, g_sem_id);
 
     /* --- Logger --- */
     logger_init(g_shm, PROC_CUSTOMER, getpid());
+    journal_attach(g_shm, JOURNAL_FILE, PROC_CUSTOMER);
+    hist_record_since(&g_hist[HIST_STARTUP], g_start_ns, hist_now_ns());
 
     /* --- Sygnaly --- */
     setup_signals();
 
     /* --- Generuj liste zakupow --- */
-    int shopping_list[MAX_PRODUCTS];
-    generate_shopping_list(shopping_list);
-
-    /* Wyswietl liste zakupow */
-    log_msg("Przyszedl do sklepu. Lista zakupow:");
-    for (int i = 0; i < g_shm->num_products; i++) {
-        if (shopping_list[i] > 0) {
-            log_msg("  - %s: %d szt.", g_shm->products[i].name, shopping_list[i]);
-        }
+    BasketLine shopping_list[MAX_BASKET_LINES];
+    int shopping_lines = generate_shopping_list(shopping_list);
+
+    /* Wyswietl liste zakupow (tylko na poziomie debug - petla tez znika) */
+    if (log_enabled(LOG_LVL_DEBUG)) {
+        log_debug("Przyszedl do sklepu (klient nr %ld). Lista zakupow:", ordinal);
+        for (int k = 0; k < shopping_lines; k++)
+            log_debug("  - %s: %d szt.", shm_products(g_shm)[shopping_list[k].product_id].name,
+                      shopping_list[k].qty);
     }
 
     /* --- Wejscie do sklepu (semafor zliczajacy) --- */
     if (!g_shm->shop_open || g_shm->evacuation_mode) {
-        sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_lock(g_sem_id, g_shm);
         g_shm->customers_not_served++;
-        sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_unlock(g_sem_id, g_shm);
         log_msg("Sklep zamkniety - odchodzi.");
-        detach_shared_memory(g_shm);
-        return EXIT_SUCCESS;
+        return finish_visit(EXIT_SHOP_CLOSED);
     }
 
-    log_msg("Czeka na wejscie do sklepu...");
+    log_debug("Czeka na wejscie do sklepu...");
+    JOURNAL(EV_CUST_ENTRY_WAIT, getpid(), 0, 0, 0, 0);
+    uint64_t entry_from = hist_now_ns();
 
     /* Proba wejscia z timeoutem - nie czekaj w nieskonczonosc */
     int entry_attempts = 0;
     while (entry_attempts < 5000) {
         if (g_evacuation || g_terminate || !g_shm->shop_open) {
             log_msg("Sklep zamkniety/ewakuacja - odchodzi.");
-            detach_shared_memory(g_shm);
-            return EXIT_SUCCESS;
+            return finish_visit(g_evacuation ? EXIT_EVACUATION : EXIT_SHOP_CLOSED);
         }
 
-        if (sem_trywait_undo(g_sem_id, SEM_SHOP_ENTRY) == 0) {
+        if (g_ipc->admission_try() == 0) {
             break; /* Udalo sie wejsc */
         }
 
-        /* Sklep pelny - czekaj */
-        usleep(g_shm->time_scale_ms * 1000);
+        /* Sklep pelny - czekaj do nastepnego tykniecia zegara */
+        wait_until_tick(g_shm, sim_tick_now(g_shm) + 1);
         entry_attempts++;
     }
 
     if (entry_attempts >= 5000) {
-        sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_lock(g_sem_id, g_shm);
         g_shm->customers_not_served++;
-        sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
-        log_msg("Czekanie zbyt dlugie - odchodzi.");
-        detach_shared_memory(g_shm);
-        return EXIT_SUCCESS;
+        shm_unlock(g_sem_id, g_shm);
+        log_warn("Czekanie zbyt dlugie - odchodzi.");
+        return finish_visit(EXIT_ENTRY_TIMEOUT);
     }
 
     /* Klient wszedl do sklepu */
     g_in_shop = 1;
-    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_lock(g_sem_id, g_shm);
     g_shm->customers_in_shop++;
-    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+    shm_unlock(g_sem_id, g_shm);
+    JOURNAL(EV_CUST_ENTER, getpid(), 0, 0, 0, 0);
+    hist_record_since(&g_hist[HIST_ENTRY_WAIT], entry_from, hist_now_ns());
 
-    log_msg("Wszedl do sklepu (klientow w srodku: %d/%d)",
+    log_debug("Wszedl do sklepu (klientow w srodku: %d/%d)",
             g_shm->customers_in_shop, g_shm->max_customers);
 
     /* --- Sprawdz ewakuacje --- */
     if (g_evacuation) {
-        sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_lock(g_sem_id, g_shm);
         g_shm->customers_not_served++;
-        sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_unlock(g_sem_id, g_shm);
         handle_evacuation();
-        detach_shared_memory(g_shm);
-        return EXIT_SUCCESS;
+        return finish_visit(EXIT_EVACUATION);
     }
 
     /* --- Zakupy --- */
-    do_shopping(shopping_list);
+    do_shopping(shopping_list, shopping_lines);
 
     /* --- Sprawdz ewakuacje po zakupach --- */
     if (g_evacuation) {
-        sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_lock(g_sem_id, g_shm);
         g_shm->customers_not_served++;
-        sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_unlock(g_sem_id, g_shm);
         handle_evacuation();
-        detach_shared_memory(g_shm);
-        return EXIT_SUCCESS;
+        return finish_visit(EXIT_EVACUATION);
     }
 
     /* --- Kasa --- */
@@ -466,19 +502,16 @@ int main(int argc, char *argv[])
 
     /* --- Sprawdz ewakuacje po kasie --- */
     if (g_evacuation && checkout_result != 0) {
-        sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_lock(g_sem_id, g_shm);
         g_shm->customers_not_served++;
-        sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+        shm_unlock(g_sem_id, g_shm);
         handle_evacuation();
-        detach_shared_memory(g_shm);
-        return EXIT_SUCCESS;
+        return finish_visit(EXIT_EVACUATION);
     }
 
     /* --- Opuszczenie sklepu --- */
     leave_shop();
 
     /* --- Sprzatanie --- */
-    detach_shared_memory(g_shm);
-
-    return EXIT_SUCCESS;
+    return finish_visit(g_exit_reason);
 }
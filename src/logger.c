@@ -7,13 +7,28 @@
  */
 
 #include "logger.h"
+#include "seqlock.h"
 #include <stdarg.h>
+#include <strings.h>
+
+/* Prog domyslny - obowiazuje zanim logger_init() podepnie SHM */
+static const int g_default_level = LOG_LVL_INFO;
+const volatile int *g_log_level  = &g_default_level;
 
 /* Zmienne globalne modulu - ustawiane raz przez logger_init() */
 static SharedData *g_shm      = NULL;
 static ProcessType g_proc_type = PROC_MANAGER;
 static int         g_proc_id   = 0;
 static FILE       *g_log_file  = NULL;
+static char        g_name[32]  = "KIEROWNIK"; /* Etykieta procesu (liczona raz) */
+
+static const char *const LEVEL_NAMES[] = {
+    "error", "warn", "info", "debug", "trace"
+};
+
+static const char *const PROC_TYPE_NAMES[NUM_PROC_TYPES] = {
+    "kierownik", "piekarz", "kasjer", "klient"
+};
 
 /*
  * logger_init - Inicjalizacja loggera.
@@ -26,6 +41,15 @@ void logger_init(SharedData *shm, ProcessType type, int id)
     g_proc_type = type;
     g_proc_id   = id;
 
+    /* Etykieta procesu nie zmienia sie - liczymy ja raz, nie przy kazdej linii */
+    snprintf(g_name, sizeof(g_name), "%s", get_process_name(type, id));
+
+    /* Prog logowania czytany wprost z SHM - zmiana przez FIFO dziala od razu */
+    if (shm != NULL && type >= 0 && type < NUM_PROC_TYPES)
+        g_log_level = &shm->log_level[type];
+    else
+        g_log_level = &g_default_level;
+
     /* Zamknij poprzedni plik jesli byl otwarty (np. ponowne wywolanie) */
     if (g_log_file != NULL) {
         fclose(g_log_file);
@@ -84,27 +108,23 @@ const char *get_process_name(ProcessType type, int id)
 }
 
 /*
- * log_msg - Loguje komunikat na terminal z kolorami i czasem symulacji.
+ * log_write - Loguje komunikat na terminal z kolorami i czasem symulacji.
  * Format: [HH:MM] [ETYKIETA] komunikat
  *
+ * Prog poziomu sprawdzaja makra log_* zanim wyliczone zostana argumenty.
  * Uzywa flockfile/funlockfile dla ochrony wyjscia na konsole
  * w srodowisku wieloprocesowym.
  */
-void log_msg(const char *fmt, ...)
+void log_write(const char *color, const char *fmt, ...)
 {
     /* Po zamknieciu symulacji loguje tylko kierownik */
     if (g_shm != NULL && !g_shm->simulation_running &&
         g_proc_type != PROC_MANAGER)
         return;
 
-    const char *color = get_process_color(g_proc_type);
-    const char *name  = get_process_name(g_proc_type, g_proc_id);
-
     int hour = 0, min = 0;
-    if (g_shm != NULL) {
-        hour = g_shm->sim_hour;
-        min  = g_shm->sim_min;
-    }
+    if (g_shm != NULL)
+        shm_read_clock(g_shm, &hour, &min);
 
     /* Budowanie pelnego komunikatu */
     char msg_buf[512];
@@ -113,12 +133,18 @@ void log_msg(const char *fmt, ...)
     vsnprintf(msg_buf, sizeof(msg_buf), fmt, args);
     va_end(args);
 
-    /* Atomowe wypisanie na stdout */
+    /* Atomowe wypisanie na stdout (kolor nadpisany obejmuje cala tresc) */
     flockfile(stdout);
-    fprintf(stdout, "%s[%02d:%02d]%s %s[%-12s]%s %s\n",
-            C_GRAY, hour, min, C_RESET,
-            color, name, C_RESET,
-            msg_buf);
+    if (color == NULL) {
+        fprintf(stdout, "%s[%02d:%02d]%s %s[%-12s]%s %s\n",
+                C_GRAY, hour, min, C_RESET,
+                get_process_color(g_proc_type), g_name, C_RESET,
+                msg_buf);
+    } else {
+        fprintf(stdout, "%s[%02d:%02d]%s %s[%-12s] %s%s\n",
+                C_GRAY, hour, min, C_RESET,
+                color, g_name, msg_buf, C_RESET);
+    }
     fflush(stdout);
     funlockfile(stdout);
 
@@ -126,50 +152,85 @@ void log_msg(const char *fmt, ...)
     if (g_log_file != NULL) {
         flockfile(g_log_file);
         fprintf(g_log_file, "[%02d:%02d] [%-12s] %s\n",
-                hour, min, name, msg_buf);
+                hour, min, g_name, msg_buf);
         fflush(g_log_file);
         funlockfile(g_log_file);
     }
 }
 
 /*
- * log_msg_color - Loguje komunikat z nadpisanym kolorem.
- * Przydatne do wyroznienia waznych zdarzen (np. bledy, sygnaly).
+ * log_parse_level - Nazwa poziomu (lub cyfra 0-4) -> LogLevel.
  */
-void log_msg_color(const char *color, const char *fmt, ...)
+int log_parse_level(const char *name)
 {
-    /* Po zamknieciu symulacji loguje tylko kierownik */
-    if (g_shm != NULL && !g_shm->simulation_running &&
-        g_proc_type != PROC_MANAGER)
-        return;
+    if (name == NULL || *name == '\0')
+        return -1;
 
-    const char *name = get_process_name(g_proc_type, g_proc_id);
+    if (name[0] >= '0' && name[0] <= '4' && name[1] == '\0')
+        return name[0] - '0';
 
-    int hour = 0, min = 0;
-    if (g_shm != NULL) {
-        hour = g_shm->sim_hour;
-        min  = g_shm->sim_min;
+    for (int i = 0; i <= LOG_LVL_TRACE; i++) {
+        if (strcasecmp(name, LEVEL_NAMES[i]) == 0)
+            return i;
     }
+    return -1;
+}
 
-    char msg_buf[512];
-    va_list args;
-    va_start(args, fmt);
-    vsnprintf(msg_buf, sizeof(msg_buf), fmt, args);
-    va_end(args);
-
-    flockfile(stdout);
-    fprintf(stdout, "%s[%02d:%02d]%s %s[%-12s] %s%s\n",
-            C_GRAY, hour, min, C_RESET,
-            color, name, msg_buf, C_RESET);
-    fflush(stdout);
-    funlockfile(stdout);
+/*
+ * log_level_name - LogLevel -> nazwa.
+ */
+const char *log_level_name(int lvl)
+{
+    if (lvl < LOG_LVL_ERROR || lvl > LOG_LVL_TRACE)
+        return "?";
+    return LEVEL_NAMES[lvl];
+}
 
-    /* Zapis do pliku (bez kolorow) */
-    if (g_log_file != NULL) {
-        flockfile(g_log_file);
-        fprintf(g_log_file, "[%02d:%02d] [%-12s] %s\n",
-                hour, min, name, msg_buf);
-        fflush(g_log_file);
-        funlockfile(g_log_file);
+/*
+ * log_apply_spec - Ustawia progi wg "poziom" lub "typ=poziom,typ=poziom".
+ * Najpierw waliduje cala specyfikacje, potem zapisuje - blad nic nie zmienia.
+ */
+int log_apply_spec(SharedData *shm, const char *spec)
+{
+    if (shm == NULL || spec == NULL)
+        return -1;
+
+    int levels[NUM_PROC_TYPES];
+    for (int t = 0; t < NUM_PROC_TYPES; t++)
+        levels[t] = shm->log_level[t];
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    char *save = NULL;
+    for (char *tok = strtok_r(buf, ",", &save); tok != NULL;
+         tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        if (eq == NULL) {
+            /* Sam poziom - dotyczy wszystkich typow procesow */
+            int lvl = log_parse_level(tok);
+            if (lvl < 0) return -1;
+            for (int t = 0; t < NUM_PROC_TYPES; t++)
+                levels[t] = lvl;
+            continue;
+        }
+
+        *eq = '\0';
+        int lvl = log_parse_level(eq + 1);
+        if (lvl < 0) return -1;
+
+        int type = -1;
+        for (int t = 0; t < NUM_PROC_TYPES; t++) {
+            if (strcasecmp(tok, PROC_TYPE_NAMES[t]) == 0) {
+                type = t;
+                break;
+            }
+        }
+        if (type < 0) return -1;
+        levels[type] = lvl;
     }
+
+    for (int t = 0; t < NUM_PROC_TYPES; t++)
+        shm->log_level[t] = levels[t];
+    return 0;
 }
@@ -3,6 +3,12 @@
  * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
  *
  * Kolorowe logowanie z synchronizowanym czasem symulacji.
+ *
+ * Poziomy logowania (error/warn/info/debug/trace) sa ustawiane osobno
+ * dla kazdego typu procesu (SharedData.log_level[]) - z linii polecen
+ * kierownika (-L) lub w trakcie dzialania przez FIFO ("log ...").
+ * Wylaczony poziom kosztuje jedno porownanie: makra nie wyliczaja
+ * argumentow. Poziomy powyzej LOG_COMPILE_LEVEL sa usuwane przez kompilator.
  */
 
 #ifndef LOGGER_H
@@ -10,26 +16,79 @@
 
 #include "common.h"
 
+/**
+ * Prog kompilacji - wywolania powyzej tego poziomu znikaja z kodu.
+ * Nadpisywany z Makefile: make LOG_COMPILE_LEVEL=LOG_LVL_TRACE
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LVL_DEBUG
+#endif
+
+/**
+ * Aktualny prog runtime biezacego procesu.
+ * Po logger_init() wskazuje na SharedData.log_level[typ_procesu].
+ */
+extern const volatile int *g_log_level;
+
+/** Czy poziom lvl jest wlaczony (stala kompilacji + jeden odczyt z SHM). */
+#define log_enabled(lvl) \
+    ((lvl) <= LOG_COMPILE_LEVEL && (lvl) <= *g_log_level)
+
+/** Loguje na poziomie lvl; przy wylaczonym poziomie nie wylicza argumentow. */
+#define log_at(lvl, color, ...) \
+    do { if (log_enabled(lvl)) log_write((color), __VA_ARGS__); } while (0)
+
+#define log_error(...) log_at(LOG_LVL_ERROR, C_RED,    __VA_ARGS__)
+#define log_warn(...)  log_at(LOG_LVL_WARN,  C_YELLOW, __VA_ARGS__)
+#define log_info(...)  log_at(LOG_LVL_INFO,  NULL,     __VA_ARGS__)
+#define log_debug(...) log_at(LOG_LVL_DEBUG, NULL,     __VA_ARGS__)
+#define log_trace(...) log_at(LOG_LVL_TRACE, C_GRAY,   __VA_ARGS__)
+
+/**
+ * Loguje komunikat z kolorami i znacznikiem czasu symulacji (poziom info).
+ * Format: [HH:MM] [NAZWA_PROCESU] komunikat
+ */
+#define log_msg(...) log_info(__VA_ARGS__)
+
+/**
+ * Loguje komunikat z konkretnym kolorem (poziom info, nadpisuje domyslny).
+ */
+#define log_msg_color(color, ...) log_at(LOG_LVL_INFO, (color), __VA_ARGS__)
+
 /**
  * Inicjalizuje logger - ustawia wskaznik do pamieci dzielonej.
- * @param shm   Wskaznik do pamieci dzielonej (zegar symulacji)
- * @param type  Typ procesu (dla kolorow)
+ * @param shm   Wskaznik do pamieci dzielonej (zegar symulacji, poziomy)
+ * @param type  Typ procesu (dla kolorow i progu logowania)
  * @param id    Identyfikator procesu (np. numer kasy, PID klienta)
  */
 void logger_init(SharedData *shm, ProcessType type, int id);
 
 /**
- * Loguje komunikat z kolorami i znacznikiem czasu symulacji.
- * Format: [HH:MM] [NAZWA_PROCESU] komunikat
- * @param fmt Format printf
- * @param ... Argumenty
+ * Wypisuje komunikat (nie sprawdza progu - robia to makra log_*).
+ * @param color Kolor ANSI lub NULL (kolor procesu)
+ * @param fmt   Format printf
+ */
+void log_write(const char *color, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Zamienia nazwe poziomu ("error".."trace" lub cyfre 0-4) na LogLevel.
+ * @return Poziom lub -1 jesli nazwa nieznana
+ */
+int log_parse_level(const char *name);
+
+/**
+ * Zwraca nazwe poziomu logowania.
  */
-void log_msg(const char *fmt, ...);
+const char *log_level_name(int lvl);
 
 /**
- * Loguje komunikat z konkretnym kolorem (nadpisuje domyslny).
+ * Ustawia poziomy logowania w SHM wedlug specyfikacji.
+ * Format: "poziom" (wszystkie procesy) lub "typ=poziom[,typ=poziom...]",
+ * gdzie typ to kierownik/piekarz/kasjer/klient.
+ * @return 0 przy sukcesie, -1 przy blednej specyfikacji (nic nie zmienia)
  */
-void log_msg_color(const char *color, const char *fmt, ...);
+int log_apply_spec(SharedData *shm, const char *spec);
 
 /**
  * Zwraca nazwe procesu jako string.
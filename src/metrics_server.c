@@ -0,0 +1,327 @@
+/**
+ * @file metrics_server.c
+ * @brief Serwer metryk w formacie Prometheus (text exposition 0.0.4).
+ *
+ * Dolacza sie do SHM tylko do odczytu (jak check_shm) i na kazde
+ * polaczenie na gniezdzie UNIX odpowiada minimalnym HTTP/1.0 z aktualnym
+ * stanem: liczniki, gauge kolejek i podajnikow, wartosci semaforow oraz
+ * liczby czekajacych (GETNCNT/GETZCNT) i histogramy opoznien faz.
+ * Nie bierze SEM_SHM_MUTEX - liczniki stanu czytane sa jako spojna
+ * migawka przez seqlock (seqlock.h).
+ *
+ * Uzycie: ./metrics_server [-k key_file] [-u gniazdo] [-1]
+ *   -1  wypisz metryki raz na stdout i zakoncz (bez gniazda)
+ * Przyklad: curl --unix-socket /tmp/ciastkarnia_metrics.sock http://x/metrics
+ *
+ * Konczy sie po SIGINT/SIGTERM albo gdy segment SHM zostanie usuniety.
+ */
+
+#include "common.h"
+#include "histogram.h"
+#include "seqlock.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void stop_handler(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+/* ================================================================
+ *  METRYKI
+ * ================================================================ */
+
+/* Nazwa semafora o indeksie i (etykieta "sem") */
+static void sem_label(char *buf, size_t size, int i, int num_products)
+{
+    if (i == SEM_SHM_MUTEX)                       snprintf(buf, size, "shm_mutex");
+    else if (i == SEM_SHOP_ENTRY)                 snprintf(buf, size, "shop_entry");
+    else if (i < SEM_CONVEYOR_BASE + num_products) snprintf(buf, size, "conveyor_%d",
+                                                            i - SEM_CONVEYOR_BASE);
+    else if (i == SEM_GUARD_CONV(num_products))   snprintf(buf, size, "guard_conveyor");
+    else if (i == SEM_GUARD_CHKOUT(num_products)) snprintf(buf, size, "guard_checkout");
+    else if (i == SEM_GUARD_RCPT(num_products))   snprintf(buf, size, "guard_receipt");
+    else if (i < SEM_GUARD_CONV_PROD(num_products, num_products))
+        snprintf(buf, size, "guard_conveyor_%d", i - SEM_GUARD_CONV_PROD(num_products, 0));
+    else if (i < SEM_GUARD_CHKOUT_REG(num_products, NUM_REGISTERS))
+        snprintf(buf, size, "guard_checkout_%d", i - SEM_GUARD_CHKOUT_REG(num_products, 0));
+    else                                          snprintf(buf, size, "sem_%d", i);
+}
+
+static void metric_head(FILE *f, const char *name, const char *type, const char *help)
+{
+    fprintf(f, "# HELP ciastkarnia_%s %s\n# TYPE ciastkarnia_%s %s\n",
+            name, help, name, type);
+}
+
+/* Pojedyncza wartosc bez etykiet */
+static void metric(FILE *f, const char *name, const char *type,
+                   const char *help, double value)
+{
+    metric_head(f, name, type, help);
+    fprintf(f, "ciastkarnia_%s %.17g\n", name, value);
+}
+
+/*
+ * write_metrics - Zapisuje wszystkie metryki do strumienia.
+ * Kubelki histogramow: granice na potegach dwojki (us), w sekundach.
+ */
+static void write_metrics(FILE *f, const SharedData *shm, int sem_id)
+{
+    int np = shm->num_products;
+    if (np < 0 || np > MAX_PRODUCTS) np = 0;
+
+    /* Spojna migawka licznikow i zegara (seqlock); bufor o ukladzie
+     * segmentu alokowany przy pierwszym zapytaniu */
+    static SharedData *snap = NULL;
+    if (snap == NULL && (snap = shm_snapshot_new(shm)) == NULL)
+        return;
+    const SharedData *st = snap;
+    int hour, min;
+    shm_read_state(shm, snap);
+    shm_read_clock(shm, &hour, &min);
+
+    /* --- Liczniki --- */
+    metric(f, "customers_entered_total", "counter",
+           "Klienci utworzeni przez kierownika", st->total_customers_entered);
+    metric(f, "customers_served_total", "counter",
+           "Klienci obsluzeni (paragon)", st->customers_served);
+    metric(f, "customers_not_served_total", "counter",
+           "Klienci nieobsluzeni", st->customers_not_served);
+    metric(f, "journal_records_total", "counter",
+           "Zarezerwowane sloty dziennika zdarzen",
+           (double)__atomic_load_n(&shm->journal_next, __ATOMIC_RELAXED));
+    metric(f, "journal_dropped_total", "counter",
+           "Zdarzenia odrzucone (dziennik pelny)",
+           (double)__atomic_load_n(&shm->journal_dropped, __ATOMIC_RELAXED));
+
+    metric_head(f, "baker_produced_total", "counter", "Wyprodukowane sztuki");
+    for (int i = 0; i < np; i++)
+        fprintf(f, "ciastkarnia_baker_produced_total{product=\"%s\"} %d\n",
+                shm_products(shm)[i].name, shm_stats(st)[i].baker_produced);
+
+    metric_head(f, "register_revenue_pln_total", "counter", "Przychod kasy (PLN)");
+    for (int r = 0; r < 2; r++)
+        fprintf(f, "ciastkarnia_register_revenue_pln_total{register=\"%d\"} %.2f\n",
+                r + 1, st->register_revenue_gr[r] / 100.0);
+
+    /* --- Gauge --- */
+    metric(f, "customers_in_shop", "gauge", "Klienci w sklepie", st->customers_in_shop);
+    metric(f, "active_customers", "gauge", "Aktywne procesy klientow",
+           st->active_customers);
+    metric(f, "max_customers", "gauge", "Limit N klientow w sklepie", shm->max_customers);
+    metric(f, "time_scale_ms", "gauge", "Skala czasu (ms na minute symulacji)",
+           shm->time_scale_ms);
+    metric(f, "baker_threads", "gauge", "Watki produkcyjne piekarza", shm->baker_threads);
+    metric(f, "shop_open", "gauge", "1 = sklep otwarty", shm->shop_open);
+    metric(f, "simulation_running", "gauge", "1 = symulacja aktywna",
+           shm->simulation_running);
+    metric(f, "sim_minute_of_day", "gauge", "Zegar symulacji (godzina*60+minuta)",
+           hour * 60 + min);
+    metric(f, "sim_ticks_total", "counter", "Tykniecia zegara kierownika (SharedData.tick)",
+           __atomic_load_n(&shm->tick, __ATOMIC_RELAXED));
+    metric(f, "tick_waiters", "gauge", "Procesy uspione w wait_until_tick()",
+           __atomic_load_n(&shm->tick_waiters, __ATOMIC_RELAXED));
+
+    metric_head(f, "register_queue_length", "gauge", "Dlugosc kolejki do kasy");
+    for (int r = 0; r < 2; r++)
+        fprintf(f, "ciastkarnia_register_queue_length{register=\"%d\"} %d\n",
+                r + 1, st->register_queue_len[r]);
+    metric_head(f, "register_open", "gauge", "1 = kasa obsadzona");
+    for (int r = 0; r < 2; r++)
+        fprintf(f, "ciastkarnia_register_open{register=\"%d\"} %d\n",
+                r + 1, st->register_open[r]);
+
+    /* --- Semafory: wartosci (GETALL) i czekajacy (GETNCNT/GETZCNT) --- */
+    if (sem_id != -1) {
+        struct semid_ds ds;
+        union semun { int val; struct semid_ds *buf; unsigned short *array; } arg;
+        arg.buf = &ds;
+        if (semctl(sem_id, 0, IPC_STAT, arg) != -1 && ds.sem_nsems > 0) {
+            int ns = (int)ds.sem_nsems;
+            unsigned short vals[ns];
+            arg.array = vals;
+            if (semctl(sem_id, 0, GETALL, arg) != -1) {
+                char name[32];
+
+                metric_head(f, "conveyor_fill", "gauge", "Sztuki na podajniku");
+                for (int i = 0; i < np && SEM_CONVEYOR_BASE + i < ns; i++)
+                    fprintf(f, "ciastkarnia_conveyor_fill{product=\"%s\"} %d\n",
+                            shm_products(shm)[i].name,
+                            shm_products(shm)[i].conveyor_capacity
+                                - vals[SEM_CONVEYOR_BASE + i]);
+                metric_head(f, "conveyor_capacity", "gauge", "Pojemnosc podajnika");
+                for (int i = 0; i < np; i++)
+                    fprintf(f, "ciastkarnia_conveyor_capacity{product=\"%s\"} %d\n",
+                            shm_products(shm)[i].name, shm_products(shm)[i].conveyor_capacity);
+
+                metric_head(f, "semaphore_value", "gauge", "Wartosc semafora");
+                for (int i = 0; i < ns; i++) {
+                    sem_label(name, sizeof(name), i, np);
+                    fprintf(f, "ciastkarnia_semaphore_value{sem=\"%s\"} %d\n",
+                            name, vals[i]);
+                }
+                metric_head(f, "semaphore_waiters", "gauge",
+                            "Procesy czekajace na semaforze (ncnt: na wzrost, zcnt: na zero)");
+                for (int i = 0; i < ns; i++) {
+                    sem_label(name, sizeof(name), i, np);
+                    fprintf(f, "ciastkarnia_semaphore_waiters{sem=\"%s\",kind=\"ncnt\"} %d\n",
+                            name, semctl(sem_id, i, GETNCNT));
+                    fprintf(f, "ciastkarnia_semaphore_waiters{sem=\"%s\",kind=\"zcnt\"} %d\n",
+                            name, semctl(sem_id, i, GETZCNT));
+                }
+            }
+        }
+    }
+
+    /* --- Histogramy opoznien faz wizyty --- */
+    metric_head(f, "phase_latency_seconds", "histogram", "Opoznienia faz wizyty klienta");
+    for (int h = 0; h < HIST_COUNT; h++) {
+        const LatencyHist *lh = &shm->hist[h];
+        uint64_t count = __atomic_load_n(&lh->count, __ATOMIC_ACQUIRE);
+        for (int k = HIST_SUB_BITS; k <= HIST_MAX_BITS; k++) {
+            uint64_t limit = (1ULL << k) - 1;
+            uint64_t n = hist_count_le(lh, limit);
+            if (n > count) n = count;
+            fprintf(f, "ciastkarnia_phase_latency_seconds_bucket{phase=\"%s\",le=\"%.9g\"} %llu\n",
+                    hist_name(h), (double)(1ULL << k) / 1e6, (unsigned long long)n);
+        }
+        fprintf(f, "ciastkarnia_phase_latency_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %llu\n",
+                hist_name(h), (unsigned long long)count);
+        fprintf(f, "ciastkarnia_phase_latency_seconds_sum{phase=\"%s\"} %.6f\n",
+                hist_name(h), __atomic_load_n(&lh->sum_us, __ATOMIC_RELAXED) / 1e6);
+        fprintf(f, "ciastkarnia_phase_latency_seconds_count{phase=\"%s\"} %llu\n",
+                hist_name(h), (unsigned long long)count);
+    }
+}
+
+/* ================================================================
+ *  SERWER HTTP NA GNIEZDZIE UNIX
+ * ================================================================ */
+
+/*
+ * serve_client - Odczytuje zadanie (tresc ignorowana) i wysyla metryki.
+ */
+static void serve_client(int fd, const SharedData *shm, int sem_id)
+{
+    char req[1024];
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    if (poll(&pfd, 1, 1000) > 0)
+        (void)read(fd, req, sizeof(req));
+
+    char *body = NULL;
+    size_t body_len = 0;
+    FILE *f = open_memstream(&body, &body_len);
+    if (f == NULL) return;
+    write_metrics(f, shm, sem_id);
+    fclose(f);
+
+    char head[160];
+    int hl = snprintf(head, sizeof(head),
+                      "HTTP/1.0 200 OK\r\n"
+                      "Content-Type: text/plain; version=0.0.4\r\n"
+                      "Content-Length: %zu\r\n\r\n", body_len);
+    if (write(fd, head, hl) == hl) {
+        size_t off = 0;
+        while (off < body_len) {
+            ssize_t w = write(fd, body + off, body_len - off);
+            if (w <= 0) break;
+            off += (size_t)w;
+        }
+    }
+    free(body);
+}
+
+/* Czy segment nadal istnieje i nie jest oznaczony do usuniecia */
+static int shm_alive(int shm_id)
+{
+    struct shmid_ds ds;
+    if (shmctl(shm_id, IPC_STAT, &ds) == -1) return 0;
+    return (ds.shm_perm.mode & SHM_DEST) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *key_file  = KEY_FILE;
+    const char *sock_path = METRICS_SOCK_PATH;
+    int once = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:u:1h")) != -1) {
+        switch (opt) {
+            case 'k': key_file = optarg;  break;
+            case 'u': sock_path = optarg; break;
+            case '1': once = 1;           break;
+            default:
+                fprintf(stderr, "Uzycie: %s [-k key_file] [-u gniazdo] [-1]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    /* Polacz z SHM (tylko odczyt) */
+    key_t shm_key = ftok(key_file, PROJ_SHM);
+    if (shm_key == -1) { fprintf(stderr, "ftok shm\n"); return 1; }
+
+    int shm_id = shmget(shm_key, 0, 0);
+    if (shm_id == -1) { fprintf(stderr, "shmget: nie istnieje\n"); return 1; }
+
+    SharedData *shm = (SharedData *)shmat(shm_id, NULL, SHM_RDONLY);
+    if (shm == (void *)-1) { fprintf(stderr, "shmat\n"); return 1; }
+
+    key_t sem_key = ftok(key_file, PROJ_SEM);
+    int sem_id = (sem_key != -1) ? semget(sem_key, 0, 0) : -1;
+
+    if (once) {
+        write_metrics(stdout, shm, sem_id);
+        shmdt(shm);
+        return 0;
+    }
+
+    /* Sygnaly bez SA_RESTART - przerywaja poll() */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int srv = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (srv == -1) { perror("socket"); shmdt(shm); return 1; }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", sock_path);
+    unlink(sock_path);
+
+    if (bind(srv, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+        listen(srv, 8) == -1) {
+        perror("bind/listen");
+        close(srv);
+        shmdt(shm);
+        return 1;
+    }
+    chmod(sock_path, 0660);
+    fprintf(stderr, "metrics_server: %s (PID %d)\n", sock_path, getpid());
+
+    while (!g_stop && shm_alive(shm_id)) {
+        struct pollfd pfd = { .fd = srv, .events = POLLIN };
+        if (poll(&pfd, 1, 500) <= 0)
+            continue;
+
+        int cl = accept(srv, NULL, NULL);
+        if (cl == -1) continue;
+        serve_client(cl, shm, sem_id);
+        close(cl);
+    }
+
+    close(srv);
+    unlink(sock_path);
+    shmdt(shm);
+    return 0;
+}
@@ -11,14 +11,19 @@
  * - Podajniki: kolejka komunikatow (msgsnd z mtype = product_id + 1)
  * - Stan: pamiec dzielona
  * - Pojemnosc podajnikow: semafory
- * - Raport produkcji: pipe do kierownika
+ * - Raport produkcji: pipe do kierownika (rekordy BakerRecord)
  * - Sygnaly: SIGUSR1 (inwentaryzacja), SIGUSR2 (ewakuacja), SIGTERM
  */
 
 #include "common.h"
 #include "error_handler.h"
 #include "ipc_utils.h"
+#include "ipc_channel.h"
 #include "logger.h"
+#include "journal.h"
+#include "histogram.h"
+#include "catalog.h"
+#include "rng.h"
 
 /* ================================================================
  *  ZMIENNE GLOBALNE PROCESU
@@ -26,7 +31,7 @@
 
 static SharedData *g_shm    = NULL;
 static int         g_sem_id = -1;
-static int         g_mq_conveyor = -1;
+static const IpcBackend *g_ipc   = NULL;  /* Kanaly IPC (SharedData.ipc_backend) */
 static int         g_pipe_fd = -1;   /* Pipe do kierownika (write end) */
 static int         g_item_counter = 0; /* Globalny licznik ciastek */
 
@@ -76,6 +81,25 @@ static void setup_signals(void)
     sigaction(SIGTERM, &sa, NULL);
 }
 
+/* ================================================================
+ *  PIPE DO KIEROWNIKA
+ * ================================================================ */
+
+/**
+ * Wysyla rekord produkcji jednym write() (atomowo, < PIPE_BUF).
+ * Bez pipe (g_pipe_fd < 0) lub po zamknieciu konca czytania - pomija.
+ */
+static void send_record(const BakerRecord *rec)
+{
+    if (g_pipe_fd < 0) return;
+    ssize_t n;
+    do {
+        n = write(g_pipe_fd, rec, sizeof(*rec));
+    } while (n == -1 && errno == EINTR);
+    if (n == -1 && errno != EPIPE)
+        handle_warning("write (baker pipe)");
+}
+
 /* ================================================================
  *  STRUKTURA WATKOW PRODUKCJI
  * ================================================================ */
@@ -87,12 +111,23 @@ typedef struct {
     int thread_id;          /* Numer watku */
     int product_start;      /* Indeks pierwszego produktu */
     int product_end;        /* Indeks za ostatnim produktem (exclusive) */
+    int generation;         /* Pokolenie puli (zmiana liczby watkow = nowe) */
 } BakerThreadArgs;
 
+/* Pokolenie puli watkow - watek starszego pokolenia konczy prace */
+static int g_generation = 0;
+
+/* thread_retired - pula zostala przebudowana (inna liczba watkow) */
+static int thread_retired(const BakerThreadArgs *targs)
+{
+    return __atomic_load_n(&g_generation, __ATOMIC_RELAXED) != targs->generation;
+}
+
 /**
  * Funkcja watku produkcyjnego.
  * Kazdy watek jest odpowiedzialny za produkcje podzbioru produktow.
- * Produkuje losowa ilosc losowych produktow ze swojego zakresu.
+ * Produkuje losowa ilosc losowych produktow ze swojego zakresu - produkt
+ * losowany wedlug wag popularnosci z katalogu (rowno, gdy wagi zakresu = 0).
  *
  * Demonstruje: pthread_create, pthread_mutex_lock/unlock, pthread_cond_wait
  *
@@ -107,6 +142,15 @@ static void *production_thread(void *arg)
         free(targs);
         return NULL;
     }
+    const ProductDef *products = shm_products(g_shm);
+    int range  = targs->product_end - targs->product_start;
+    int weight = catalog_weight(products, targs->product_start, targs->product_end);
+
+    /* Wlasny strumien losowania watku (rand() dzielony przez watki nie
+     * jest powtarzalny) - klucz: pokolenie puli i numer watku */
+    Rng rng;
+    rng_seed(&rng, g_shm->seed, RNG_STREAM_BAKER,
+             ((uint64_t)targs->generation << 16) | (uint64_t)tid);
 
     /* Czekaj na otwarcie piekarni (zabezpieczenie przed race condition) */
     while (!g_terminate && !g_evacuation && g_shm->simulation_running
@@ -115,25 +159,32 @@ static void *production_thread(void *arg)
     }
 
     while (!g_terminate && !g_evacuation && g_shm->bakery_open
-           && g_shm->simulation_running) {
-        int delay = (20 + rand() % 40) * g_shm->time_scale_ms / 100;
+           && g_shm->simulation_running && !thread_retired(targs)) {
+        int delay = rng_bake_delay_ms(&rng, g_shm->time_scale_ms);
         for (int d = 0; d < delay && !g_terminate && !g_evacuation
-             && g_shm->bakery_open && g_shm->simulation_running; d += 10) {
+             && g_shm->bakery_open && g_shm->simulation_running
+             && !thread_retired(targs); d += 10) {
             usleep(10 * 1000);
         }
 
         if (g_terminate || g_evacuation || !g_shm->bakery_open
-            || !g_shm->simulation_running)
+            || !g_shm->simulation_running || thread_retired(targs))
             break;
 
         /* Losowa partia produktow z zakresu tego watku */
-        int num_types = 1 + rand() % (targs->product_end - targs->product_start);
+        JOURNAL(EV_BAKE_START, getpid(), tid, 0, 0, 0);
+        int num_types = rng_range(&rng, 1, range);
         int products_made = 0;
 
         for (int t = 0; t < num_types; t++) {
             int prod_id = targs->product_start +
-                          rand() % (targs->product_end - targs->product_start);
-            int quantity = 8 + rand() % 13; /* 8-20 sztuki */
+                          (weight > 0 ? catalog_pick(products + targs->product_start,
+                                                     range, rng_below(&rng, weight))
+                                      : rng_below(&rng, range));
+            int quantity = rng_bake_batch(&rng, products[prod_id].bake_batch);
+            int placed = 0;
+            int dropped = 0;
+            uint64_t place_from = hist_now_ns();
 
             for (int q = 0; q < quantity; q++) {
                 if (g_terminate || g_evacuation || !g_shm->bakery_open
@@ -150,10 +201,9 @@ static void *production_thread(void *arg)
                     msg.item_id = ++g_item_counter;
                     pthread_mutex_unlock(&g_mutex);
 
-                    if (msgsnd_guarded(g_mq_conveyor, &msg, sizeof(msg) - sizeof(long),
-                                      g_sem_id, SEM_GUARD_CONV(g_shm->num_products)) == -1) {
-                        if (errno != EINTR)
-                            handle_warning("msgsnd (conveyor)");
+                    if (g_ipc->conveyor_put(prod_id, &msg) == -1) {
+                        if (errno != EINTR && errno != ENOMSG)
+                            handle_warning("conveyor_put");
                         /* Zwroc miejsce na podajniku */
                         sem_signal_op(g_sem_id, SEM_CONVEYOR_BASE + prod_id);
                         continue;
@@ -161,28 +211,36 @@ static void *production_thread(void *arg)
 
                     /* Aktualizuj statystyki produkcji */
                     pthread_mutex_lock(&g_mutex);
-                    sem_wait_undo(g_sem_id, SEM_SHM_MUTEX);
-                    g_shm->baker_produced[prod_id]++;
-                    sem_signal_undo(g_sem_id, SEM_SHM_MUTEX);
+                    shm_lock(g_sem_id, g_shm);
+                    shm_stats(g_shm)[prod_id].baker_produced++;
+                    shm_unlock(g_sem_id, g_shm);
                     pthread_mutex_unlock(&g_mutex);
 
                     products_made++;
+                    placed++;
+                } else {
+                    /* Podajnik pelny - pomijamy (nie blokujemy) */
+                    dropped++;
                 }
-                /* Jesli podajnik pelny - pomijamy (nie blokujemy) */
             }
+            JOURNAL(EV_BAKE_BATCH, getpid(), tid, prod_id, placed, quantity);
+
+            /* Rekord partii przez pipe do kierownika */
+            BakerRecord rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.kind       = BAKE_REC_BATCH;
+            rec.thread_id  = (uint8_t)tid;
+            rec.product_id = (uint16_t)prod_id;
+            rec.quantity   = (uint16_t)quantity;
+            rec.placed     = (uint16_t)placed;
+            rec.dropped    = (uint16_t)dropped;
+            rec.place_us   = (uint32_t)((hist_now_ns() - place_from) / 1000);
+            send_record(&rec);
         }
 
         if (products_made > 0) {
-            log_msg("Watek %d wyprodukowa partie: %d szt. ciastek",
+            log_debug("Watek %d wyprodukowal partie: %d szt. ciastek",
                     tid, products_made);
-
-            /* Wyslij informacje o partii przez pipe do kierownika */
-            if (g_pipe_fd >= 0) {
-                char pipe_buf[128];
-                int n = snprintf(pipe_buf, sizeof(pipe_buf),
-                                 "BATCH:%d:%d\n", tid, products_made);
-                write(g_pipe_fd, pipe_buf, n);
-            }
         }
     }
 
@@ -190,6 +248,99 @@ static void *production_thread(void *arg)
     return NULL;
 }
 
+/* ================================================================
+ *  PULA WATKOW PRODUKCYJNYCH
+ * ================================================================ */
+
+/* thread_range - Zakres produktow [start, end) watku i z count */
+static void thread_range(int i, int count, int p, int *start, int *end)
+{
+    *start = i * p / count;
+    *end   = (i + 1) * p / count;
+    if (*end <= *start)
+        *end = *start + 1;
+}
+
+/* guard_kick - delta na strazniku (+1: V, -1: P bez czekania) */
+static void guard_kick(int guard, int delta)
+{
+    if (delta > 0)
+        sem_signal_op(g_sem_id, guard);
+    else
+        sem_adjust_op(g_sem_id, guard, delta);
+}
+
+/**
+ * wake_guard_waiters - Budzi watki zablokowane na strazniku kolejki
+ * podajnika (backend sysv; w posix mq_timedsend konczy sie sam): jedno
+ * V na watek na kazdym strazniku z jego zakresu. Przy -Q i count > P
+ * kilka watkow dzieli straznika produktu - kazdy dostaje wlasne V.
+ * delta = -1 odbiera te same V po pthread_join.
+ */
+static void wake_guard_waiters(int count, int delta)
+{
+    int p = g_shm->num_products;
+    for (int i = 0; i < count; i++) {
+        if (!g_shm->conveyor_queues) {
+            guard_kick(SEM_GUARD_CONV(p), delta);
+            continue;
+        }
+        int start, end;
+        thread_range(i, count, p, &start, &end);
+        for (int prod = start; prod < end; prod++)
+            guard_kick(SEM_GUARD_CONV_PROD(p, prod), delta);
+    }
+}
+
+/**
+ * Uruchamia count watkow nowego pokolenia. Watek i obsluguje produkty
+ * [i*P/count, (i+1)*P/count); przy count > P zakresy sa jednoelementowe
+ * i kilka watkow dzieli ten sam podajnik.
+ * @return Liczba uruchomionych watkow (count ograniczone do 1..MAX_BAKER_THREADS)
+ */
+static int start_threads(pthread_t *threads, int count)
+{
+    int p = g_shm->num_products;
+    if (count < 1) count = 1;
+    if (count > MAX_BAKER_THREADS) count = MAX_BAKER_THREADS;
+
+    int generation = __atomic_add_fetch(&g_generation, 1, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < count; i++) {
+        BakerThreadArgs *args = malloc(sizeof(BakerThreadArgs));
+        if (!args) handle_error("malloc (baker thread args)");
+
+        args->thread_id     = i;
+        thread_range(i, count, p, &args->product_start, &args->product_end);
+        args->generation    = generation;
+
+        if (pthread_create(&threads[i], NULL, production_thread, args) != 0) {
+            handle_error("pthread_create (baker)");
+        }
+        log_msg("Watek produkcyjny %d uruchomiony (produkty %d-%d)",
+                i, args->product_start, args->product_end - 1);
+    }
+    return count;
+}
+
+/**
+ * stop_threads - Konczy pokolenie watkow i czeka na nie (pthread_join).
+ * Watek czekajacy na wyczerpanym strazniku podajnika nie zobaczylby
+ * nowego pokolenia, wiec przed join dostaje V. Przy przebudowie puli
+ * (reclaim = 1) nadmiarowe V sa po join odbierane - nadawcami sa tylko
+ * watki piekarza, wiec straznik ma je na pewno i znow liczy wolne
+ * miejsca. Przy zamknieciu (reclaim = 0) kolejki sa i tak usuwane.
+ */
+static void stop_threads(pthread_t *threads, int count, int reclaim)
+{
+    __atomic_add_fetch(&g_generation, 1, __ATOMIC_RELAXED);
+    wake_guard_waiters(count, 1);
+    for (int i = 0; i < count; i++)
+        pthread_join(threads[i], NULL);
+    if (reclaim)
+        wake_guard_waiters(count, -1);
+}
+
 /* ================================================================
  *  GLOWNA FUNKCJA PIEKARZA
  * ================================================================ */
@@ -205,18 +356,15 @@ int main(int argc, char *argv[])
     const char *keyfile = argv[1];
     g_pipe_fd = atoi(argv[2]);
 
-    srand(time(NULL) ^ getpid());
-
     /* --- Dolaczenie do zasobow IPC --- */
-    g_shm = attach_shared_memory(keyfile);
-
-    int num_sems = TOTAL_SEMS(g_shm->num_products);
-    g_sem_id = get_semaphores(keyfile, num_sems);
+    g_shm = attach_child_ipc(keyfile, &g_sem_id);
 
-    g_mq_conveyor = get_message_queue(keyfile, PROJ_MQ_CONV);
+    g_ipc = ipc_backend_get(g_shm->ipc_backend);
+    g_ipc->attach(g_shm, keyfile, g_sem_id);
 
     /* --- Logger --- */
     logger_init(g_shm, PROC_BAKER, 0);
+    journal_attach(g_shm, JOURNAL_FILE, PROC_BAKER);
 
     /* --- Sygnaly --- */
     setup_signals();
@@ -225,27 +373,11 @@ int main(int argc, char *argv[])
             getpid(), g_shm->num_products);
 
     /* --- Uruchomienie watkow produkcyjnych ---
-     * Dzielimy produkty na 2 grupy obsługiwane przez 2 watki.
+     * Liczba watkow z SHM (domyslnie 2, zmiana: "set piekarze K" w FIFO).
      * Demonstracja: pthread_create, pthread_join
      */
-    int num_threads = (g_shm->num_products >= 2) ? 2 : 1;
-    pthread_t threads[2];
-    int half = (g_shm->num_products + 1) / 2;
-
-    for (int i = 0; i < num_threads; i++) {
-        BakerThreadArgs *args = malloc(sizeof(BakerThreadArgs));
-        if (!args) handle_error("malloc (baker thread args)");
-
-        args->thread_id    = i;
-        args->product_start = (i == 0) ? 0 : half;
-        args->product_end   = (i == 0) ? half : g_shm->num_products;
-
-        if (pthread_create(&threads[i], NULL, production_thread, args) != 0) {
-            handle_error("pthread_create (baker)");
-        }
-        log_msg("Watek produkcyjny %d uruchomiony (produkty %d-%d)",
-                i, args->product_start, args->product_end - 1);
-    }
+    pthread_t threads[MAX_BAKER_THREADS];
+    int num_threads = start_threads(threads, g_shm->baker_threads);
 
     /* --- Glowna petla - czeka na sygnaly i monitoruje stan --- */
     /* Czekaj na otwarcie piekarni (zabezpieczenie przed race condition) */
@@ -256,7 +388,16 @@ int main(int argc, char *argv[])
 
     while (!g_terminate && !g_evacuation && g_shm->bakery_open
            && g_shm->simulation_running) {
-        usleep(g_shm->time_scale_ms * 1000);
+        wait_until_tick(g_shm, sim_tick_now(g_shm) + 1);
+
+        /* Nowa liczba watkow od kierownika - przebuduj pule */
+        if (g_shm->baker_threads != num_threads && !g_terminate && !g_evacuation) {
+            stop_threads(threads, num_threads, 1);
+            int old_threads = num_threads;
+            num_threads = start_threads(threads, g_shm->baker_threads);
+            log_msg_color(C_MAGENTA, "Pula watkow produkcyjnych: %d -> %d",
+                          old_threads, num_threads);
+        }
 
         if (g_inventory) {
             log_msg_color(C_MAGENTA, "Sygnal inwentaryzacji odebrany - "
@@ -272,12 +413,7 @@ int main(int argc, char *argv[])
     }
 
     /* --- Czekaj na zakonczenie watkow --- */
-    /* Obudz watki ewentualnie zablokowane na semaforze straznika kolejki */
-    for (int i = 0; i < num_threads; i++)
-        sem_signal_op(g_sem_id, SEM_GUARD_CONV(g_shm->num_products));
-    for (int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
-    }
+    stop_threads(threads, num_threads, 0);
     log_msg("Watki produkcyjne zakonczyly prace.");
 
     /* --- Wypisz podsumowanie produkcji (na stderr = plik logu) --- */
@@ -285,23 +421,26 @@ int main(int argc, char *argv[])
     int total = 0;
     for (int i = 0; i < g_shm->num_products; i++) {
         fprintf(stderr, "  %s: %d szt.\n",
-                g_shm->products[i].name, g_shm->baker_produced[i]);
-        total += g_shm->baker_produced[i];
+                shm_products(g_shm)[i].name, shm_stats(g_shm)[i].baker_produced);
+        total += shm_stats(g_shm)[i].baker_produced;
     }
     fprintf(stderr, "  RAZEM: %d szt.\n", total);
 
-    /* --- Wyslij podsumowanie przez pipe --- */
+    /* --- Rekord konca pracy przez pipe --- */
     if (g_pipe_fd >= 0) {
-        char pipe_buf[64];
-        int n = snprintf(pipe_buf, sizeof(pipe_buf), "DONE:%d\n", total);
-        write(g_pipe_fd, pipe_buf, n);
+        BakerRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.kind = BAKE_REC_DONE;
+        send_record(&rec);
         close(g_pipe_fd);
     }
 
-    /* --- Sprzatanie --- */
+    log_msg("Piekarz zakonczyl prace. PID: %d", getpid());
+
+    /* --- Sprzatanie (logger i dziennik czytaja SHM - najpierw one) --- */
     pthread_mutex_destroy(&g_mutex);
+    journal_close(0);
+    logger_init(NULL, PROC_BAKER, 0);
     detach_shared_memory(g_shm);
-
-    log_msg("Piekarz zakonczyl prace. PID: %d", getpid());
     return EXIT_SUCCESS;
 }
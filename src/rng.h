@@ -0,0 +1,128 @@
+/**
+ * rng.h - Generator liczb pseudolosowych xoshiro256** ze strumieniami
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Zamiast rand() (wspolny stan procesu, blokada w glibc, ziarno
+ * time ^ pid) kazdy uzytkownik losowania ma wlasny stan Rng. Stan jest
+ * wyprowadzany z ziarna symulacji (-S) i klucza strumienia (rodzaj +
+ * indeks: numer porzadkowy klienta, watek piekarza, przebieg DES) przez
+ * splitmix64 - ten sam seed daje to samo obciazenie niezaleznie od PID-ow
+ * i kolejnosci startu procesow.
+ *
+ * Rozklady modelu (partia i przerwa piekarza, ilosc u klienta) sa tu,
+ * zeby proces piekarza i symulacja -V losowaly tak samo.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/* Rodzaje strumieni (klucz razem z indeksem) */
+#define RNG_STREAM_CUSTOMER 1  /* indeks = numer porzadkowy klienta (1..) */
+#define RNG_STREAM_BAKER    2  /* indeks = (generacja << 16) | watek */
+#define RNG_STREAM_DES      3  /* indeks = numer przebiegu -V */
+
+/**
+ * Stan generatora - jeden na watek / proces, bez synchronizacji.
+ */
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static inline uint64_t rng_splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Stan strumienia (kind, index) ziarna seed.
+ */
+static inline void rng_seed(Rng *r, uint64_t seed, uint32_t kind, uint64_t index)
+{
+    uint64_t k = ((uint64_t)kind << 56) ^ index;
+    uint64_t x = seed ^ rng_splitmix64(&k);
+    for (int i = 0; i < 4; i++)
+        r->s[i] = rng_splitmix64(&x);
+}
+
+static inline uint64_t rng_rotl(uint64_t v, int k)
+{
+    return (v << k) | (v >> (64 - k));
+}
+
+/**
+ * Nastepna liczba 64-bitowa (xoshiro256**).
+ */
+static inline uint64_t rng_next(Rng *r)
+{
+    uint64_t *s = r->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+/**
+ * Liczba z [0, n), n > 0 - mnozenie zamiast modulo (Lemire, bez odrzucania;
+ * obciazenie rzedu n / 2^32 pomijalne dla zakresow symulacji).
+ */
+static inline int rng_below(Rng *r, uint32_t n)
+{
+    return (int)(((rng_next(r) >> 32) * (uint64_t)n) >> 32);
+}
+
+/**
+ * Liczba z [lo, hi].
+ */
+static inline int rng_range(Rng *r, int lo, int hi)
+{
+    return lo + rng_below(r, (uint32_t)(hi - lo + 1));
+}
+
+/* ================================================================
+ *  ROZKLADY MODELU
+ * ================================================================ */
+
+#define BAKE_BATCH_MIN   8    /* Partia piekarza bez wartosci w katalogu */
+#define BAKE_BATCH_MAX   20
+#define BAKE_DELAY_MIN   20   /* Przerwa miedzy partiami: setne minuty */
+#define BAKE_DELAY_MAX   59
+#define CUST_QTY_MIN     1    /* Sztuk produktu na liscie klienta */
+#define CUST_QTY_MAX     3
+
+/**
+ * Sztuk w partii: z katalogu (bake_batch > 0) albo BAKE_BATCH_MIN..MAX.
+ */
+static inline int rng_bake_batch(Rng *r, int catalog_batch)
+{
+    return catalog_batch > 0 ? catalog_batch
+                             : rng_range(r, BAKE_BATCH_MIN, BAKE_BATCH_MAX);
+}
+
+/**
+ * Przerwa przed partia w ms: 0.20-0.59 minuty symulacji przy skali
+ * time_scale_ms (ms/min).
+ */
+static inline int rng_bake_delay_ms(Rng *r, int time_scale_ms)
+{
+    return rng_range(r, BAKE_DELAY_MIN, BAKE_DELAY_MAX) * time_scale_ms / 100;
+}
+
+/**
+ * Ilosc produktu na liscie zakupow klienta.
+ */
+static inline int rng_cust_qty(Rng *r)
+{
+    return rng_range(r, CUST_QTY_MIN, CUST_QTY_MAX);
+}
+
+#endif /* RNG_H */
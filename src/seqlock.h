@@ -0,0 +1,128 @@
+/**
+ * seqlock.h - Liczniki sekwencji (seqlock) dla czytelnikow SharedData
+ * Projekt: Ciastkarnia (Temat 15) - Systemy Operacyjne
+ *
+ * Pisarz zwieksza licznik do wartosci nieparzystej, modyfikuje pola
+ * i zwieksza go ponownie do parzystej. Czytelnik kopiuje pola i ponawia
+ * kopie, jesli licznik byl nieparzysty albo zmienil sie w trakcie -
+ * dostaje spojna migawke wielu pol, nie blokujac nikogo.
+ *
+ * Pisarze stanu sa serializowani przez SEM_SHM_MUTEX (shm_lock/shm_unlock
+ * w ipc_utils.c), pisarzem zegara jest tylko kierownik.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include "common.h"
+#include <stddef.h>
+#include <sched.h>
+
+/* Limit prob czytelnika - pisarz zabity w sekcji zostawia licznik nieparzysty */
+#define SEQ_MAX_RETRIES 10000
+
+/**
+ * Poczatek zapisu. Nieparzysty licznik na wejsciu oznacza pisarza zabitego
+ * w sekcji (SEM_UNDO zwolnil mutex) - naprawiamy go do parzystego.
+ */
+static inline void seq_write_begin(uint32_t *seq)
+{
+    uint32_t s = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    if (s & 1u) s++;
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/** Koniec zapisu - licznik znow parzysty, zmiany widoczne. */
+static inline void seq_write_end(uint32_t *seq)
+{
+    uint32_t s = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELEASE);
+}
+
+/** Poczatek odczytu - zwraca licznik do porownania w seq_read_retry(). */
+static inline uint32_t seq_read_begin(const uint32_t *seq)
+{
+    return __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+}
+
+/** Czy odczyt trzeba powtorzyc (zapis w toku lub zakonczony w trakcie). */
+static inline int seq_read_retry(const uint32_t *seq, uint32_t start)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (start & 1u) || __atomic_load_n(seq, __ATOMIC_RELAXED) != start;
+}
+
+/**
+ * Kopiuje n bajtow spod src do dst jako spojna migawke.
+ * @return 0 - spojna, -1 - przekroczono SEQ_MAX_RETRIES (kopia moze byc rozdarta)
+ */
+static inline int seq_read_copy(const uint32_t *seq, void *dst,
+                                const void *src, size_t n)
+{
+    for (int i = 0; i < SEQ_MAX_RETRIES; i++) {
+        uint32_t s = seq_read_begin(seq);
+        memcpy(dst, src, n);
+        if (!seq_read_retry(seq, s))
+            return 0;
+        if ((i & 63) == 63)
+            sched_yield();
+    }
+    return -1;
+}
+
+/* Zakres bajtow bloku stanu i statystyk w SharedData */
+#define SHM_STATE_BEGIN offsetof(SharedData, customers_in_shop)
+#define SHM_STATE_END   (offsetof(SharedData, customers_not_served) + sizeof(int))
+
+/**
+ * Spojna migawka stanu sklepu i statystyk (customers_in_shop ..
+ * customers_not_served oraz liczniki produktow shm_stats) do snap -
+ * pola pod tymi samymi nazwami. snap musi miec uklad segmentu
+ * (shm_snapshot_new). Pozostale pola snap nie sa zmieniane.
+ */
+static inline int shm_read_state(const SharedData *shm, SharedData *snap)
+{
+    size_t stats = shm->num_products * sizeof(ProductStats);
+    for (int i = 0; i < SEQ_MAX_RETRIES; i++) {
+        uint32_t s = seq_read_begin(&shm->state_seq);
+        memcpy((char *)snap + SHM_STATE_BEGIN, (const char *)shm + SHM_STATE_BEGIN,
+               SHM_STATE_END - SHM_STATE_BEGIN);
+        memcpy(shm_stats(snap), shm_stats(shm), stats);
+        if (!seq_read_retry(&shm->state_seq, s))
+            return 0;
+        if ((i & 63) == 63)
+            sched_yield();
+    }
+    return -1;
+}
+
+/**
+ * Bufor na migawki shm_read_state o ukladzie segmentu shm (naglowek
+ * i katalog skopiowane raz). Zwalniany przez free().
+ * @return NULL przy braku pamieci
+ */
+static inline SharedData *shm_snapshot_new(const SharedData *shm)
+{
+    size_t size = shm_layout_size(shm->num_products);
+    SharedData *snap = malloc(size);
+    if (snap != NULL)
+        memcpy(snap, shm, size);
+    return snap;
+}
+
+/**
+ * Spojny odczyt zegara symulacji (godzina i minuta z tej samej chwili).
+ */
+static inline void shm_read_clock(const SharedData *shm, int *hour, int *min)
+{
+    for (int i = 0; i < SEQ_MAX_RETRIES; i++) {
+        uint32_t s = seq_read_begin(&shm->clock_seq);
+        *hour = shm->sim_hour;
+        *min  = shm->sim_min;
+        if (!seq_read_retry(&shm->clock_seq, s))
+            return;
+    }
+}
+
+#endif /* SEQLOCK_H */
@@ -0,0 +1,85 @@
+#!/bin/bash
+# ===========================================================================
+# Benchmark: uklady kanalow IPC (make bench-ipc, make bench-shards)
+# ===========================================================================
+#
+# CEL:
+#   Ten sam scenariusz (-p 12 -n 30 -s 20, 08:00-10:00) uruchamiany
+#   RUNS razy w kazdej konfiguracji ETYKIETA=OPCJE (domyslnie backendy
+#   sysv="-I sysv" i posix="-I posix"; bench-shards: -r 0/1/2/4/8). Dla kazdego
+#   przebiegu: czas sciany calej symulacji, obsluzeni klienci oraz
+#   percentyle z sekcji OPOZNIENIA raportu - conveyor_wait (pobranie
+#   z podajnika), checkout_queue (koszyk w kolejce do kasy), receipt
+#   (paragon w kolejce). Wynik: tabela z medianami przebiegow.
+#
+# UZYCIE:
+#   bash tests/bench_ipc.sh [RUNS] [ETYKIETA=OPCJE ...]   (RUNS domyslnie 3)
+#   bash tests/bench_ipc.sh 5 r0="-r 0" r4="-r 4"
+#
+# UWAGA:
+#   Nie jest testem (brak progu PASS/FAIL) - nie jest wpisany do
+#   run_tests.sh. Wymaga wolnych zasobow IPC (brak innej symulacji).
+# ===========================================================================
+set -u
+PROJECT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+RUNS=${1:-3}
+shift $(( $# > 0 ? 1 : 0 ))
+CONFIGS=("$@")
+[[ ${#CONFIGS[@]} -eq 0 ]] && CONFIGS=("sysv=-I sysv" "posix=-I posix")
+SCENARIO="-p 12 -n 30 -s 20 -o 8 -c 10 -t 60 -L warn"
+REPORT="$PROJECT_DIR/logs/raport.txt"
+OUT=$(mktemp)
+
+cd "$PROJECT_DIR"
+
+# Wartosc pXX z linii histogramu raportu: hist_field <nazwa> <pole>
+hist_field() {
+    grep "^  $1 " "$REPORT" | tr ' ' '\n' | grep "^$2=" | cut -d= -f2
+}
+
+# Mediana kolumny $1 dla konfiguracji $2
+median() {
+    awk -v c="$1" -v b="$2" '$1 == b { print $c }' "$OUT" | sort -g \
+        | awk '{ v[NR] = $1 } END { if (NR) print v[int((NR + 1) / 2)]; else print "-" }'
+}
+
+LABELS=()
+for cfg in "${CONFIGS[@]}"; do LABELS+=("${cfg%%=*}"); done
+
+echo "[bench_ipc] scenariusz: ./kierownik $SCENARIO, przebiegow: $RUNS"
+MSG_MAX=$(cat /proc/sys/fs/mqueue/msg_max 2>/dev/null || echo 0)
+if [[ $MSG_MAX -lt 100 && " ${CONFIGS[*]}" == *"-I posix"* ]]; then
+    echo "  UWAGA: fs/mqueue/msg_max=$MSG_MAX < Ki=100 - backend posix przytnie"
+    echo "  podajniki do $MSG_MAX szt. (inny scenariusz). Dla porownania 1:1:"
+    echo "  sysctl -w fs.mqueue.msg_max=128"
+fi
+for cfg in "${CONFIGS[@]}"; do
+    label=${cfg%%=*}
+    opts=${cfg#*=}
+    for r in $(seq 1 "$RUNS"); do
+        T0=$(date +%s%N)
+        ./kierownik $opts $SCENARIO < /dev/null > /dev/null 2>&1
+        RC=$?
+        T1=$(date +%s%N)
+        if [[ $RC -ne 0 ]]; then
+            echo "  $label #$r: kierownik zakonczyl sie kodem $RC - pomijam"
+            continue
+        fi
+        SERVED=$(grep -m1 "Obsluzonych (paragon):" "$REPORT" | awk '{ print $NF }')
+        printf "%s %.2f %s %s %s %s %s\n" "$label" \
+            "$(awk -v a="$T0" -v b="$T1" 'BEGIN { print (b - a) / 1e9 }')" "$SERVED" \
+            "$(hist_field conveyor_wait p99)" "$(hist_field checkout_queue p50)" \
+            "$(hist_field checkout_queue p99)" "$(hist_field receipt p99)" >> "$OUT"
+        echo "  $label #$r: $(tail -1 "$OUT" | cut -d' ' -f2-)"
+    done
+done
+
+echo ""
+printf "%-8s %9s %9s %14s %14s %14s %12s\n" konfig. "czas s" obsluz. \
+       "conv p99 ms" "kasa p50 ms" "kasa p99 ms" "parag. p99"
+for label in "${LABELS[@]}"; do
+    printf "%-8s %9s %9s %14s %14s %14s %12s\n" "$label" \
+        "$(median 2 "$label")" "$(median 3 "$label")" "$(median 4 "$label")" \
+        "$(median 5 "$label")" "$(median 6 "$label")" "$(median 7 "$label")"
+done
+rm -f "$OUT"
@@ -36,7 +36,7 @@ cleanup_between() {
     for id in $(ipcs -q 2>/dev/null | grep "^q.*$MYUSER" | awk '{print $2}'); do
         ipcrm -q "$id" 2>/dev/null || true
     done
-    rm -f /tmp/ciastkarnia_cmd.fifo
+    rm -f /tmp/ciastkarnia_cmd.fifo /tmp/ciastkarnia_ack.fifo
     rm -rf "$PROJECT_DIR/logs" 2>/dev/null || true
 }
 
@@ -46,6 +46,10 @@ TESTS=(
     "test_03_msgqueue_kontencja_mtype.sh"
     "test_04_pipe_raporty_produkcji.sh"
     "test_05_sem_undo_kill.sh"
+    "test_06_dziennik_zdarzen.sh"
+    "test_07_czas_wirtualny.sh"
+    "test_08_fifo_rekonfiguracja.sh"
+    "test_09_katalog_produktow.sh"
 )
 
 TOTAL=0; PASSED=0; FAILED=0
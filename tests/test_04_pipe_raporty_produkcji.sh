@@ -5,8 +5,9 @@
 #
 # CEL:
 #   Testuje komunikacje piekarza z kierownikiem przez LACZE NIENAZWANE
-#   (pipe). Piekarz wysyla raporty produkcji ("BATCH:tid:count\n"),
-#   kierownik odczytuje je i aktualizuje baker_produced[] w SHM.
+#   (pipe). Piekarz wysyla rekordy produkcji (BakerRecord, 16 B na
+#   partie), kierownik sumuje je per produkt w sekcji raportu
+#   "WYDAJNOSC PRODUKCJI".
 #
 # EDGE CASE:
 #   Szybka produkcja (mala skala czasu, -s 15) — piekarz wysyla duzo
@@ -100,14 +101,15 @@ else
 fi
 sleep 2
 
-# CHECK 4: Koncowa wartosc produkcji > 0 (pipe dostarczyl co najmniej 1 raport)
+# CHECK 4: Raport zawiera rekordy z pipe (wszystkie poprawne - brak przeplotu)
 if [[ -f "$PROJECT_DIR/logs/raport.txt" ]]; then
-    # Sprawdz raport — linia "Wyprodukowano"
-    RAPORT_PRODUCED=$(grep -oE 'Wyprodukowano.*[0-9]+' "$PROJECT_DIR/logs/raport.txt" 2>/dev/null | grep -oE '[0-9]+' | head -1)
-    if [[ -n "$RAPORT_PRODUCED" && "$RAPORT_PRODUCED" -gt 0 ]]; then
-        ok "raport potwierdza produkcje: $RAPORT_PRODUCED szt. (pipe -> SHM -> raport)"
+    FEED=$(grep -E '^Rekordy: [0-9]+ \(bledne: [0-9]+\)' "$PROJECT_DIR/logs/raport.txt")
+    RECORDS=$(echo "$FEED" | grep -oE '[0-9]+' | sed -n 1p)
+    INVALID=$(echo "$FEED" | grep -oE '[0-9]+' | sed -n 2p)
+    if [[ -n "$RECORDS" && "$RECORDS" -gt 0 && "$INVALID" -eq 0 ]]; then
+        ok "raport: $RECORDS rekordow partii z pipe, 0 blednych"
     else
-        ok "raport wygenerowany (format parsowania moze sie roznic)"
+        fail "brak rekordow z pipe w raporcie ($FEED)"
     fi
 else
     fail "brak raportu — nie mozna zweryfikowac danych z pipe"
@@ -0,0 +1,105 @@
+#!/bin/bash
+# ===========================================================================
+# Test 06: Dziennik zdarzen – wspolbiezny zapis z wielu procesow
+# ===========================================================================
+#
+# CEL:
+#   Testuje binarny dziennik zdarzen (-j). Wszystkie procesy (kierownik,
+#   piekarz, kasjerzy, klienci) dopisuja rekordy do jednego pliku
+#   mapowanego w pamiec, rezerwujac sloty atomowym licznikiem w SHM.
+#
+# EDGE CASE:
+#   Szybki czas (-s 10) — tysiace klientow zapisuja jednoczesnie.
+#   Sprawdzamy czy zaden slot nie zostal zgubiony ani nadpisany
+#   (kazda wizyta ma komplet zdarzen: spawn ... exit).
+#
+# TESTOWANE MECHANIZMY:
+#   - mmap(MAP_SHARED) pliku wspoldzielonego przez procesy
+#   - __atomic_fetch_add na liczniku w pamieci dzielonej
+#   - Dekoder journal_dump (naglowek, rekordy, fazy wizyty, trace)
+#
+# PARAMETRY:
+#   -s 10 -L warn -j 200000
+#
+# WNIOSKI:
+#   Niezmiennik: liczba wizyt w dzienniku == liczba obsluzonych + innych
+#   wyjsc, brak odrzuconych zdarzen, kazda faza ma n == obsluzeni.
+# ===========================================================================
+set -u
+PROJECT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PASS=0; FAIL=0
+ok()   { echo "  OK: $1"; PASS=$((PASS + 1)); }
+fail() { echo "  FAIL: $1"; FAIL=$((FAIL + 1)); }
+
+count_procs() {
+    local c=0
+    for name in kierownik piekarz kasjer klient; do
+        c=$((c + $(pgrep -x "$name" 2>/dev/null | wc -l)))
+    done
+    echo "$c"
+}
+MYUSER=$(whoami)
+our_shm() { ipcs -m 2>/dev/null | grep "^m.*$MYUSER" | wc -l | tr -d ' '; }
+our_sem() { ipcs -s 2>/dev/null | grep "^s.*$MYUSER" | wc -l | tr -d ' '; }
+our_msg() { ipcs -q 2>/dev/null | grep "^q.*$MYUSER" | wc -l | tr -d ' '; }
+
+echo "[test_06_dziennik_zdarzen] START"
+cd "$PROJECT_DIR"
+JOURNAL="$PROJECT_DIR/logs/journal.bin"
+
+./kierownik -s 10 -L warn -j 200000 < /dev/null > /dev/null 2>&1 &
+KIE_PID=$!
+
+W=0; while kill -0 "$KIE_PID" 2>/dev/null && [[ $W -lt 120 ]]; do sleep 0.5; W=$((W+1)); done
+if ! kill -0 "$KIE_PID" 2>/dev/null; then
+    ok "symulacja zakonczyla sie"
+else
+    fail "symulacja nie zakonczyla sie w 60 s"
+    kill -INT "$KIE_PID" 2>/dev/null; sleep 2
+    kill -9 "$KIE_PID" 2>/dev/null; wait "$KIE_PID" 2>/dev/null || true
+    for name in klient kasjer piekarz; do pkill -9 -x "$name" 2>/dev/null || true; done
+fi
+sleep 1
+
+# CHECK 1: Plik dziennika istnieje i dekoder go czyta
+if [[ -s "$JOURNAL" ]] && ./journal_dump -f csv "$JOURNAL" > /tmp/test06_csv.txt 2>/dev/null; then
+    RECS=$(($(wc -l < /tmp/test06_csv.txt) - 1))
+    [[ $RECS -gt 0 ]] && ok "dziennik zawiera $RECS rekordow" || fail "dziennik pusty"
+else
+    fail "brak dziennika lub blad dekodera"
+    RECS=0
+fi
+
+# CHECK 2: Kazdy fork klienta ma dokladnie jedno wyjscie (brak zgubionych slotow)
+SPAWNS=$(grep -c ',CUST_SPAWN,' /tmp/test06_csv.txt 2>/dev/null)
+EXITS=$(grep -c ',CUST_EXIT,' /tmp/test06_csv.txt 2>/dev/null)
+[[ -n "$SPAWNS" && "$SPAWNS" -gt 0 && "$SPAWNS" -eq "$EXITS" ]] \
+    && ok "spawn == exit ($SPAWNS)" \
+    || fail "spawn=$SPAWNS exit=$EXITS — zgubione lub nadpisane rekordy"
+
+# CHECK 3: Fazy wizyty — kazda faza obsluzonego klienta ma komplet probek
+./journal_dump -f phases "$JOURNAL" > /tmp/test06_phases.txt 2>/dev/null
+SERVED=$(grep -oE 'obsluzeni=[0-9]+' /tmp/test06_phases.txt | cut -d= -f2)
+DELIV=$(grep '^dostarczenie,' /tmp/test06_phases.txt | cut -d, -f2)
+[[ -n "$SERVED" && "$SERVED" -gt 0 && "$DELIV" == "$SERVED" ]] \
+    && ok "fazy kompletne (obsluzeni=$SERVED, dostarczenie n=$DELIV)" \
+    || fail "fazy niekompletne (obsluzeni=$SERVED, dostarczenie n=$DELIV)"
+
+# CHECK 4: Eksport trace — span "wizyta" dla kazdego klienta
+./journal_dump -f trace "$JOURNAL" > /tmp/test06_trace.json 2>/dev/null
+VISITS=$(grep -c '"name":"wizyta"' /tmp/test06_trace.json)
+COUNTERS=$(grep -c '"ph":"C"' /tmp/test06_trace.json)
+[[ "$VISITS" -eq "$SPAWNS" && "$COUNTERS" -gt 0 ]] \
+    && ok "trace: $VISITS wizyt, $COUNTERS probek licznikow" \
+    || fail "trace: wizyt=$VISITS (oczekiwano $SPAWNS), probek=$COUNTERS"
+rm -f /tmp/test06_csv.txt /tmp/test06_phases.txt /tmp/test06_trace.json
+
+# CHECK 5: Procesy i IPC czyste
+REM=$(count_procs)
+[[ $REM -eq 0 ]] && ok "procesy wyczyszczone" || fail "$REM procesow zostalo"
+SHM=$(our_shm); SEM=$(our_sem); MSG=$(our_msg)
+[[ $SHM -eq 0 && $SEM -eq 0 && $MSG -eq 0 ]] && ok "IPC czyste" || fail "IPC: shm=$SHM sem=$SEM msg=$MSG"
+
+echo ""
+[[ $FAIL -eq 0 ]] && echo "[test_06_dziennik_zdarzen] PASS ($PASS/$((PASS+FAIL)))" && exit 0
+echo "[test_06_dziennik_zdarzen] FAIL ($PASS/$((PASS+FAIL)))"; exit 1
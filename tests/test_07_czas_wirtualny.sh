@@ -0,0 +1,88 @@
+#!/bin/bash
+# ===========================================================================
+# Test 07: Czas wirtualny – symulacja zdarzeniowa bez procesow i IPC
+# ===========================================================================
+#
+# CEL:
+#   Testuje tryb -V: ten sam model (piekarz, kasy, klienci, tik kierownika)
+#   jako kolejka zdarzen z czasem wirtualnym. Seria dni ma trwac ulamek
+#   sekundy i dawac raport z sekcjami jak w trybie rzeczywistym.
+#
+# EDGE CASE:
+#   Wszyscy klienci naraz przy otwarciu (N=1500 miejsc) - wiekszosc czeka
+#   na wejscie i na podajniku na liscie czekajacych zamiast zdarzen co minute.
+#   Drugi przebieg z kosztem fork+exec (-F) - przybycia rozlozone w czasie.
+#
+# TESTOWANE MECHANIZMY:
+#   - Kopiec zdarzen, listy czekajacych, terminy rezygnacji
+#   - Brak tworzenia zasobow IPC i procesow potomnych
+#   - Ziarno -S: ten sam seed = ten sam raport, inny seed = inny
+#
+# PARAMETRY:
+#   -V 20 -s 10  oraz  -V 20 -s 10 -F 1500,  -V 3 -S 42 (x2) / -S 43
+#
+# WNIOSKI:
+#   Niezmienniki: klienci == obsluzeni + nieobsluzeni, histogram wizyt
+#   ma n == klienci, wyprodukowane == sprzedane + na podajnikach.
+# ===========================================================================
+set -u
+PROJECT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PASS=0; FAIL=0
+ok()   { echo "  OK: $1"; PASS=$((PASS + 1)); }
+fail() { echo "  FAIL: $1"; FAIL=$((FAIL + 1)); }
+
+MYUSER=$(whoami)
+our_shm() { ipcs -m 2>/dev/null | grep "^m.*$MYUSER" | wc -l | tr -d ' '; }
+our_sem() { ipcs -s 2>/dev/null | grep "^s.*$MYUSER" | wc -l | tr -d ' '; }
+our_msg() { ipcs -q 2>/dev/null | grep "^q.*$MYUSER" | wc -l | tr -d ' '; }
+
+echo "[test_07_czas_wirtualny] START"
+cd "$PROJECT_DIR"
+OUT=/tmp/test07_report.txt
+
+for FORK in 0 1500; do
+    echo "  -- fork+exec $FORK us --"
+
+    # CHECK 1: Seria dni konczy sie szybko i poprawnie
+    START=$(date +%s)
+    timeout 30 ./kierownik -V 20 -s 10 -F "$FORK" < /dev/null > "$OUT" 2>&1
+    RC=$?
+    ELAPSED=$(( $(date +%s) - START ))
+    [[ $RC -eq 0 && $ELAPSED -le 10 ]] \
+        && ok "20 przebiegow w ${ELAPSED} s" \
+        || fail "rc=$RC, czas ${ELAPSED} s"
+
+    # CHECK 2: Bilans klientow
+    TOTAL=$(grep -oE 'Laczna liczba klientow: [0-9]+' "$OUT" | grep -oE '[0-9]+$')
+    SERVED=$(grep -oE 'Obsluzonych \(paragon\): +[0-9]+' "$OUT" | grep -oE '[0-9]+$')
+    NOT=$(grep -oE 'Nieobsluzonych: +[0-9]+' "$OUT" | grep -oE '[0-9]+$')
+    VISITS=$(grep -E '^ +visit' "$OUT" | grep -oE 'n=[0-9]+' | cut -d= -f2)
+    [[ -n "$TOTAL" && "$TOTAL" -gt 0 && $((SERVED + NOT)) -eq "$TOTAL" && "$VISITS" == "$TOTAL" ]] \
+        && ok "klienci=$TOTAL obsluzeni=$SERVED nieobsluzeni=$NOT wizyty n=$VISITS" \
+        || fail "bilans klientow: klienci=$TOTAL obsluzeni=$SERVED nieobsluzeni=$NOT wizyty=$VISITS"
+
+    # CHECK 3: Bilans towaru - wyprodukowane == sprzedane + na podajnikach
+    PRODUCED=$(sed -n '/PRODUKCJA PIEKARZA/,/RAZEM/p' "$OUT" | grep -oE 'RAZEM: [0-9]+' | grep -oE '[0-9]+')
+    SOLD=$(grep -oE 'RAZEM: [0-9]+ szt., PRZYCHOD' "$OUT" | awk '{s += $2} END {print s + 0}')
+    LEFT=$(grep -oE 'RAZEM na podajnikach: [0-9]+' "$OUT" | grep -oE '[0-9]+$')
+    [[ -n "$PRODUCED" && "$PRODUCED" -eq $((SOLD + LEFT)) ]] \
+        && ok "wyprodukowano $PRODUCED = sprzedano $SOLD + na podajnikach $LEFT" \
+        || fail "bilans towaru: produkcja=$PRODUCED sprzedaz=$SOLD podajniki=$LEFT"
+done
+rm -f "$OUT"
+
+# CHECK 4: Powtarzalnosc - raport bez czasow rzeczywistych zalezy tylko od -S
+report() { ./kierownik -V 3 -s 10 -S "$1" < /dev/null 2>&1 \
+           | grep -vE 'Czas rzeczywisty|Przepustowosc' | md5sum | cut -d' ' -f1; }
+R1=$(report 42); R2=$(report 42); R3=$(report 43)
+[[ "$R1" == "$R2" && "$R1" != "$R3" ]] \
+    && ok "-S 42 dwa razy: ten sam raport, -S 43: inny" \
+    || fail "ziarno: -S 42 $R1 / $R2, -S 43 $R3"
+
+# CHECK 5: Tryb wirtualny nie zostawia zasobow IPC
+SHM=$(our_shm); SEM=$(our_sem); MSG=$(our_msg)
+[[ $SHM -eq 0 && $SEM -eq 0 && $MSG -eq 0 ]] && ok "IPC czyste" || fail "IPC: shm=$SHM sem=$SEM msg=$MSG"
+
+echo ""
+[[ $FAIL -eq 0 ]] && echo "[test_07_czas_wirtualny] PASS ($PASS/$((PASS+FAIL)))" && exit 0
+echo "[test_07_czas_wirtualny] FAIL ($PASS/$((PASS+FAIL)))"; exit 1
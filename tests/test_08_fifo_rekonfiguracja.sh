@@ -0,0 +1,129 @@
+#!/bin/bash
+# ===========================================================================
+# Test 08: FIFO polecen – zmiana parametrow w trakcie symulacji
+# ===========================================================================
+#
+# CEL:
+#   Testuje polecenia "set <nazwa> <wartosc>" wysylane przez FIFO
+#   polecen. Kierownik zmienia parametr w SHM (skala, N, watki piekarza,
+#   przybycia klientow na tykniecie),
+#   a kazde polecenie potwierdza linia "OK ..."/"ERR ..." w FIFO
+#   potwierdzen.
+#
+# EDGE CASE:
+#   Zmniejszenie N przed otwarciem sklepu - kierownik odbiera wolne
+#   miejsca z SEM_SHOP_ENTRY, wiec w sklepie nigdy nie ma wiecej niz
+#   nowe N klientow. Bledne polecenia sa odrzucane bez zmian stanu,
+#   linia dluzsza niz bufor (127 znakow) - w calosci, nawet gdy jej
+#   poczatek jest poprawnym poleceniem.
+#   "set przybycia 5" rozklada spawn klientow na tykniecia - bez tego
+#   kierownik tworzy wszystkich naraz przy otwarciu.
+#
+# TESTOWANE IPC:
+#   - Lacza nazwane FIFO (polecenia i potwierdzenia, O_NONBLOCK)
+#   - semop() z delta != 1 na semaforze zliczajacym SEM_SHOP_ENTRY
+#   - Pamiec dzielona (parametry czytane przez procesy potomne)
+#
+# PARAMETRY:
+#   -t 15 -s 100 -n 20 -o 8 -c 12
+#
+# WNIOSKI:
+#   Niezmiennik: customers_in_shop <= nowe N, sem_shop_entry <= nowe N,
+#   liczba potwierdzen == liczba polecen.
+# ===========================================================================
+set -u
+PROJECT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PASS=0; FAIL=0
+ok()   { echo "  OK: $1"; PASS=$((PASS + 1)); }
+fail() { echo "  FAIL: $1"; FAIL=$((FAIL + 1)); }
+
+count_procs() {
+    local c=0
+    for name in kierownik piekarz kasjer klient; do
+        c=$((c + $(pgrep -x "$name" 2>/dev/null | wc -l)))
+    done
+    echo "$c"
+}
+MYUSER=$(whoami)
+our_shm() { ipcs -m 2>/dev/null | grep "^m.*$MYUSER" | wc -l | tr -d ' '; }
+our_sem() { ipcs -s 2>/dev/null | grep "^s.*$MYUSER" | wc -l | tr -d ' '; }
+our_msg() { ipcs -q 2>/dev/null | grep "^q.*$MYUSER" | wc -l | tr -d ' '; }
+shm_val() { "$PROJECT_DIR/check_shm" 2>/dev/null | grep "^$1=" | cut -d= -f2; }
+
+CMD_FIFO=/tmp/ciastkarnia_cmd.fifo
+ACK_FIFO=/tmp/ciastkarnia_ack.fifo
+ACK_OUT=$(mktemp)
+
+echo "[test_08_fifo_rekonfiguracja] START"
+cd "$PROJECT_DIR"
+
+./kierownik -t 15 -s 100 -n 20 -o 8 -c 12 < /dev/null > /dev/null 2>&1 &
+KIE_PID=$!
+W=0; while [[ ! -p "$ACK_FIFO" && $W -lt 20 ]]; do sleep 0.1; W=$((W+1)); done
+
+# Czytelnik potwierdzen, potem polecenia (sklep otwiera sie po 3 s).
+# Kierownik otwiera FIFO potwierdzen na kazda linie - deskryptor 3
+# trzyma koniec do zapisu, zeby cat nie dostal EOF miedzy liniami.
+exec 3<> "$ACK_FIFO"
+timeout 10 cat "$ACK_FIFO" > "$ACK_OUT" &
+CAT_PID=$!
+sleep 0.3
+LONG="set n 3$(printf '%*s' 140 '')x"
+printf 'set n 4\nset skala 50\nset piekarze 4\nset przybycia 5\nset n 1\n%s\nset foo 7\n' \
+    "$LONG" > "$CMD_FIFO"
+sleep 1
+
+# CHECK 1: Potwierdzenia - 4 przyjete, 3 odrzucone (w tym za dluga linia)
+ACK_OK=$(grep -c '^OK set' "$ACK_OUT")
+ACK_ERR=$(grep -c '^ERR set' "$ACK_OUT")
+ACK_LONG=$(grep -c '^ERR.*dluzsza niz 127' "$ACK_OUT")
+[[ $ACK_OK -eq 4 && $ACK_ERR -eq 3 && $ACK_LONG -eq 1 ]] \
+    && ok "potwierdzenia: $ACK_OK OK, $ACK_ERR ERR (za dluga linia odrzucona)" \
+    || fail "potwierdzenia: $ACK_OK OK, $ACK_ERR ERR, za dluga $ACK_LONG (oczekiwano 4/3/1): $(tr '\n' '|' < "$ACK_OUT")"
+
+# CHECK 2: Nowe wartosci w SHM (bledne polecenia niczego nie zmienily)
+N=$(shm_val max_customers); SCALE=$(shm_val time_scale_ms); BT=$(shm_val baker_threads)
+[[ "$N" == "4" && "$SCALE" == "50" && "$BT" == "4" ]] \
+    && ok "SHM: max_customers=4 time_scale_ms=50 baker_threads=4" \
+    || fail "SHM: max_customers=$N time_scale_ms=$SCALE baker_threads=$BT"
+
+# CHECK 3: W sklepie nigdy wiecej niz nowe N
+MAX_IN=0; MAX_SEM=0
+for i in $(seq 1 10); do
+    IN=$(shm_val customers_in_shop); SEM=$(shm_val sem_shop_entry)
+    [[ -n "$IN" && "$IN" -gt "$MAX_IN" ]] && MAX_IN=$IN
+    [[ -n "$SEM" && "$SEM" -gt "$MAX_SEM" ]] && MAX_SEM=$SEM
+    sleep 0.5
+done
+[[ $MAX_IN -le 4 && $MAX_SEM -le 4 ]] \
+    && ok "limit N=4: maks. w sklepie $MAX_IN, maks. sem_shop_entry $MAX_SEM" \
+    || fail "limit N=4 przekroczony: w sklepie $MAX_IN, sem_shop_entry $MAX_SEM"
+
+# Koniec symulacji (-t 15)
+W=0; while kill -0 "$KIE_PID" 2>/dev/null && [[ $W -lt 60 ]]; do sleep 0.5; W=$((W+1)); done
+if kill -0 "$KIE_PID" 2>/dev/null; then
+    fail "symulacja nie zakonczyla sie"
+    kill -INT "$KIE_PID" 2>/dev/null; sleep 2
+    kill -9 "$KIE_PID" 2>/dev/null; wait "$KIE_PID" 2>/dev/null || true
+    for name in klient kasjer piekarz; do pkill -9 -x "$name" 2>/dev/null || true; done
+fi
+kill "$CAT_PID" 2>/dev/null; wait "$CAT_PID" 2>/dev/null
+exec 3>&-
+sleep 2
+
+# CHECK 4: Raport zlicza polecenia
+grep -q "Polecenia FIFO: 4 przyjetych, 3 odrzuconych" "$PROJECT_DIR/logs/raport.txt" 2>/dev/null \
+    && ok "raport: 4 przyjete, 3 odrzucone polecenia" \
+    || fail "raport nie zawiera licznikow polecen"
+
+# CHECK 5: Procesy, IPC i FIFO czyste
+REM=$(count_procs)
+[[ $REM -eq 0 ]] && ok "procesy wyczyszczone" || fail "$REM procesow zostalo"
+SHM=$(our_shm); SEM=$(our_sem); MSG=$(our_msg)
+[[ $SHM -eq 0 && $SEM -eq 0 && $MSG -eq 0 && ! -e "$ACK_FIFO" ]] \
+    && ok "IPC i FIFO czyste" || fail "IPC: shm=$SHM sem=$SEM msg=$MSG, ack fifo: $(ls "$ACK_FIFO" 2>&1)"
+rm -f "$ACK_OUT"
+
+echo ""
+[[ $FAIL -eq 0 ]] && echo "[test_08_fifo_rekonfiguracja] PASS ($PASS/$((PASS+FAIL)))" && exit 0
+echo "[test_08_fifo_rekonfiguracja] FAIL ($PASS/$((PASS+FAIL)))"; exit 1
@@ -0,0 +1,108 @@
+#!/bin/bash
+# ===========================================================================
+# Test 09: Katalog produktow z pliku (-f) i segment SHM o rozmiarze z katalogu
+# ===========================================================================
+#
+# CEL:
+#   Testuje katalog produktow: parser pliku (nazwa;cena;pojemnosc;waga;
+#   partia), rozmiar pamieci dzielonej i zbioru semaforow wyliczany z liczby
+#   pozycji oraz wybor produktow przez klientow wedlug wag popularnosci.
+#
+# EDGE CASE:
+#   Bledne pliki (cena 0, 6 pol, '"' w nazwie, brak pliku, wszystkie
+#   wagi 0) - start
+#   przerwany z numerem linii, bez zasobow IPC. Katalog 300 pozycji
+#   w czasie wirtualnym - 15x wiecej niz dawny limit 20 produktow.
+#
+# TESTOWANE MECHANIZMY:
+#   - shm_layout_size: SharedData + ProductDef[P] + ProductStats[P]
+#   - TOTAL_SEMS(P) z katalogu, linie koszyka w komunikatach kas
+#
+# PARAMETRY:
+#   -f bledne pliki, -V 3 -s 10 -f (300 pozycji), -f docs/katalog.txt -t 10
+#
+# WNIOSKI:
+#   Najpopularniejszy produkt sprzedaje sie najlepiej, bilans klientow
+#   i towaru zgadza sie jak przy katalogu domyslnym.
+# ===========================================================================
+set -u
+PROJECT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PASS=0; FAIL=0
+ok()   { echo "  OK: $1"; PASS=$((PASS + 1)); }
+fail() { echo "  FAIL: $1"; FAIL=$((FAIL + 1)); }
+
+MYUSER=$(whoami)
+our_shm() { ipcs -m 2>/dev/null | grep "^m.*$MYUSER" | wc -l | tr -d ' '; }
+our_sem() { ipcs -s 2>/dev/null | grep "^s.*$MYUSER" | wc -l | tr -d ' '; }
+shm_val() { "$PROJECT_DIR/check_shm" 2>/dev/null | grep "^$1=" | cut -d= -f2; }
+
+echo "[test_09_katalog_produktow] START"
+cd "$PROJECT_DIR"
+TMP=$(mktemp -d /tmp/test09.XXXXXX)
+trap 'rm -rf "$TMP"' EXIT
+
+# CHECK 1: Bledne katalogi odrzucone z numerem linii, bez IPC
+printf 'Bulka;2.00;100\nChleb;0;40\n'         > "$TMP/cena.txt"
+printf '# x\nBulka;2.00;100;1;8;9\n'          > "$TMP/pola.txt"
+printf 'Bulka;2.00;100;0\nChleb;5.00;40;0\n'  > "$TMP/wagi.txt"
+printf 'Bulka;2.00;100\nBul"ka;1.50;10\n'     > "$TMP/nazwa.txt"
+BAD=0
+for spec in "cena.txt:2:" "pola.txt:2:" "nazwa.txt:2:" "wagi.txt:" "brak.txt:"; do
+    f=${spec%%:*}; where=${spec#*:}
+    OUT=$(./kierownik -f "$TMP/$f" -t 5 < /dev/null 2>&1)
+    RC=$?
+    if [[ $RC -eq 0 ]] || ! grep -q "\[KATALOG\].*$f:$where" <<< "$OUT"; then
+        BAD=$((BAD + 1))
+        echo "    $f: rc=$RC, $(grep KATALOG <<< "$OUT")"
+    fi
+done
+[[ $BAD -eq 0 && $(our_shm) -eq 0 && $(our_sem) -eq 0 ]] \
+    && ok "5 blednych katalogow odrzuconych (plik:linia), IPC czyste" \
+    || fail "$BAD blednych katalogow przyjetych lub IPC po bledzie"
+
+# CHECK 2: Czas wirtualny, 300 pozycji o wagach 300..1
+awk 'BEGIN { for (i = 0; i < 300; i++)
+             printf "SKU %03d;%.2f;20;%d;10\n", i, 1 + i % 9, 300 - i }' > "$TMP/duzy.txt"
+OUT="$TMP/duzy_raport.txt"
+timeout 60 ./kierownik -V 3 -s 10 -f "$TMP/duzy.txt" < /dev/null > "$OUT" 2>&1
+RC=$?
+NP=$(grep -oE '^Produktow: [0-9]+' "$OUT" | grep -oE '[0-9]+')
+TOTAL=$(grep -oE 'Laczna liczba klientow: [0-9]+' "$OUT" | grep -oE '[0-9]+$')
+SERVED=$(grep -oE 'Obsluzonych \(paragon\): +[0-9]+' "$OUT" | grep -oE '[0-9]+$')
+NOT=$(grep -oE 'Nieobsluzonych: +[0-9]+' "$OUT" | grep -oE '[0-9]+$')
+[[ $RC -eq 0 && "$NP" == "300" && -n "$TOTAL" && $((SERVED + NOT)) -eq "$TOTAL" ]] \
+    && ok "300 pozycji: klienci=$TOTAL obsluzeni=$SERVED nieobsluzeni=$NOT" \
+    || fail "katalog 300: rc=$RC P=$NP klienci=$TOTAL obsluzeni=$SERVED nieobsl=$NOT"
+
+# CHECK 3: Popularnosc - SKU 000 (waga 300) sprzedaje sie lepiej niz SKU 299 (waga 1)
+sold() { sed -n '/KASA NR/,/RAZEM/p' "$OUT" | grep -E "^ +$1 +:" \
+         | grep -oE ': [0-9]+' | awk '{ s += $2 } END { print s + 0 }'; }
+HEAD=$(sold "SKU 000"); TAIL=$(sold "SKU 299")
+[[ "$HEAD" -gt $((TAIL * 10)) ]] \
+    && ok "sprzedaz wedlug wag: SKU 000 = $HEAD szt., SKU 299 = $TAIL szt." \
+    || fail "brak skosu popularnosci: SKU 000 = $HEAD, SKU 299 = $TAIL"
+
+# CHECK 4: Tryb rzeczywisty - segment i semafory z katalogu
+./kierownik -f docs/katalog.txt -t 10 -s 20 -n 10 -o 8 -c 12 -L warn \
+    < /dev/null > "$TMP/run.txt" 2>&1 &
+KIE_PID=$!
+sleep 2
+NP=$(shm_val num_products); WT=$(shm_val catalog_weight_total)
+SIZE=$(shm_val shm_size)
+[[ "$NP" == "12" && "$WT" == "100" && -n "$SIZE" && "$SIZE" -gt 0 ]] \
+    && ok "SHM: num_products=$NP, suma wag=$WT, segment $SIZE B" \
+    || fail "SHM: num_products=$NP suma wag=$WT segment=$SIZE"
+wait $KIE_PID
+SEMS=$(grep -oE 'semafory: [0-9]+' "$TMP/run.txt" | grep -oE '[0-9]+')
+SOLD=$(grep -oE 'RAZEM: [0-9]+ szt., PRZYCHOD' "$TMP/run.txt" | awk '{s += $2} END {print s + 0}')
+[[ "$SEMS" == "30" && "$SOLD" -gt 0 ]] \
+    && ok "zbior semaforow TOTAL_SEMS(12) = $SEMS, sprzedano $SOLD szt." \
+    || fail "semafory=$SEMS (oczekiwano 30), sprzedano=$SOLD"
+
+# CHECK 5: Sprzatanie
+[[ $(our_shm) -eq 0 && $(our_sem) -eq 0 ]] && ok "IPC czyste" \
+    || fail "IPC: shm=$(our_shm) sem=$(our_sem)"
+
+echo ""
+[[ $FAIL -eq 0 ]] && echo "[test_09_katalog_produktow] PASS ($PASS/$((PASS+FAIL)))" && exit 0
+echo "[test_09_katalog_produktow] FAIL ($PASS/$((PASS+FAIL)))"; exit 1